@@ -17,9 +17,12 @@
 */
 #ifndef KPUZZLE4__ALGORITHM_IDA__HPP
 #define KPUZZLE4__ALGORITHM_IDA__HPP
+#include <algorithm>
 #include <chrono>
-#include <stack>
+#include <cstddef>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include "SearchNode.hpp"
 #include "State.hpp"
 
@@ -51,6 +54,24 @@ class AlgorithmIDA {
    *  \return true if a solution has been found.
    *  \template HeuristicFn is a function type with signature: int(const
    *  State&).
+   *  \note If HeuristicFn has a method `void onNewIteration()`, it is
+   *  invoked before each iteration (i.e., every time the depth threshold
+   *  changes). The heuristic can change between iterations, as long as it
+   *  stays admissible.
+   *  \note If HeuristicFn can be invoked as `int(const State&, int iBound)`,
+   *  the search passes the cost it can afford from the node within the
+   *  current threshold: the heuristic can stop as soon as its cost is greater
+   *  than the bound (e.g., `HeuristicComposer`).
+   *  \note If HeuristicFn has the methods
+   *  `void prefetch(const State&, std::size_t iSlot)` and
+   *  `int getCostPrefetched(const State&, std::size_t iSlot, int iBound)`,
+   *  the first is invoked on all children of a node when it is expanded,
+   *  before the first of them is visited: the cache misses of the lookups of
+   *  the siblings overlap with the search of the first ones (e.g.,
+   *  `PatternDB::prefetch`). The second computes the cost of the child when it
+   *  is visited, with the same slot: the heuristic can keep there what it
+   *  computed to prefetch (e.g., the indices of the entries). A slot is given
+   *  to another child only after the previous one has been visited.
    */
   template <typename HeuristicFn>
   SolverResult_t findSolution(const State& iStartingState, HeuristicFn&& iHeuristicFn);
@@ -75,22 +96,95 @@ class AlgorithmIDA {
     return _solutionPath;
   }
 
+  /*! \brief Enables the bidirectional pathmax (BPMX): the heuristic costs of
+   *  the children are computed when a node is expanded, and the node (and its
+   *  children) inherit the largest of them minus one. It is worth only with
+   *  inconsistent heuristics (e.g., the dual lookup of a pattern database
+   *  instead of the regular one, where it is possible).
+   *  \note It is disabled by default.
+   */
+  void setBidirectionalPathMax(const bool iBidirectionalPathMax) noexcept {
+    _bidirectionalPathMax = iBidirectionalPathMax;
+  }
+
+  //! \return whether the bidirectional pathmax is enabled.
+  bool isBidirectionalPathMax() const noexcept {
+    return _bidirectionalPathMax;
+  }
+
  private:
   static_assert(kTotalDepthLimit <= SearchNode::kMaxPath);
 
+  //! \brief The heuristic cost of a node still to be computed.
+  static constexpr int kHeuristicCostUnknown = -1;
+
+  //! \brief The heuristic cost of a node still to be computed, already prefetched.
+  static constexpr int kHeuristicCostPrefetched = -2;
+
+  struct OpenNode_t {
+    SearchNode _node;
+    int _heuristicCost;
+  };
+
+  //! \brief The open list of the DFS exploration (used as stack).
+  using OpenList_t = std::vector<OpenNode_t>;
+
   int _maxCurrentDepth = 0;
+  bool _bidirectionalPathMax = false;
   long long _nodeExplored = 0ll;
   int _solutionLengthPath = 0;
   Path_t _solutionPath;
 
+  /*! \brief The open list is kept among searches so that its storage can be
+   *  reused when the same instance solves many problems.
+   */
+  OpenList_t _openList;
+
   template <typename HeuristicFn>
   bool limitedDepthSearch(const State& iStartingState, HeuristicFn&& iHeuristicFn);
+
+  //! \brief Whether the heuristic wants to be notified of a new iteration.
+  template <typename HeuristicFn, typename = void>
+  struct HasIterationHook : std::false_type {};
+
+  template <typename HeuristicFn>
+  struct HasIterationHook<HeuristicFn, std::void_t<decltype(std::declval<HeuristicFn&>().onNewIteration())>>
+      : std::true_type {};
+
+  //! \brief Whether the heuristic can stop beyond a bound.
+  template <typename HeuristicFn, typename = void>
+  struct HasBound : std::false_type {};
+
+  template <typename HeuristicFn>
+  struct HasBound<HeuristicFn,
+                  std::void_t<decltype(std::declval<HeuristicFn&>()(std::declval<const State&>(), int{}))>>
+      : std::true_type {};
+
+  //! \brief Whether the heuristic can prefetch the cost of a state.
+  template <typename HeuristicFn, typename = void>
+  struct HasPrefetch : std::false_type {};
+
+  template <typename HeuristicFn>
+  struct HasPrefetch<HeuristicFn,
+                     std::void_t<decltype(std::declval<HeuristicFn&>().prefetch(std::declval<const State&>(),
+                                                                                std::size_t{})),
+                                 decltype(std::declval<HeuristicFn&>().getCostPrefetched(
+                                     std::declval<const State&>(), std::size_t{}, int{}))>> : std::true_type {};
+
+  //! \return the heuristic cost of the state (bounded, if the heuristic supports it).
+  template <typename HeuristicFn>
+  static int computeHeuristicCost(HeuristicFn&& iHeuristicFn, const State& iState, const int iBound);
 };
 
 template <typename HeuristicFn>
 AlgorithmIDA::SolverResult_t AlgorithmIDA::findSolution(const State& iStartingState, HeuristicFn&& iHeuristicFn) {
+  constexpr bool kHasIterationHook = HasIterationHook<std::remove_reference_t<HeuristicFn>>::value;
   const auto aTimeStart = Clock_t::now();
 
+  if constexpr (kHasIterationHook) {
+    iHeuristicFn.onNewIteration();
+  }
+
   _maxCurrentDepth = iHeuristicFn(iStartingState);
   _nodeExplored = 0ll;
   _solutionLengthPath = 0;
@@ -101,6 +195,10 @@ AlgorithmIDA::SolverResult_t AlgorithmIDA::findSolution(const State& iStartingSt
 
     if (aSolutionFound == false) {
       _maxCurrentDepth += 2;
+
+      if constexpr (kHasIterationHook) {
+        iHeuristicFn.onNewIteration();
+      }
     }
   }
 
@@ -111,16 +209,17 @@ AlgorithmIDA::SolverResult_t AlgorithmIDA::findSolution(const State& iStartingSt
 
 template <typename HeuristicFn>
 bool AlgorithmIDA::limitedDepthSearch(const State& iStartingState, HeuristicFn&& iHeuristicFn) {
-  using OpenList = std::stack<SearchNode>;
   static constexpr State kFinalState = State::generateSortedState();
 
-  OpenList aOpenList;
-  aOpenList.emplace(iStartingState);
+  _openList.clear();
+  _openList.push_back({SearchNode{iStartingState}, kHeuristicCostUnknown});
 
-  while (!aOpenList.empty()) {
+  while (!_openList.empty()) {
     ++_nodeExplored;
-    const SearchNode aCurrentNode = std::move(aOpenList.top());
-    aOpenList.pop();
+    const std::size_t aSlot = _openList.size() - 1;
+    const OpenNode_t aCurrentOpenNode = std::move(_openList.back());
+    const SearchNode& aCurrentNode = aCurrentOpenNode._node;
+    _openList.pop_back();
 
     if (aCurrentNode.getState() == kFinalState) {
       _solutionLengthPath = aCurrentNode.getCounterPath();
@@ -128,25 +227,63 @@ bool AlgorithmIDA::limitedDepthSearch(const State& iStartingState, HeuristicFn&&
       return true;
     }
 
-    const int aHeuristicCost = iHeuristicFn(aCurrentNode.getState());
+    int aHeuristicCost = aCurrentOpenNode._heuristicCost;
+    if constexpr (HasPrefetch<std::remove_reference_t<HeuristicFn>>::value) {
+      if (aHeuristicCost == kHeuristicCostPrefetched) {
+        aHeuristicCost = static_cast<int>(iHeuristicFn.getCostPrefetched(
+            aCurrentNode.getState(), aSlot, _maxCurrentDepth - aCurrentNode.getCost2Here()));
+      }
+    }
+    if (aHeuristicCost == kHeuristicCostUnknown) {
+      aHeuristicCost = computeHeuristicCost(iHeuristicFn, aCurrentNode.getState(),
+                                            _maxCurrentDepth - aCurrentNode.getCost2Here());
+    }
     const int aCostHere = aCurrentNode.getCost2Here();
 
     if (aCostHere + aHeuristicCost <= _maxCurrentDepth) {
       const auto aLastMove = aCurrentNode.getLastMove();
+      const std::size_t aFirstChild = _openList.size();
 
       SearchNode aChildNode;
 
       if (aLastMove != SearchNode::Direction::RIGHT && aCurrentNode.moveLeft(&aChildNode) != -1) {
-        aOpenList.push(std::move(aChildNode));
+        _openList.push_back({std::move(aChildNode), kHeuristicCostUnknown});
       }
       if (aLastMove != SearchNode::Direction::LEFT && aCurrentNode.moveRight(&aChildNode) != -1) {
-        aOpenList.push(std::move(aChildNode));
+        _openList.push_back({std::move(aChildNode), kHeuristicCostUnknown});
       }
       if (aLastMove != SearchNode::Direction::UP && aCurrentNode.moveDown(&aChildNode) != -1) {
-        aOpenList.push(std::move(aChildNode));
+        _openList.push_back({std::move(aChildNode), kHeuristicCostUnknown});
       }
       if (aLastMove != SearchNode::Direction::DOWN && aCurrentNode.moveUp(&aChildNode) != -1) {
-        aOpenList.push(std::move(aChildNode));
+        _openList.push_back({std::move(aChildNode), kHeuristicCostUnknown});
+      }
+
+      if constexpr (HasPrefetch<std::remove_reference_t<HeuristicFn>>::value) {
+        if (!_bidirectionalPathMax) {
+          for (std::size_t i = aFirstChild; i < _openList.size(); ++i) {
+            iHeuristicFn.prefetch(_openList[i]._node.getState(), i);
+            _openList[i]._heuristicCost = kHeuristicCostPrefetched;
+          }
+        }
+      }
+
+      if (_bidirectionalPathMax) {
+        // Children -> parent: a child is at most one move away.
+        for (std::size_t i = aFirstChild; i < _openList.size(); ++i) {
+          _openList[i]._heuristicCost =
+              computeHeuristicCost(iHeuristicFn, _openList[i]._node.getState(), _maxCurrentDepth - aCostHere - 1);
+          aHeuristicCost = std::max(aHeuristicCost, _openList[i]._heuristicCost - 1);
+        }
+
+        if (aCostHere + aHeuristicCost > _maxCurrentDepth) {
+          _openList.resize(aFirstChild);
+        } else {
+          // Parent -> children.
+          for (std::size_t i = aFirstChild; i < _openList.size(); ++i) {
+            _openList[i]._heuristicCost = std::max(_openList[i]._heuristicCost, aHeuristicCost - 1);
+          }
+        }
       }
     }
   }
@@ -154,7 +291,16 @@ bool AlgorithmIDA::limitedDepthSearch(const State& iStartingState, HeuristicFn&&
   return false;
 }
 
-AlgorithmIDA::SolverResult_t::SolverResult_t(bool iSolutionFound, Duration_t iTimeElapsed)
+template <typename HeuristicFn>
+int AlgorithmIDA::computeHeuristicCost(HeuristicFn&& iHeuristicFn, const State& iState, const int iBound) {
+  if constexpr (HasBound<std::remove_reference_t<HeuristicFn>>::value) {
+    return static_cast<int>(iHeuristicFn(iState, iBound));
+  } else {
+    return static_cast<int>(iHeuristicFn(iState));
+  }
+}
+
+inline AlgorithmIDA::SolverResult_t::SolverResult_t(bool iSolutionFound, Duration_t iTimeElapsed)
     : _solutionFound(iSolutionFound), _timeElapsed(std::move(iTimeElapsed)) {}
 
 }  // namespace kpuzzle4
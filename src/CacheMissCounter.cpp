@@ -0,0 +1,88 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "CacheMissCounter.hpp"
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace kpuzzle4 {
+
+#ifdef __linux__
+
+CacheMissCounter::CacheMissCounter() noexcept {
+  perf_event_attr aAttributes;
+  std::memset(&aAttributes, 0, sizeof(aAttributes));
+  aAttributes.size = sizeof(aAttributes);
+  aAttributes.type = PERF_TYPE_HARDWARE;
+  aAttributes.config = PERF_COUNT_HW_CACHE_MISSES;
+  aAttributes.disabled = 1;
+  aAttributes.exclude_kernel = 1;
+  aAttributes.exclude_hv = 1;
+
+  // The calling thread, on any CPU.
+  _fileDescriptor = static_cast<int>(::syscall(SYS_perf_event_open, &aAttributes, 0, -1, -1, 0));
+}
+
+CacheMissCounter::~CacheMissCounter() {
+  if (_fileDescriptor != -1) {
+    ::close(_fileDescriptor);
+  }
+}
+
+void CacheMissCounter::start() noexcept {
+  if (_fileDescriptor == -1) return;
+  ::ioctl(_fileDescriptor, PERF_EVENT_IOC_RESET, 0);
+  ::ioctl(_fileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void CacheMissCounter::stop() noexcept {
+  if (_fileDescriptor == -1) return;
+  ::ioctl(_fileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+}
+
+long long CacheMissCounter::getCount() const noexcept {
+  if (_fileDescriptor == -1) return -1;
+
+  std::uint64_t aCount = 0;
+  if (::read(_fileDescriptor, &aCount, sizeof(aCount)) != sizeof(aCount)) return -1;
+  return static_cast<long long>(aCount);
+}
+
+#else
+
+CacheMissCounter::CacheMissCounter() noexcept = default;
+
+CacheMissCounter::~CacheMissCounter() = default;
+
+void CacheMissCounter::start() noexcept {}
+
+void CacheMissCounter::stop() noexcept {}
+
+long long CacheMissCounter::getCount() const noexcept {
+  return -1;
+}
+
+#endif
+
+}  // namespace kpuzzle4
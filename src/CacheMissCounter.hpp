@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__CACHE_MISS_COUNTER__HPP
+#define KPUZZLE4__CACHE_MISS_COUNTER__HPP
+
+namespace kpuzzle4 {
+
+/*! \brief Hardware counter of the cache misses (last level) of the calling
+ *  thread, to measure the memory behaviour of the search.
+ *  \note It is available only on Linux, when the kernel and the CPU expose the
+ *  hardware counters (usually not in virtual machines or containers); otherwise
+ *  it counts nothing.
+ */
+class CacheMissCounter {
+ public:
+  //! \brief Opens the counter of the calling thread (stopped).
+  CacheMissCounter() noexcept;
+
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+  ~CacheMissCounter();
+
+  //! \return whether the hardware counter is available.
+  bool isAvailable() const noexcept {
+    return _fileDescriptor != -1;
+  }
+
+  //! \brief Resets and starts the counter.
+  void start() noexcept;
+
+  //! \brief Stops the counter.
+  void stop() noexcept;
+
+  //! \return the cache misses counted while started (-1 when it is not available).
+  long long getCount() const noexcept;
+
+ private:
+  int _fileDescriptor = -1;
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__CACHE_MISS_COUNTER__HPP
@@ -0,0 +1,149 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "Crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define KPUZZLE4_CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+#define KPUZZLE4_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+namespace kpuzzle4 {
+
+namespace {
+
+//! \brief The reflected polynomial of CRC32C.
+constexpr std::uint32_t kPolynomial = 0x82F63B78;
+
+using CrcTables_t = std::array<std::array<std::uint32_t, 256>, 8>;
+
+/*! \return the tables of the slicing-by-8: the i-th table is the checksum of a
+ *  byte followed by i zero bytes.
+ */
+constexpr CrcTables_t generateCrcTables() noexcept {
+  CrcTables_t aTables = {};
+  for (std::uint32_t aByte = 0; aByte < 256; ++aByte) {
+    std::uint32_t aCrc = aByte;
+    for (int aBit = 0; aBit < 8; ++aBit) {
+      aCrc = (aCrc >> 1) ^ ((aCrc & 1) ? kPolynomial : 0);
+    }
+    aTables[0][aByte] = aCrc;
+  }
+  for (std::size_t i = 1; i < aTables.size(); ++i) {
+    for (std::uint32_t aByte = 0; aByte < 256; ++aByte) {
+      const std::uint32_t aCrc = aTables[i - 1][aByte];
+      aTables[i][aByte] = (aCrc >> 8) ^ aTables[0][aCrc & 0xFF];
+    }
+  }
+  return aTables;
+}
+
+constexpr CrcTables_t kCrcTables = generateCrcTables();
+
+#ifdef KPUZZLE4_CRC32C_SSE42
+
+__attribute__((target("sse4.2"))) std::uint32_t computeSse42(const unsigned char* iData,
+                                                             std::size_t iSize,
+                                                             std::uint32_t iCrc) noexcept {
+  std::uint64_t aCrc = iCrc;
+  for (; iSize >= sizeof(std::uint64_t); iSize -= sizeof(std::uint64_t), iData += sizeof(std::uint64_t)) {
+    std::uint64_t aWord;
+    std::memcpy(&aWord, iData, sizeof(aWord));
+    aCrc = _mm_crc32_u64(aCrc, aWord);
+  }
+  std::uint32_t aCrcTail = static_cast<std::uint32_t>(aCrc);
+  for (; iSize > 0; --iSize, ++iData) {
+    aCrcTail = _mm_crc32_u8(aCrcTail, *iData);
+  }
+  return aCrcTail;
+}
+
+#endif
+
+using Compute_t = std::uint32_t (*)(const void*, const std::size_t, const std::uint32_t) noexcept;
+
+//! \return the best kernel supported by the CPU.
+Compute_t selectCompute() noexcept {
+  return Crc32c::isHardwareSupported() ? &Crc32c::computeHardware : &Crc32c::computeScalar;
+}
+
+}  // anonymous namespace
+
+std::uint32_t Crc32c::compute(const void* iData, const std::size_t iSize, const std::uint32_t iCrc) noexcept {
+  static const Compute_t sCompute = selectCompute();
+  return sCompute(iData, iSize, iCrc);
+}
+
+std::uint32_t Crc32c::computeScalar(const void* iData, const std::size_t iSize, const std::uint32_t iCrc) noexcept {
+  const unsigned char* aData = static_cast<const unsigned char*>(iData);
+  std::size_t aSize = iSize;
+  std::uint32_t aCrc = ~iCrc;
+
+  // The bytes are taken in the order of the file, whatever the byte order of the CPU.
+  for (; aSize >= 8; aSize -= 8, aData += 8) {
+    const std::uint32_t aLow = aCrc ^ (static_cast<std::uint32_t>(aData[0]) | static_cast<std::uint32_t>(aData[1]) << 8 |
+                                       static_cast<std::uint32_t>(aData[2]) << 16 |
+                                       static_cast<std::uint32_t>(aData[3]) << 24);
+    aCrc = kCrcTables[7][aLow & 0xFF] ^ kCrcTables[6][(aLow >> 8) & 0xFF] ^ kCrcTables[5][(aLow >> 16) & 0xFF] ^
+           kCrcTables[4][aLow >> 24] ^ kCrcTables[3][aData[4]] ^ kCrcTables[2][aData[5]] ^ kCrcTables[1][aData[6]] ^
+           kCrcTables[0][aData[7]];
+  }
+  for (; aSize > 0; --aSize, ++aData) {
+    aCrc = (aCrc >> 8) ^ kCrcTables[0][(aCrc ^ *aData) & 0xFF];
+  }
+
+  return ~aCrc;
+}
+
+std::uint32_t Crc32c::computeHardware(const void* iData, const std::size_t iSize, const std::uint32_t iCrc) noexcept {
+#if defined(KPUZZLE4_CRC32C_SSE42)
+  return ~computeSse42(static_cast<const unsigned char*>(iData), iSize, ~iCrc);
+#elif defined(KPUZZLE4_CRC32C_ARM)
+  const unsigned char* aData = static_cast<const unsigned char*>(iData);
+  std::size_t aSize = iSize;
+  std::uint32_t aCrc = ~iCrc;
+  for (; aSize >= sizeof(std::uint64_t); aSize -= sizeof(std::uint64_t), aData += sizeof(std::uint64_t)) {
+    std::uint64_t aWord;
+    std::memcpy(&aWord, aData, sizeof(aWord));
+    aCrc = __crc32cd(aCrc, aWord);
+  }
+  for (; aSize > 0; --aSize, ++aData) {
+    aCrc = __crc32cb(aCrc, *aData);
+  }
+  return ~aCrc;
+#else
+  return computeScalar(iData, iSize, iCrc);
+#endif
+}
+
+bool Crc32c::isHardwareSupported() noexcept {
+#if defined(KPUZZLE4_CRC32C_SSE42)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+#elif defined(KPUZZLE4_CRC32C_ARM)
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace kpuzzle4
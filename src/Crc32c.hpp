@@ -0,0 +1,55 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__CRC32C__HPP
+#define KPUZZLE4__CRC32C__HPP
+#include <cstddef>
+#include <cstdint>
+
+namespace kpuzzle4 {
+
+/*! \brief The CRC32C (Castagnoli) checksum, to detect corrupted files.
+ *  The checksum of a sequence of bytes can be computed in pieces: the checksum
+ *  of the previous bytes is given to continue it.
+ */
+class Crc32c {
+ public:
+  /*! \brief It computes the checksum of the bytes.
+   *  \param [in] iCrc    The checksum of the bytes before them (if any).
+   *  \note It uses the CRC32 instructions when the CPU supports them,
+   *  otherwise the scalar kernel. Both give the same result.
+   */
+  static std::uint32_t compute(const void* iData, const std::size_t iSize, const std::uint32_t iCrc = 0) noexcept;
+
+  //! \brief Scalar kernel: eight lookups in tables for each 8 bytes (slicing-by-8).
+  static std::uint32_t computeScalar(const void* iData, const std::size_t iSize, const std::uint32_t iCrc = 0) noexcept;
+
+  /*! \brief Hardware kernel: the CRC32 instruction on 8 bytes at a time
+   *  (SSE 4.2 on x86, CRC on ARMv8).
+   *  \note It can be called only when `isHardwareSupported()`.
+   */
+  static std::uint32_t computeHardware(const void* iData,
+                                       const std::size_t iSize,
+                                       const std::uint32_t iCrc = 0) noexcept;
+
+  //! \return whether the CPU supports the hardware kernel.
+  static bool isHardwareSupported() noexcept;
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__CRC32C__HPP
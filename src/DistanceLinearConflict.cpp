@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "DistanceLinearConflict.hpp"
+#include <algorithm>
+#include <memory>
+#include "DistanceManhattan.hpp"
+
+namespace kpuzzle4 {
+
+DistanceLinearConflict::Cost_t DistanceLinearConflict::computeDistanceWithFinal(const State& iState) noexcept {
+  return DistanceManhattan::computeDistanceWithFinal(iState) + computeConflictsWithFinal(iState);
+}
+
+DistanceLinearConflict::Cost_t DistanceLinearConflict::computeConflictsWithFinal(const State& iState) noexcept {
+  const ConflictTables_t& aTables = getConflictTables();
+  const State::StateConfiguration_t aConfiguration = iState.getStateConfiguration();
+
+  Cost_t aCost = 0;
+  for (int i = 0; i < State::kSize; ++i) {
+    aCost += aTables._rows[i][(aConfiguration >> (i << 4)) & 0xFFFF];
+    aCost += aTables._columns[i][getColumn(aConfiguration, i)];
+  }
+
+  return aCost;
+}
+
+const DistanceLinearConflict::ConflictTables_t& DistanceLinearConflict::getConflictTables() noexcept {
+  static const auto sTables = []() {
+    auto aTables = std::make_unique<ConflictTables_t>();
+    for (int aIndexLine = 0; aIndexLine < State::kSize; ++aIndexLine) {
+      for (int aLine = 0; aLine < kSizeLineTable; ++aLine) {
+        aTables->_rows[aIndexLine][aLine] = computeLineConflicts(aLine, aIndexLine, true);
+        aTables->_columns[aIndexLine][aLine] = computeLineConflicts(aLine, aIndexLine, false);
+      }
+    }
+    return aTables;
+  }();
+
+  return *sTables;
+}
+
+int DistanceLinearConflict::computeLineConflicts(const int iLine, const int iIndexLine, const bool iIsRow) noexcept {
+  // Goal offsets (along the line) of the tiles whose goal is in the line.
+  std::array<int, State::kSize> aGoalOffsets;
+  int aNumTilesInGoalLine = 0;
+
+  for (int i = 0; i < State::kSize; ++i) {
+    const int aTile = (iLine >> (i << 2)) & 0xF;
+    if (aTile == 0) continue;
+
+    const int aGoalPosition = aTile - 1;
+    const int aGoalRow = aGoalPosition / State::kSize;
+    const int aGoalColumn = aGoalPosition % State::kSize;
+    if ((iIsRow ? aGoalRow : aGoalColumn) == iIndexLine) {
+      aGoalOffsets[aNumTilesInGoalLine++] = iIsRow ? aGoalColumn : aGoalRow;
+    }
+  }
+
+  // The tiles which are not in the longest increasing subsequence have to
+  // leave the line (two extra moves each).
+  std::array<int, State::kSize> aLongestIncreasing;
+  int aLongestIncreasingMax = 0;
+  for (int i = 0; i < aNumTilesInGoalLine; ++i) {
+    aLongestIncreasing[i] = 1;
+    for (int j = 0; j < i; ++j) {
+      if (aGoalOffsets[j] < aGoalOffsets[i]) {
+        aLongestIncreasing[i] = std::max(aLongestIncreasing[i], aLongestIncreasing[j] + 1);
+      }
+    }
+    aLongestIncreasingMax = std::max(aLongestIncreasingMax, aLongestIncreasing[i]);
+  }
+
+  return 2 * (aNumTilesInGoalLine - aLongestIncreasingMax);
+}
+
+}  // namespace kpuzzle4
@@ -0,0 +1,79 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__DISTANCE_LINEAR_CONFLICT__HPP
+#define KPUZZLE4__DISTANCE_LINEAR_CONFLICT__HPP
+#include <array>
+#include <cstdint>
+#include "SearchNode.hpp"
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief Manhattan distance plus the linear conflicts penalty.
+ *  Two tiles are in linear conflict when they are in their goal row (column)
+ *  but in the wrong order: one of them has to leave the line and come back,
+ *  costing two extra moves.
+ *  The penalty of each line only depends on the four tiles in it, so it is
+ *  precomputed in a table indexed by the four nibbles of the line.
+ */
+class DistanceLinearConflict {
+ public:
+  using Cost_t = SearchNode::Cost_t;
+
+  //! \brief It computes the heuristic cost towards the final state.
+  static Cost_t computeDistanceWithFinal(const State& iState) noexcept;
+
+  //! \brief It computes only the linear conflicts penalty towards the final state.
+  static Cost_t computeConflictsWithFinal(const State& iState) noexcept;
+
+ protected:
+  static constexpr int kSizeLineTable = 1 << (State::kSize * 4);
+
+  //! \brief Penalty of a line indexed by its four tiles (one per nibble).
+  using LineTable_t = std::array<std::uint8_t, kSizeLineTable>;
+
+  struct ConflictTables_t {
+    std::array<LineTable_t, State::kSize> _rows;
+    std::array<LineTable_t, State::kSize> _columns;
+  };
+
+  //! \return the tables (they are generated the first time).
+  static const ConflictTables_t& getConflictTables() noexcept;
+
+  /*! \brief Computes the penalty of a line.
+   *  \param [in] iLine       The four tiles of the line (one per nibble, the
+   *                          first tile in the least significant nibble).
+   *  \param [in] iIndexLine  The index of the row (column).
+   *  \param [in] iIsRow      Whether the line is a row or a column.
+   */
+  static int computeLineConflicts(const int iLine, const int iIndexLine, const bool iIsRow) noexcept;
+
+  //! \return the four tiles of a column (one per nibble).
+  static constexpr int getColumn(const State::StateConfiguration_t iConfiguration, const int iIndexColumn) noexcept;
+};
+
+constexpr int DistanceLinearConflict::getColumn(const State::StateConfiguration_t iConfiguration,
+                                                const int iIndexColumn) noexcept {
+  const State::StateConfiguration_t aShifted = iConfiguration >> (iIndexColumn << 2);
+  return static_cast<int>((aShifted & 0xF) | ((aShifted >> 12) & 0xF0) | ((aShifted >> 24) & 0xF00) |
+                          ((aShifted >> 36) & 0xF000));
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__DISTANCE_LINEAR_CONFLICT__HPP
@@ -16,40 +16,116 @@
 
 */
 #include "DistanceManhattan.hpp"
-#include <cmath>
+#include <array>
+#include <cstdint>
 #include <type_traits>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KPUZZLE4_MANHATTAN_SIMD
+#include <immintrin.h>
+#endif
+
 namespace kpuzzle4 {
 
-DistanceManhattan::Cost_t DistanceManhattan::computeDistance(const State& iStateA, const State& iStateB) noexcept {
-  static_assert(std::is_arithmetic_v<Cost_t>);
+namespace {
 
-  Cost_t aCost = 0;
+using DistanceTable_t = std::array<std::array<std::uint8_t, State::kNumTiles>, State::kNumTiles>;
+
+//! \return the table of the Manhattan distances between two positions.
+constexpr DistanceTable_t generateDistanceTable() noexcept {
+  DistanceTable_t aTable = {};
+  for (int i = 0; i < State::kNumTiles; ++i) {
+    for (int j = 0; j < State::kNumTiles; ++j) {
+      const int aValueX = i / State::kSize - j / State::kSize;
+      const int aValueY = i % State::kSize - j % State::kSize;
+      aTable[i][j] = static_cast<std::uint8_t>((aValueX < 0 ? -aValueX : aValueX) + (aValueY < 0 ? -aValueY : aValueY));
+    }
+  }
+  return aTable;
+}
 
-  for (int i = State::kNumTilesMinusOne; i >= 0; --i) {
-    const std::uint64_t aPosTimes4 = i << 2;
-    const int aStateATile = (iStateA.getStateConfiguration() >> aPosTimes4) & 0xF;
-    const int aStateBTile = (iStateB.getStateConfiguration() >> aPosTimes4) & 0xF;
+constexpr DistanceTable_t kDistanceTable = generateDistanceTable();
 
-    if (aStateATile != 0 && aStateATile != aStateBTile) {
-      const int aStateAPosition = (iStateA.getTilesPositions() >> (aStateATile << 2)) & 0xF;
-      const int aStateBPosition = (iStateB.getTilesPositions() >> (aStateATile << 2)) & 0xF;
+#ifdef KPUZZLE4_MANHATTAN_SIMD
 
-      const int aStateAX = aStateAPosition / State::kSize;
-      const int aStateBX = aStateBPosition / State::kSize;
-      const int aStateAY = aStateAPosition % State::kSize;
-      const int aStateBY = aStateBPosition % State::kSize;
+//! \return the 16 nibbles of the word unpacked in 16 bytes (nibble i in byte i).
+__attribute__((target("ssse3"))) inline __m128i unpackNibbles(const std::uint64_t iWord) noexcept {
+  const __m128i aMaskNibble = _mm_set1_epi8(0xF);
+  const __m128i aWord = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&iWord));
+  const __m128i aLowNibbles = _mm_and_si128(aWord, aMaskNibble);
+  const __m128i aHighNibbles = _mm_and_si128(_mm_srli_epi16(aWord, 4), aMaskNibble);
+  return _mm_unpacklo_epi8(aLowNibbles, aHighNibbles);
+}
 
-      const int aValueX = std::abs(aStateAX - aStateBX);
-      const int aValueY = std::abs(aStateAY - aStateBY);
+__attribute__((target("ssse3"))) DistanceManhattan::Cost_t computeDistanceSsse3(const std::uint64_t iPositionsA,
+                                                                                const std::uint64_t iPositionsB) noexcept {
+  const __m128i kRows = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+  const __m128i kColumns = _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
 
-      aCost += (aValueX + aValueY);
-    }
+  // The lane 0 is the empty tile: it does not count.
+  const __m128i aMaskTiles = _mm_setr_epi8(0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i aPositionsA = _mm_and_si128(unpackNibbles(iPositionsA), aMaskTiles);
+  const __m128i aPositionsB = _mm_and_si128(unpackNibbles(iPositionsB), aMaskTiles);
+
+  const __m128i aSumRows = _mm_sad_epu8(_mm_shuffle_epi8(kRows, aPositionsA), _mm_shuffle_epi8(kRows, aPositionsB));
+  const __m128i aSumColumns =
+      _mm_sad_epu8(_mm_shuffle_epi8(kColumns, aPositionsA), _mm_shuffle_epi8(kColumns, aPositionsB));
+  const __m128i aSum = _mm_add_epi64(aSumRows, aSumColumns);
+
+  return static_cast<DistanceManhattan::Cost_t>(_mm_cvtsi128_si32(aSum) + _mm_extract_epi16(aSum, 4));
+}
+
+#endif
+
+using ComputeDistance_t = DistanceManhattan::Cost_t (*)(const State&, const State&) noexcept;
+
+//! \return the best kernel supported by the CPU.
+ComputeDistance_t selectComputeDistance() noexcept {
+  return DistanceManhattan::isSimdSupported() ? &DistanceManhattan::computeDistanceSimd
+                                               : &DistanceManhattan::computeDistanceScalar;
+}
+
+}  // anonymous namespace
+
+DistanceManhattan::Cost_t DistanceManhattan::computeDistance(const State& iStateA, const State& iStateB) noexcept {
+  static const ComputeDistance_t sComputeDistance = selectComputeDistance();
+  return sComputeDistance(iStateA, iStateB);
+}
+
+DistanceManhattan::Cost_t DistanceManhattan::computeDistanceScalar(const State& iStateA,
+                                                                   const State& iStateB) noexcept {
+  static_assert(std::is_arithmetic_v<Cost_t>);
+
+  Cost_t aCost = 0;
+
+  for (int aTile = State::kNumTilesMinusOne; aTile > 0; --aTile) {
+    const int aTileTimes4 = aTile << 2;
+    const int aStateAPosition = (iStateA.getTilesPositions() >> aTileTimes4) & 0xF;
+    const int aStateBPosition = (iStateB.getTilesPositions() >> aTileTimes4) & 0xF;
+
+    aCost += kDistanceTable[aStateAPosition][aStateBPosition];
   }
 
   return aCost;
 }
 
+DistanceManhattan::Cost_t DistanceManhattan::computeDistanceSimd(const State& iStateA, const State& iStateB) noexcept {
+#ifdef KPUZZLE4_MANHATTAN_SIMD
+  return computeDistanceSsse3(iStateA.getTilesPositions(), iStateB.getTilesPositions());
+#else
+  return computeDistanceScalar(iStateA, iStateB);
+#endif
+}
+
+bool DistanceManhattan::isSimdSupported() noexcept {
+#ifdef KPUZZLE4_MANHATTAN_SIMD
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+#else
+  return false;
+#endif
+}
+
 DistanceManhattan::Cost_t DistanceManhattan::computeDistanceWithFinal(const State& iState) noexcept {
   return computeDistance(iState, kFinalState);
 }
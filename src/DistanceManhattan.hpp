@@ -27,9 +27,24 @@ class DistanceManhattan {
   using Cost_t = SearchNode::Cost_t;
   static constexpr State kFinalState = State::generateSortedState();
 
-  //! \brief It computes the heuristic cost from two states.
+  /*! \brief It computes the heuristic cost from two states.
+   *  \note It uses the SIMD kernel when the CPU supports it, otherwise the
+   *  scalar one. Both give the same result.
+   */
   static Cost_t computeDistance(const State& iStateA, const State& iStateB) noexcept;
 
+  //! \brief Scalar kernel: a lookup in a table of distances for each tile.
+  static Cost_t computeDistanceScalar(const State& iStateA, const State& iStateB) noexcept;
+
+  /*! \brief SIMD kernel: the positions of the tiles are unpacked in 16 byte
+   *  lanes, rows and columns are looked up with byte shuffles (SSSE3).
+   *  \note It can be called only when `isSimdSupported()`.
+   */
+  static Cost_t computeDistanceSimd(const State& iStateA, const State& iStateB) noexcept;
+
+  //! \return whether the CPU supports the SIMD kernel.
+  static bool isSimdSupported() noexcept;
+
   //! \brief It computes the heuristic cost towards the final state.
   static Cost_t computeDistanceWithFinal(const State& iState) noexcept;
 };
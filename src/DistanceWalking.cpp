@@ -0,0 +1,197 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "DistanceWalking.hpp"
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace kpuzzle4 {
+
+DistanceWalking::Cost_t DistanceWalking::computeDistanceWithFinal(const State& iState) noexcept {
+  return computeRowsDistanceWithFinal(iState) + computeColumnsDistanceWithFinal(iState);
+}
+
+DistanceWalking::Cost_t DistanceWalking::computeRowsDistanceWithFinal(const State& iState) noexcept {
+  const WalkTables_t& aTables = getWalkTables();
+  const State::StateConfiguration_t aConfiguration = iState.getStateConfiguration();
+
+  const int aIndex = computeIndex(iState.getIndexSpace() / State::kSize,
+                                  aTables._rowCodes[aConfiguration & 0xFFFF],
+                                  aTables._rowCodes[(aConfiguration >> 16) & 0xFFFF],
+                                  aTables._rowCodes[(aConfiguration >> 32) & 0xFFFF]);
+  return aTables._distances[aIndex];
+}
+
+DistanceWalking::Cost_t DistanceWalking::computeColumnsDistanceWithFinal(const State& iState) noexcept {
+  const WalkTables_t& aTables = getWalkTables();
+  const State::StateConfiguration_t aConfiguration = iState.getStateConfiguration();
+
+  const int aIndex = computeIndex(iState.getIndexSpace() % State::kSize,
+                                  aTables._columnCodes[getColumn(aConfiguration, 0)],
+                                  aTables._columnCodes[getColumn(aConfiguration, 1)],
+                                  aTables._columnCodes[getColumn(aConfiguration, 2)]);
+  return aTables._distances[aIndex];
+}
+
+DistanceWalking::Cost_t DistanceWalking::Incremental::operator()(const State& iState) const {
+  _parent = {computeRowsDistanceWithFinal(iState), computeColumnsDistanceWithFinal(iState), iState.getIndexSpace(),
+             iState.getStateConfiguration()};
+  return _parent._rows + _parent._columns;
+}
+
+void DistanceWalking::Incremental::prefetch(const State& iState, const std::size_t iSlot) const {
+  if (iSlot >= _slots.size()) _slots.resize(iSlot + 1);
+
+  Parts_t& aParts = _slots[iSlot];
+  aParts = _parent;
+  aParts._indexSpace = iState.getIndexSpace();
+  aParts._configuration = iState.getStateConfiguration();
+
+  // The state differs from the last node only where the "Space" tile was and is.
+  const State::StateConfiguration_t aMaskSpaces =
+      (State::StateConfiguration_t{0xF} << (_parent._indexSpace << 2)) |
+      (State::StateConfiguration_t{0xF} << (aParts._indexSpace << 2));
+  const bool aIsChild = ((aParts._configuration ^ _parent._configuration) & ~aMaskSpaces) == 0;
+
+  if (aIsChild && aParts._indexSpace / State::kSize == _parent._indexSpace / State::kSize) {
+    aParts._columns = computeColumnsDistanceWithFinal(iState);
+  } else if (aIsChild && aParts._indexSpace % State::kSize == _parent._indexSpace % State::kSize) {
+    aParts._rows = computeRowsDistanceWithFinal(iState);
+  } else {
+    aParts._rows = computeRowsDistanceWithFinal(iState);
+    aParts._columns = computeColumnsDistanceWithFinal(iState);
+  }
+}
+
+DistanceWalking::Cost_t DistanceWalking::Incremental::getCostPrefetched(const State& iState,
+                                                                        const std::size_t iSlot,
+                                                                        const int) const noexcept {
+  assert(_slots[iSlot]._indexSpace == iState.getIndexSpace());
+  assert(_slots[iSlot]._rows == computeRowsDistanceWithFinal(iState));
+  assert(_slots[iSlot]._columns == computeColumnsDistanceWithFinal(iState));
+  static_cast<void>(iState);
+
+  _parent = _slots[iSlot];
+  return _parent._rows + _parent._columns;
+}
+
+int DistanceWalking::getNumWalkStates() noexcept {
+  return getWalkTables()._numWalkStates;
+}
+
+const DistanceWalking::WalkTables_t& DistanceWalking::getWalkTables() noexcept {
+  static const auto sTables = []() {
+    auto aTables = std::make_unique<WalkTables_t>();
+    for (int aLine = 0; aLine < kSizeLineTable; ++aLine) {
+      aTables->_rowCodes[aLine] = computeLineCode(aLine, true);
+      aTables->_columnCodes[aLine] = computeLineCode(aLine, false);
+    }
+    generateDistances(aTables.get());
+    return aTables;
+  }();
+
+  return *sTables;
+}
+
+void DistanceWalking::generateDistances(WalkTables_t* oTables) noexcept {
+  const auto aComputeIndex = [](const WalkState_t& iWalkState) {
+    return computeIndex(iWalkState._indexLineSpace,
+                        computeLineCode(iWalkState._lines[0]),
+                        computeLineCode(iWalkState._lines[1]),
+                        computeLineCode(iWalkState._lines[2]));
+  };
+
+  oTables->_distances.fill(kDistanceUnknown);
+
+  // Final state: all tiles in their goal line, the "Space" in the last one.
+  WalkState_t aFinalState{};
+  for (int i = 0; i < State::kSize; ++i) {
+    aFinalState._lines[i][i] = State::kSize;
+  }
+  aFinalState._lines[State::kSize - 1][State::kSize - 1] = State::kSize - 1;
+  aFinalState._indexLineSpace = State::kSize - 1;
+
+  std::vector<WalkState_t> aQueue;
+  aQueue.push_back(aFinalState);
+  oTables->_distances[aComputeIndex(aFinalState)] = 0;
+
+  for (std::size_t aHead = 0; aHead < aQueue.size(); ++aHead) {
+    const WalkState_t aWalkState = aQueue[aHead];
+    const int aDistance = oTables->_distances[aComputeIndex(aWalkState)];
+
+    for (const int aOffset : {-1, 1}) {
+      const int aIndexLine = aWalkState._indexLineSpace + aOffset;
+      if (aIndexLine < 0 || aIndexLine >= State::kSize) continue;
+
+      // Any tile of the adjacent line can take the place of the "Space".
+      for (int aGoalLine = 0; aGoalLine < State::kSize; ++aGoalLine) {
+        if (aWalkState._lines[aIndexLine][aGoalLine] == 0) continue;
+
+        WalkState_t aChild = aWalkState;
+        --aChild._lines[aIndexLine][aGoalLine];
+        ++aChild._lines[aWalkState._indexLineSpace][aGoalLine];
+        aChild._indexLineSpace = aIndexLine;
+
+        std::uint8_t& aDistanceChild = oTables->_distances[aComputeIndex(aChild)];
+        if (aDistanceChild == kDistanceUnknown) {
+          aDistanceChild = static_cast<std::uint8_t>(aDistance + 1);
+          aQueue.push_back(aChild);
+        }
+      }
+    }
+  }
+
+  oTables->_numWalkStates = static_cast<int>(aQueue.size());
+}
+
+int DistanceWalking::computeLineCode(const LineCounts_t& iCounts) noexcept {
+  static constexpr int kRadix = State::kSize + 1;
+
+  // The compositions of four (and of three) tiles in lexicographic order.
+  static const auto sCodes = []() {
+    std::array<std::uint8_t, kRadix * kRadix * kRadix * kRadix> aCodes{};
+    std::array<int, kRadix> aNextCode{};
+    for (int i = 0; i < static_cast<int>(aCodes.size()); ++i) {
+      int aSum = 0;
+      for (int aDigits = i; aDigits > 0; aDigits /= kRadix) {
+        aSum += aDigits % kRadix;
+      }
+      if (aSum == State::kSize || aSum == State::kSize - 1) {
+        aCodes[i] = static_cast<std::uint8_t>(aNextCode[aSum]++);
+      }
+    }
+    return aCodes;
+  }();
+
+  return sCodes[((iCounts[3] * kRadix + iCounts[2]) * kRadix + iCounts[1]) * kRadix + iCounts[0]];
+}
+
+int DistanceWalking::computeLineCode(const int iLine, const bool iIsRow) noexcept {
+  LineCounts_t aCounts{};
+  for (int i = 0; i < State::kSize; ++i) {
+    const int aTile = (iLine >> (i << 2)) & 0xF;
+    if (aTile == 0) continue;
+
+    const int aGoalPosition = aTile - 1;
+    ++aCounts[iIsRow ? aGoalPosition / State::kSize : aGoalPosition % State::kSize];
+  }
+
+  return computeLineCode(aCounts);
+}
+
+}  // namespace kpuzzle4
@@ -0,0 +1,173 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__DISTANCE_WALKING__HPP
+#define KPUZZLE4__DISTANCE_WALKING__HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SearchNode.hpp"
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief Walking distance: the number of vertical moves needed to bring each
+ *  tile in its goal row, plus the number of horizontal moves needed to bring
+ *  each tile in its goal column.
+ *  The vertical part is the distance in the abstraction where a state only
+ *  says, for each row, how many of its tiles belong to each goal row (and
+ *  which is the row of the "Space" tile): a move takes one tile from a row
+ *  adjacent to the one of the "Space". The horizontal part is the same on the
+ *  columns (the final state is symmetric, so the distances are the same).
+ *  It is at least the Manhattan distance.
+ *  \note The abstraction has less than 25K states: the distances are generated
+ *  by a breadth-first search the first time they are needed. A state is
+ *  indexed by the code of its first three lines (the last one follows) and
+ *  the line of the "Space": the code of a line is looked up in a table
+ *  indexed by its four nibbles.
+ *  \note A vertical move never changes the horizontal part (and vice versa),
+ *  so the two parts are also available separately.
+ */
+class DistanceWalking {
+ public:
+  using Cost_t = SearchNode::Cost_t;
+
+  //! \brief It computes the heuristic cost towards the final state.
+  static Cost_t computeDistanceWithFinal(const State& iState) noexcept;
+
+  //! \brief It computes the vertical moves part towards the final state.
+  static Cost_t computeRowsDistanceWithFinal(const State& iState) noexcept;
+
+  //! \brief It computes the horizontal moves part towards the final state.
+  static Cost_t computeColumnsDistanceWithFinal(const State& iState) noexcept;
+
+  //! \return the number of states of the abstraction.
+  static int getNumWalkStates() noexcept;
+
+  /*! \brief The heuristic computed incrementally along the search (see the
+   *  prefetch of AlgorithmIDA): a child takes from its parent the part its
+   *  move does not change (the vertical one on a horizontal move, and vice
+   *  versa), only the other one is looked up.
+   *  The parts of a child are kept in its slot when it is prefetched, the ones
+   *  of its parent when the cost of the parent is computed.
+   *  \note The cost of the parent may not have been computed (e.g., by a
+   *  composition stopped beyond the bound, see HeuristicComposer): a child
+   *  takes a part only from the last node computed which differs from it by
+   *  the "Space" tile, otherwise both parts are looked up.
+   */
+  class Incremental {
+   public:
+    //! \return the heuristic cost (both parts are looked up).
+    Cost_t operator()(const State& iState) const;
+
+    //! \brief It computes the parts of a child of the last node whose cost has been computed.
+    void prefetch(const State& iState, const std::size_t iSlot) const;
+
+    //! \return the heuristic cost of the child prefetched in the slot.
+    Cost_t getCostPrefetched(const State& iState, const std::size_t iSlot, const int iBound) const noexcept;
+
+   private:
+    struct Parts_t {
+      Cost_t _rows;
+      Cost_t _columns;
+      int _indexSpace;
+      State::StateConfiguration_t _configuration;
+    };
+
+    //! \brief The parts of the last node whose cost has been computed (usually the parent of the next children).
+    mutable Parts_t _parent = {};
+
+    mutable std::vector<Parts_t> _slots;
+  };
+
+ protected:
+  static constexpr int kSizeLineTable = 1 << (State::kSize * 4);
+
+  //! \brief Number of ways of splitting the four tiles of a line among the goal lines.
+  static constexpr int kNumLineCodes = 35;
+
+  static constexpr int kSizeDistanceTable = State::kSize * kNumLineCodes * kNumLineCodes * kNumLineCodes;
+
+  static constexpr std::uint8_t kDistanceUnknown = 0xFF;
+
+  //! \brief Code of a line indexed by its four tiles (one per nibble).
+  using LineTable_t = std::array<std::uint8_t, kSizeLineTable>;
+
+  //! \brief Distance of a state of the abstraction indexed by `computeIndex`.
+  using DistanceTable_t = std::array<std::uint8_t, kSizeDistanceTable>;
+
+  //! \brief Number of tiles of a line for each goal line.
+  using LineCounts_t = std::array<int, State::kSize>;
+
+  //! \brief State of the abstraction.
+  struct WalkState_t {
+    std::array<LineCounts_t, State::kSize> _lines;
+    int _indexLineSpace;
+  };
+
+  struct WalkTables_t {
+    LineTable_t _rowCodes;
+    LineTable_t _columnCodes;
+    DistanceTable_t _distances;
+    int _numWalkStates;
+  };
+
+  //! \return the tables (they are generated the first time).
+  static const WalkTables_t& getWalkTables() noexcept;
+
+  //! \brief Breadth-first search of the abstraction from the final state.
+  static void generateDistances(WalkTables_t* oTables) noexcept;
+
+  /*! \return the code of the counts of a line: the lines with the "Space"
+   *  (three tiles) and the others (four tiles) are numbered separately.
+   */
+  static int computeLineCode(const LineCounts_t& iCounts) noexcept;
+
+  /*! \return the code of a line given its four tiles (one per nibble).
+   *  \param [in] iIsRow      Whether the tiles are counted by goal row or
+   *                          goal column.
+   */
+  static int computeLineCode(const int iLine, const bool iIsRow) noexcept;
+
+  //! \return the index in the distance table.
+  static constexpr int computeIndex(const int iIndexLineSpace,
+                                    const int iCode0,
+                                    const int iCode1,
+                                    const int iCode2) noexcept;
+
+  //! \return the four tiles of a column (one per nibble).
+  static constexpr int getColumn(const State::StateConfiguration_t iConfiguration, const int iIndexColumn) noexcept;
+};
+
+constexpr int DistanceWalking::computeIndex(const int iIndexLineSpace,
+                                            const int iCode0,
+                                            const int iCode1,
+                                            const int iCode2) noexcept {
+  return ((iIndexLineSpace * kNumLineCodes + iCode0) * kNumLineCodes + iCode1) * kNumLineCodes + iCode2;
+}
+
+constexpr int DistanceWalking::getColumn(const State::StateConfiguration_t iConfiguration,
+                                         const int iIndexColumn) noexcept {
+  const State::StateConfiguration_t aShifted = iConfiguration >> (iIndexColumn << 2);
+  return static_cast<int>((aShifted & 0xF) | ((aShifted >> 12) & 0xF0) | ((aShifted >> 24) & 0xF00) |
+                          ((aShifted >> 36) & 0xF000));
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__DISTANCE_WALKING__HPP
@@ -0,0 +1,53 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "DynamicPatternDB.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace kpuzzle4 {
+
+DynamicPatternDB::DynamicPatternDB(MaskPartitions_t iMaskPartitions)
+    : PatternDBBase(static_cast<int>(iMaskPartitions.size())), _maskPartitions(std::move(iMaskPartitions)) {
+  if (!isValidPartitions(_maskPartitions)) {
+    throw std::runtime_error("The partitions of the PatternDB are not valid");
+  }
+
+  _partitions.reserve(_maskPartitions.size());
+  for (const Mask_t aMask : _maskPartitions) {
+    _partitions.emplace_back(aMask);
+  }
+  initializeSourcePartitions();
+}
+
+bool DynamicPatternDB::isValidPartitions(const MaskPartitions_t& iMaskPartitions) noexcept {
+  for (const Mask_t aMask : iMaskPartitions) {
+    // Each nibble is either enabled or disabled.
+    for (int i = 0; i < State::kNumTiles; ++i) {
+      const Mask_t aNibble = (aMask >> (i << 2)) & 0xF;
+      if (aNibble != 0x0 && aNibble != 0xF) return false;
+    }
+  }
+
+  return !iMaskPartitions.empty() && PatternPartition::isValidPartitions(iMaskPartitions);
+}
+
+const DynamicPatternDB::MaskPartitions_t& DynamicPatternDB::getMaskPartitions() const noexcept {
+  return _maskPartitions;
+}
+
+}  // namespace kpuzzle4
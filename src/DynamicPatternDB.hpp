@@ -0,0 +1,75 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__DYNAMIC_PATTERN_DB__HPP
+#define KPUZZLE4__DYNAMIC_PATTERN_DB__HPP
+#include <cassert>
+#include <vector>
+#include "PatternDBBase.hpp"
+#include "PatternPartition.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief Pattern database with the partitions given at run time (e.g., from
+ *  the command line or from the header of a file), so they can be changed
+ *  without recompiling.
+ *  The partitions are checked as `PatternDB::isValidPartitions` does, and the
+ *  ranking tables of each partition are computed once in the constructor.
+ *  \see PatternDBBase for the cost tables and the lookups.
+ */
+class DynamicPatternDB : public PatternDBBase<DynamicPatternDB> {
+ public:
+  using MaskPartitions_t = std::vector<Mask_t>;
+
+  /*! \brief Creates the database of the partitions (still to be generated or
+   *  loaded).
+   *  \throw std::runtime_error in case the partitions are not valid.
+   */
+  explicit DynamicPatternDB(MaskPartitions_t iMaskPartitions);
+
+  //! \return whether the partition model is valid or not.
+  static bool isValidPartitions(const MaskPartitions_t& iMaskPartitions) noexcept;
+
+  //! \return true: the partitions of an instance are always valid.
+  static constexpr bool isValidPartitions() noexcept { return true; }
+
+  //! \return the mask partitions model.
+  const MaskPartitions_t& getMaskPartitions() const noexcept;
+
+  //! \return the number of partitions.
+  int getNumPartitions() const noexcept;
+
+  //! \return the i-th partition.
+  const PatternPartition& getPartition(const int iIndexPartition) const noexcept;
+
+ private:
+  MaskPartitions_t _maskPartitions;
+  std::vector<PatternPartition> _partitions;
+};
+
+inline int DynamicPatternDB::getNumPartitions() const noexcept {
+  return static_cast<int>(_partitions.size());
+}
+
+inline const PatternPartition& DynamicPatternDB::getPartition(const int iIndexPartition) const noexcept {
+  assert(iIndexPartition < getNumPartitions());
+  return _partitions[iIndexPartition];
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__DYNAMIC_PATTERN_DB__HPP
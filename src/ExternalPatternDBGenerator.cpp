@@ -0,0 +1,359 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "ExternalPatternDBGenerator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include "Crc32c.hpp"
+#include "MappedFile.hpp"
+#include "PatternDBFile.hpp"
+#include "State.hpp"
+
+namespace {
+
+using Node_t = std::uint64_t;
+
+//! \brief Sequential reader of a sorted file of nodes.
+class NodeReader {
+ public:
+  NodeReader(const std::string& iFileName, const std::size_t iBufferSize)
+      : _file(iFileName, std::ios_base::binary), _buffer(iBufferSize) {
+    if (_file.fail()) {
+      throw std::runtime_error("Cannot open the file: " + iFileName);
+    }
+    fill();
+  }
+
+  //! \return whether all nodes have been read.
+  bool isEnd() const noexcept {
+    return _position == _size;
+  }
+
+  //! \return the current node.
+  Node_t getNode() const noexcept {
+    return _buffer[_position];
+  }
+
+  //! \brief Moves to the next node.
+  void next() {
+    if (++_position == _size) fill();
+  }
+
+  //! \brief Moves to the first node not less than the given one.
+  void skipBefore(const Node_t iNode) {
+    while (!isEnd() && getNode() < iNode) next();
+  }
+
+ private:
+  std::ifstream _file;
+  std::vector<Node_t> _buffer;
+  std::size_t _position = 0;
+  std::size_t _size = 0;
+
+  void fill() {
+    _file.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size() * sizeof(Node_t)));
+    _size = static_cast<std::size_t>(_file.gcount()) / sizeof(Node_t);
+    _position = 0;
+  }
+};
+
+//! \brief Sequential writer of a file of nodes.
+class NodeWriter {
+ public:
+  explicit NodeWriter(const std::string& iFileName)
+      : _fileName(iFileName), _file(iFileName, std::ios_base::binary | std::ios_base::trunc) {
+    if (_file.fail()) {
+      throw std::runtime_error("Cannot write the file: " + iFileName);
+    }
+  }
+
+  //! \brief Appends the nodes at the end of the file.
+  void write(const Node_t* iNodes, const std::size_t iNumNodes) {
+    _file.write(reinterpret_cast<const char*>(iNodes), static_cast<std::streamsize>(iNumNodes * sizeof(Node_t)));
+    _numNodes += iNumNodes;
+    if (_file.fail()) {
+      throw std::runtime_error("Cannot write the file: " + _fileName);
+    }
+  }
+
+  //! \brief Flushes and closes the file.
+  void close() {
+    _file.close();
+    if (_file.fail()) {
+      throw std::runtime_error("Cannot write the file: " + _fileName);
+    }
+  }
+
+  //! \return the number of nodes written.
+  std::uint64_t getNumNodes() const noexcept {
+    return _numNodes;
+  }
+
+ private:
+  std::string _fileName;
+  std::ofstream _file;
+  std::uint64_t _numNodes = 0;
+};
+
+//! \brief Temporary files, removed when the object is destroyed (even on error) unless released.
+class TemporaryFiles {
+ public:
+  TemporaryFiles() = default;
+  TemporaryFiles(const TemporaryFiles&) = delete;
+  TemporaryFiles& operator=(const TemporaryFiles&) = delete;
+
+  ~TemporaryFiles() {
+    for (const std::string& aFileName : _fileNames) {
+      std::remove(aFileName.c_str());
+    }
+  }
+
+  //! \return the name of the file added, valid until the next one is added.
+  const std::string& add(std::string iFileName) {
+    _fileNames.push_back(std::move(iFileName));
+    return _fileNames.back();
+  }
+
+  //! \return the names of the files, in order of addition.
+  const std::vector<std::string>& getFileNames() const noexcept {
+    return _fileNames;
+  }
+
+  //! \brief The files are kept.
+  void release() noexcept {
+    _fileNames.clear();
+  }
+
+ private:
+  std::vector<std::string> _fileNames;
+};
+
+/*! \brief The layout of the nodes on disk: the position of the i-th tile of the partition (in the order of the
+ *  ranking) is the nibble 15 - i, the "Space" tile is the nibble 0. The nodes sorted are sorted as the ranks of their
+ *  entries, so the table is written in order.
+ */
+class NodeLayout {
+ public:
+  explicit NodeLayout(const kpuzzle4::PatternPartition& iPartition) : _partition(iPartition) {}
+
+  //! \return the node of a hash (see PatternPartition::forEachMove).
+  Node_t toNode(const std::uint64_t iHash) const noexcept {
+    Node_t aNode = iHash & 0xF;
+    for (int i = 0; i < _partition.getNumTiles(); ++i) {
+      aNode |= ((iHash >> (_partition.getTile(i) << 2)) & 0xF) << ((kpuzzle4::State::kNumTilesMinusOne - i) << 2);
+    }
+    return aNode;
+  }
+
+  //! \return the hash of a node.
+  std::uint64_t toHash(const Node_t iNode) const noexcept {
+    std::uint64_t aHash = iNode & 0xF;
+    for (int i = 0; i < _partition.getNumTiles(); ++i) {
+      aHash |= ((iNode >> ((kpuzzle4::State::kNumTilesMinusOne - i) << 2)) & 0xF) << (_partition.getTile(i) << 2);
+    }
+    return aHash;
+  }
+
+ private:
+  const kpuzzle4::PatternPartition& _partition;
+};
+
+}  // anonymous namespace
+
+namespace kpuzzle4 {
+
+ExternalPatternDBGenerator::ExternalPatternDBGenerator(std::vector<Mask_t> iMaskPartitions,
+                                                       const std::uint64_t iMemoryLimit,
+                                                       std::string iTemporaryDirectory)
+    : _maskPartitions(std::move(iMaskPartitions)),
+      _memoryLimit(iMemoryLimit),
+      _temporaryDirectory(std::move(iTemporaryDirectory)) {}
+
+void ExternalPatternDBGenerator::generate(const std::string& iFileName) const {
+  PatternDBFile aLayout{_maskPartitions};
+  // The tables are written aside and the file is moved over the previous one when complete (the processes mapping it
+  // keep the previous one). The lock of the file keeps the other generations off the temporary files.
+  const std::string aIncompleteFileName = iFileName + ".tmp";
+  MappedFile aFile(aIncompleteFileName.c_str(), aLayout.getFileSize());
+  TemporaryFiles aIncompleteFile;
+  aIncompleteFile.add(aIncompleteFileName);
+  char* aData = aFile.getData();
+
+  const std::string aTemporaryPrefix = getTemporaryFileName(iFileName, "");
+  for (std::size_t i = 0; i < _maskPartitions.size(); ++i) {
+    const PatternPartition aPartition{_maskPartitions[i]};
+    const PatternDBFile::Section_t& aSection = aLayout.getSections()[i];
+    Cost_t* aCostTable = reinterpret_cast<Cost_t*>(aData + aSection._offset);
+
+    // The table of a partition transposed of a previous one is unfolded from it (see PatternDB).
+    const Mask_t aMaskTransposed = PatternPartition::transposeMask(_maskPartitions[i]);
+    const auto aSource = std::find(_maskPartitions.cbegin(), _maskPartitions.cbegin() + i, aMaskTransposed);
+    if (aSource != _maskPartitions.cbegin() + i) {
+      const PatternPartition aSourcePartition{*aSource};
+      const Cost_t* aSourceCostTable = reinterpret_cast<const Cost_t*>(
+          aData + aLayout.getSections()[aSource - _maskPartitions.cbegin()]._offset);
+      aPartition.forEachHash([&aSourcePartition, aSourceCostTable, aCostTable](const PatternPartition::Index_t iIndex,
+                                                                               const std::uint64_t iHash) {
+        aCostTable[iIndex] = aSourceCostTable[aSourcePartition.rank(aSourcePartition.computeTransposedHash(iHash))];
+      });
+    } else {
+      std::fill(aCostTable, aCostTable + aSection._size, std::numeric_limits<Cost_t>::max());
+      bfs(aPartition, aTemporaryPrefix, aCostTable);
+    }
+    aLayout.setChecksum(static_cast<int>(i), Crc32c::compute(aCostTable, aSection._size));
+  }
+
+  // The header is written last, with the checksums.
+  const std::string aHeader = aLayout.serializeHeader();
+  std::memcpy(aData, aHeader.data(), aHeader.size());
+  aFile.rename(iFileName.c_str());
+  aIncompleteFile.release();
+}
+
+std::uint64_t ExternalPatternDBGenerator::getRunSize() const noexcept {
+  static constexpr std::uint64_t kMinRunSize = 1024;
+  return std::max(kMinRunSize, _memoryLimit / sizeof(Node_t));
+}
+
+std::string ExternalPatternDBGenerator::getTemporaryFileName(const std::string& iFileName,
+                                                             const std::string& iSuffix) const {
+  if (_temporaryDirectory.empty()) return iFileName + ".tmp" + iSuffix;
+
+  const std::size_t aBaseName = iFileName.find_last_of("/\\");
+  return _temporaryDirectory + '/' + iFileName.substr(aBaseName == std::string::npos ? 0 : aBaseName + 1) + ".tmp" +
+         iSuffix;
+}
+
+void ExternalPatternDBGenerator::bfs(const PatternPartition& iPartition,
+                                     const std::string& iTemporaryPrefix,
+                                     Cost_t* oCostTable) const {
+  // A node is the hash of the pattern tiles with the "Space" tile normalized (see PatternDB::bfs), in the layout which
+  // sorts the nodes as the ranks of their entries (see NodeLayout).
+  // The neighbours of a node of the layer d are in the layers d - 1, d and d + 1: the next layer is made by the
+  // children not in the previous two layers, so only three layers are on disk at once.
+  static constexpr int kNumLayerFiles = 3;
+  static constexpr std::size_t kMinBufferSize = 512;
+
+  const auto aLayerFileName = [&iTemporaryPrefix](const int iCost) {
+    return iTemporaryPrefix + ".layer" + std::to_string(iCost % kNumLayerFiles);
+  };
+  const std::size_t aRunSize = static_cast<std::size_t>(getRunSize());
+  TemporaryFiles aLayerFiles;
+  for (int i = 0; i < kNumLayerFiles; ++i) aLayerFiles.add(aLayerFileName(i));
+
+  const NodeLayout aNodeLayout{iPartition};
+  const std::uint64_t aGoal =
+      iPartition.normalizeSpace(State::generateSortedState().getHashWithMask(iPartition.getMask()));
+  oCostTable[iPartition.rank(aGoal)] = 0;
+  {
+    NodeWriter aLayer(aLayerFileName(0));
+    const Node_t aGoalNode = aNodeLayout.toNode(aGoal);
+    aLayer.write(&aGoalNode, 1);
+    aLayer.close();
+  }
+  NodeWriter(aLayerFileName(-1 + kNumLayerFiles)).close();
+
+  std::uint64_t aLayerSize = 1;
+  for (Cost_t aCost = 1; aLayerSize != 0; ++aCost) {
+    // Expansion: the children are sorted in runs of the memory limit.
+    TemporaryFiles aRunFiles;
+    const std::vector<std::string>& aRunFileNames = aRunFiles.getFileNames();
+    {
+      std::vector<Node_t> aChildren;
+      aChildren.reserve(aRunSize);
+      const auto aWriteRun = [&aChildren, &aRunFiles, &iTemporaryPrefix]() {
+        std::sort(aChildren.begin(), aChildren.end());
+        aChildren.erase(std::unique(aChildren.begin(), aChildren.end()), aChildren.end());
+        NodeWriter aRun(aRunFiles.add(iTemporaryPrefix + ".run" + std::to_string(aRunFiles.getFileNames().size())));
+        aRun.write(aChildren.data(), aChildren.size());
+        aRun.close();
+        aChildren.clear();
+      };
+
+      NodeReader aLayer(aLayerFileName(aCost - 1), kMinBufferSize);
+      for (; !aLayer.isEnd(); aLayer.next()) {
+        iPartition.forEachMove(aNodeLayout.toHash(aLayer.getNode()),
+                               [&aChildren, aRunSize, &aWriteRun, &aNodeLayout](const std::uint64_t iChild) {
+                                 if (aChildren.size() == aRunSize) aWriteRun();
+                                 aChildren.push_back(aNodeLayout.toNode(iChild));
+                               });
+      }
+      if (!aChildren.empty()) aWriteRun();
+    }
+
+    // Merge: the runs are merged (without duplicates) with the previous two layers, which are subtracted.
+    {
+      const std::size_t aBufferSize = std::max(kMinBufferSize, aRunSize / (aRunFileNames.size() + 3));
+      std::vector<NodeReader> aRuns;
+      aRuns.reserve(aRunFileNames.size());
+      using HeapEntry_t = std::pair<Node_t, std::size_t>;
+      std::priority_queue<HeapEntry_t, std::vector<HeapEntry_t>, std::greater<HeapEntry_t>> aHeap;
+      for (const std::string& aRunFileName : aRunFileNames) {
+        aRuns.emplace_back(aRunFileName, aBufferSize);
+        if (!aRuns.back().isEnd()) aHeap.emplace(aRuns.back().getNode(), aRuns.size() - 1);
+      }
+
+      NodeReader aPreviousLayer(aLayerFileName(aCost - 2 + kNumLayerFiles), aBufferSize);
+      NodeReader aLayer(aLayerFileName(aCost - 1), aBufferSize);
+      NodeWriter aNextLayer(aLayerFileName(aCost));
+      std::vector<Node_t> aOutput;
+      aOutput.reserve(aBufferSize);
+
+      bool aFirst = true;
+      Node_t aLastNode = 0;
+      while (!aHeap.empty()) {
+        const auto [aNode, aIndexRun] = aHeap.top();
+        aHeap.pop();
+        aRuns[aIndexRun].next();
+        if (!aRuns[aIndexRun].isEnd()) aHeap.emplace(aRuns[aIndexRun].getNode(), aIndexRun);
+
+        if (!aFirst && aNode == aLastNode) continue;
+        aFirst = false;
+        aLastNode = aNode;
+
+        aPreviousLayer.skipBefore(aNode);
+        aLayer.skipBefore(aNode);
+        if ((!aPreviousLayer.isEnd() && aPreviousLayer.getNode() == aNode) ||
+            (!aLayer.isEnd() && aLayer.getNode() == aNode)) {
+          continue;
+        }
+
+        // The layers are in order of cost, so the first node of an entry sets it.
+        Cost_t& aEntry = oCostTable[iPartition.rank(aNodeLayout.toHash(aNode))];
+        aEntry = std::min(aEntry, aCost);
+
+        aOutput.push_back(aNode);
+        if (aOutput.size() == aBufferSize) {
+          aNextLayer.write(aOutput.data(), aOutput.size());
+          aOutput.clear();
+        }
+      }
+      aNextLayer.write(aOutput.data(), aOutput.size());
+      aNextLayer.close();
+      aLayerSize = aNextLayer.getNumNodes();
+    }
+  }
+}
+
+}  // namespace kpuzzle4
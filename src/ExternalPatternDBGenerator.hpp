@@ -0,0 +1,82 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__EXTERNAL_PATTERN_DB_GENERATOR__HPP
+#define KPUZZLE4__EXTERNAL_PATTERN_DB_GENERATOR__HPP
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PatternPartition.hpp"
+#include "SearchNode.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief It generates the file of a pattern database (the same as
+ *  PatternDB::serialize after PatternDB::generate) keeping only a bounded
+ *  amount of memory, for tables larger than the RAM.
+ *  The breadth-first search of each partition streams its layers on files on
+ *  disk, sorted by node: the children of a layer are sorted in runs as large
+ *  as the memory limit, then the runs are merged removing the duplicates and
+ *  the nodes of the previous two layers (delayed duplicate detection).
+ *  The tables are written on the mapped output file (see PatternDBFile): the
+ *  nodes are sorted as their entries, so each layer writes them in order.
+ */
+class ExternalPatternDBGenerator {
+ public:
+  using Mask_t = PatternPartition::Mask_t;
+  using Cost_t = SearchNode::Cost_t;
+
+  static constexpr std::uint64_t kDefaultMemoryLimit = std::uint64_t{256} << 20;
+
+  /*! \param [in] iMaskPartitions       The masks of the partitions.
+   *  \param [in] iMemoryLimit          The bytes of the buffers of the nodes.
+   *  \param [in] iTemporaryDirectory   Where the files of the layers are
+   *                                    written (the directory of the output
+   *                                    file when empty).
+   */
+  explicit ExternalPatternDBGenerator(std::vector<Mask_t> iMaskPartitions,
+                                      const std::uint64_t iMemoryLimit = kDefaultMemoryLimit,
+                                      std::string iTemporaryDirectory = "");
+
+  /*! \brief It generates the pattern database on a file (overwritten).
+   *  The tables are written on a temporary file next to it, moved over it
+   *  when complete. The temporary files are removed, even on error.
+   *  \throw std::runtime_error in case a file cannot be written or another
+   *  generation of the same file is running.
+   */
+  void generate(const std::string& iFileName) const;
+
+  //! \return the number of nodes sorted in memory at once (at least 1024).
+  std::uint64_t getRunSize() const noexcept;
+
+ private:
+  std::vector<Mask_t> _maskPartitions;
+  std::uint64_t _memoryLimit;
+  std::string _temporaryDirectory;
+
+  //! \return the path of a temporary file for the output file.
+  std::string getTemporaryFileName(const std::string& iFileName, const std::string& iSuffix) const;
+
+  /*! \brief It generates the cost table of a partition (filled with the max
+   *  cost) with the breadth-first search on disk.
+   */
+  void bfs(const PatternPartition& iPartition, const std::string& iTemporaryPrefix, Cost_t* oCostTable) const;
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__EXTERNAL_PATTERN_DB_GENERATOR__HPP
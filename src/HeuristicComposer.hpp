@@ -0,0 +1,234 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__HEURISTIC_COMPOSER__HPP
+#define KPUZZLE4__HEURISTIC_COMPOSER__HPP
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief Composition of heuristics resolved at compile time: the cost is the
+ *  max (or the sum) of the costs of the heuristics, in the given order.
+ *  A heuristic is a function object with signature: int(const State&).
+ *  It can also have:
+ *    - `int operator()(const State&, int iBound)`: it can stop as soon as the
+ *      cost is greater than the bound, returning the (admissible) partial cost.
+ *    - `void onNewIteration()`: forwarded to all heuristics.
+ *    - `void prefetch(const State&, std::size_t iSlot)` with
+ *      `int getCostPrefetched(const State&, std::size_t iSlot, int iBound)`:
+ *      forwarded to all heuristics which have them (see `AlgorithmIDA`).
+ *  The composition has both, so it can be nested and it can be given to
+ *  `AlgorithmIDA`, which passes the bound of the current iteration: the
+ *  heuristics after the one that exceeds the bound are not computed, so the
+ *  cheapest (or the strongest) ones should come first.
+ *  \template Combine is HeuristicCombineMax or HeuristicCombineSum.
+ */
+template <typename Combine, typename... Heuristics>
+class HeuristicComposer {
+ public:
+  static_assert(sizeof...(Heuristics) > 0, "at least one heuristic is needed");
+
+  explicit HeuristicComposer(Heuristics... iHeuristics) : _heuristics(std::move(iHeuristics)...) {}
+
+  //! \return the cost combining all heuristics.
+  int operator()(const State& iState) const;
+
+  /*! \return the cost combining the heuristics until it is greater than the
+   *  bound (in that case, it is lower than the full cost but still admissible).
+   */
+  int operator()(const State& iState, const int iBound) const;
+
+  //! \brief It notifies the heuristics of a new iteration of the search.
+  void onNewIteration();
+
+  //! \brief It lets the heuristics prefetch what they need to compute the cost of the state.
+  void prefetch(const State& iState, const std::size_t iSlot) const;
+
+  //! \return the same as `operator()(iState, iBound)`, after `prefetch` on the same state and slot.
+  int getCostPrefetched(const State& iState, const std::size_t iSlot, const int iBound) const;
+
+ private:
+  std::tuple<Heuristics...> _heuristics;
+
+  //! \brief Whether the heuristic can stop beyond a bound.
+  template <typename Heuristic, typename = void>
+  struct HasBound : std::false_type {};
+
+  template <typename Heuristic>
+  struct HasBound<Heuristic,
+                  std::void_t<decltype(std::declval<const Heuristic&>()(std::declval<const State&>(), int{}))>>
+      : std::true_type {};
+
+  //! \brief Whether the heuristic wants to be notified of a new iteration.
+  template <typename Heuristic, typename = void>
+  struct HasIterationHook : std::false_type {};
+
+  template <typename Heuristic>
+  struct HasIterationHook<Heuristic, std::void_t<decltype(std::declval<Heuristic&>().onNewIteration())>>
+      : std::true_type {};
+
+  //! \brief Whether the heuristic can prefetch the cost of a state.
+  template <typename Heuristic, typename = void>
+  struct HasPrefetch : std::false_type {};
+
+  template <typename Heuristic>
+  struct HasPrefetch<Heuristic,
+                     std::void_t<decltype(std::declval<const Heuristic&>().prefetch(std::declval<const State&>(),
+                                                                                    std::size_t{})),
+                                 decltype(std::declval<const Heuristic&>().getCostPrefetched(
+                                     std::declval<const State&>(), std::size_t{}, int{}))>> : std::true_type {};
+
+  /*! \return the cost of the I-th heuristic and of the following ones combined to the cost up to here.
+   *  The slot is given only when the state has been prefetched.
+   */
+  template <std::size_t I>
+  int combineFrom(const State& iState, const int iCost, const int iBound, const std::size_t* iSlot) const;
+};
+
+//! \brief The max of admissible heuristics is admissible.
+struct HeuristicCombineMax {
+  static constexpr int kIdentity = 0;
+
+  static constexpr int combine(const int iCost, const int iCostHeuristic) noexcept {
+    return std::max(iCost, iCostHeuristic);
+  }
+
+  //! \return the bound of the next heuristic given the cost up to here.
+  static constexpr int nextBound(const int, const int iBound) noexcept { return iBound; }
+};
+
+/*! \brief The sum is admissible only when the heuristics are additive (e.g.,
+ *  pattern databases of disjoint partitions, counting only the moves of their
+ *  tiles).
+ */
+struct HeuristicCombineSum {
+  static constexpr int kIdentity = 0;
+
+  static constexpr int combine(const int iCost, const int iCostHeuristic) noexcept { return iCost + iCostHeuristic; }
+
+  static constexpr int nextBound(const int iCost, const int iBound) noexcept { return iBound - iCost; }
+};
+
+template <typename... Heuristics>
+using HeuristicMax = HeuristicComposer<HeuristicCombineMax, Heuristics...>;
+
+template <typename... Heuristics>
+using HeuristicSum = HeuristicComposer<HeuristicCombineSum, Heuristics...>;
+
+//! \return the max of the heuristics.
+template <typename... Heuristics>
+HeuristicMax<std::decay_t<Heuristics>...> makeHeuristicMax(Heuristics&&... iHeuristics) {
+  return HeuristicMax<std::decay_t<Heuristics>...>(std::forward<Heuristics>(iHeuristics)...);
+}
+
+//! \return the sum of the (additive) heuristics.
+template <typename... Heuristics>
+HeuristicSum<std::decay_t<Heuristics>...> makeHeuristicSum(Heuristics&&... iHeuristics) {
+  return HeuristicSum<std::decay_t<Heuristics>...>(std::forward<Heuristics>(iHeuristics)...);
+}
+
+template <typename Combine, typename... Heuristics>
+int HeuristicComposer<Combine, Heuristics...>::operator()(const State& iState) const {
+  return std::apply(
+      [&iState](const auto&... iHeuristics) {
+        int aCost = Combine::kIdentity;
+        ((aCost = Combine::combine(aCost, static_cast<int>(iHeuristics(iState)))), ...);
+        return aCost;
+      },
+      _heuristics);
+}
+
+template <typename Combine, typename... Heuristics>
+int HeuristicComposer<Combine, Heuristics...>::operator()(const State& iState, const int iBound) const {
+  return combineFrom<0>(iState, Combine::kIdentity, iBound, nullptr);
+}
+
+template <typename Combine, typename... Heuristics>
+int HeuristicComposer<Combine, Heuristics...>::getCostPrefetched(const State& iState,
+                                                                 const std::size_t iSlot,
+                                                                 const int iBound) const {
+  return combineFrom<0>(iState, Combine::kIdentity, iBound, &iSlot);
+}
+
+template <typename Combine, typename... Heuristics>
+template <std::size_t I>
+int HeuristicComposer<Combine, Heuristics...>::combineFrom(const State& iState,
+                                                           const int iCost,
+                                                           const int iBound,
+                                                           const std::size_t* iSlot) const {
+  using Heuristic = std::tuple_element_t<I, std::tuple<Heuristics...>>;
+  const Heuristic& aHeuristic = std::get<I>(_heuristics);
+
+  const int aBound = Combine::nextBound(iCost, iBound);
+  const auto aComputeCost = [&aHeuristic, &iState, aBound]() {
+    if constexpr (HasBound<Heuristic>::value) {
+      return static_cast<int>(aHeuristic(iState, aBound));
+    } else {
+      return static_cast<int>(aHeuristic(iState));
+    }
+  };
+
+  int aCostHeuristic;
+  if constexpr (HasPrefetch<Heuristic>::value) {
+    aCostHeuristic = iSlot != nullptr ? aHeuristic.getCostPrefetched(iState, *iSlot, aBound) : aComputeCost();
+  } else {
+    aCostHeuristic = aComputeCost();
+  }
+
+  const int aCost = Combine::combine(iCost, aCostHeuristic);
+  if constexpr (I + 1 < sizeof...(Heuristics)) {
+    if (aCost <= iBound) return combineFrom<I + 1>(iState, aCost, iBound, iSlot);
+  }
+  return aCost;
+}
+
+template <typename Combine, typename... Heuristics>
+void HeuristicComposer<Combine, Heuristics...>::onNewIteration() {
+  std::apply(
+      [](auto&... ioHeuristics) {
+        const auto aNotify = [](auto& ioHeuristic) {
+          if constexpr (HasIterationHook<std::remove_reference_t<decltype(ioHeuristic)>>::value) {
+            ioHeuristic.onNewIteration();
+          }
+        };
+        (aNotify(ioHeuristics), ...);
+      },
+      _heuristics);
+}
+
+template <typename Combine, typename... Heuristics>
+void HeuristicComposer<Combine, Heuristics...>::prefetch(const State& iState, const std::size_t iSlot) const {
+  std::apply(
+      [&iState, iSlot](const auto&... iHeuristics) {
+        const auto aPrefetch = [&iState, iSlot](const auto& iHeuristic) {
+          if constexpr (HasPrefetch<std::remove_reference_t<decltype(iHeuristic)>>::value) {
+            iHeuristic.prefetch(iState, iSlot);
+          }
+        };
+        (aPrefetch(iHeuristics), ...);
+      },
+      _heuristics);
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__HEURISTIC_COMPOSER__HPP
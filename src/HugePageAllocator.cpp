@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "HugePageAllocator.hpp"
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace kpuzzle4 {
+
+void* HugePageMemory::allocate(const std::size_t iSize) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (isHugePageBlock(iSize)) {
+    // The size of an aligned allocation has to be a multiple of the alignment.
+    const std::size_t aSize = (iSize + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    void* aPointer = std::aligned_alloc(kHugePageSize, aSize);
+    if (aPointer == nullptr) throw std::bad_alloc();
+
+    // It is only an advice: without transparent huge pages the block keeps the regular pages.
+    ::madvise(aPointer, aSize, MADV_HUGEPAGE);
+    return aPointer;
+  }
+#endif
+  return ::operator new(iSize);
+}
+
+void HugePageMemory::deallocate(void* iPointer, const std::size_t iSize) noexcept {
+  if (isHugePageBlock(iSize)) {
+    std::free(iPointer);
+  } else {
+    ::operator delete(iPointer);
+  }
+}
+
+bool HugePageMemory::isHugePageBlock(const std::size_t iSize) noexcept {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  return iSize >= kHugePageSize;
+#else
+  static_cast<void>(iSize);
+  return false;
+#endif
+}
+
+}  // namespace kpuzzle4
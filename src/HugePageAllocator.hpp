@@ -0,0 +1,82 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__HUGE_PAGE_ALLOCATOR__HPP
+#define KPUZZLE4__HUGE_PAGE_ALLOCATOR__HPP
+#include <cstddef>
+#include <new>
+
+namespace kpuzzle4 {
+
+/*! \brief Allocation of memory backed by huge pages (2MB), to reduce the TLB
+ *  misses of the random lookups in large tables.
+ *  A block of at least one huge page is aligned to the huge page and advised as
+ *  huge pages (transparent huge pages on Linux). In case huge pages are not
+ *  available the block is made of regular pages. Smaller blocks are regular
+ *  allocations.
+ */
+class HugePageMemory {
+ public:
+  static constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+
+  /*! \return a block of memory of the given size.
+   *  \throw std::bad_alloc in case it cannot be allocated.
+   */
+  static void* allocate(const std::size_t iSize);
+
+  //! \brief It releases a block returned by `allocate` (with the same size).
+  static void deallocate(void* iPointer, const std::size_t iSize) noexcept;
+
+  //! \return whether the block of the given size is aligned and advised as huge pages.
+  static bool isHugePageBlock(const std::size_t iSize) noexcept;
+};
+
+/*! \brief Standard allocator of `HugePageMemory`, e.g., for the cost tables of
+ *  the pattern database.
+ */
+template <typename T>
+class HugePageAllocator {
+ public:
+  using value_type = T;
+
+  HugePageAllocator() noexcept = default;
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+  T* allocate(const std::size_t iNumElements) {
+    return static_cast<T*>(HugePageMemory::allocate(iNumElements * sizeof(T)));
+  }
+
+  void deallocate(T* iPointer, const std::size_t iNumElements) noexcept {
+    HugePageMemory::deallocate(iPointer, iNumElements * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__HUGE_PAGE_ALLOCATOR__HPP
@@ -17,17 +17,24 @@
 */
 #include "Kpuzzle4.hpp"
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <csignal>
+#include <cstdint>
 #include <cxxopts.hpp>
-#include <fstream>
 #include <future>
 #include <iostream>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "AlgorithmIDA.hpp"
-#include "DistanceManhattan.hpp"
+#include "DynamicPatternDB.hpp"
+#include "SolutionCache.hpp"
+#include "SolverDaemon.hpp"
 
 namespace {
 
@@ -97,32 +104,90 @@ std::optional<kpuzzle4::Kpuzzle4::HeuristicType> parseHeuristicType(const std::s
 
   if (iStr == "MANHATTAN") {
     return Kpuzzle4::HeuristicType::MANHATTAN;
+  } else if (iStr == "MANHATTAN_LC") {
+    return Kpuzzle4::HeuristicType::MANHATTAN_LC;
+  } else if (iStr == "WALKING") {
+    return Kpuzzle4::HeuristicType::WALKING;
   } else if (iStr == "PATTERN") {
     return Kpuzzle4::HeuristicType::PATTERNS;
   }
   return std::nullopt;
 }
 
+/*! \brief Given a string it returns the PatternPartitions associated with it.
+ *  \note it returns an optional null in case of parsing error.
+ */
+std::optional<kpuzzle4::Kpuzzle4::PatternPartitions> parsePatternPartitions(const std::string& iStr) {
+  using kpuzzle4::Kpuzzle4;
+
+  if (iStr == "5-5-5") {
+    return Kpuzzle4::PatternPartitions::P5_5_5;
+  } else if (iStr == "7-8") {
+    return Kpuzzle4::PatternPartitions::P7_8;
+  }
+  return std::nullopt;
+}
+
+/*! \brief Given a string it returns the DualLookup associated with it.
+ *  \note it returns an optional null in case of parsing error.
+ */
+std::optional<kpuzzle4::Kpuzzle4::DualLookup> parseDualLookup(const std::string& iStr) {
+  using kpuzzle4::Kpuzzle4;
+
+  if (iStr == "NONE") {
+    return Kpuzzle4::DualLookup::NONE;
+  } else if (iStr == "MAX") {
+    return Kpuzzle4::DualLookup::MAX;
+  } else if (iStr == "REPLACE") {
+    return Kpuzzle4::DualLookup::REPLACE;
+  }
+  return std::nullopt;
+}
+
+/*! \brief Given a string in the format:
+ *       0xFFFFF0000000000F,0x00000FFFFF00000F,...
+ *  it returns the masks of the partitions of the patterns database.
+ *  \note it returns an optional null in case of parsing error or in case the
+ *  partitions are not valid.
+ */
+std::optional<std::vector<kpuzzle4::State::Mask_t>> parseMaskPartitions(const std::string& iStr) {
+  using kpuzzle4::DynamicPatternDB;
+  using kpuzzle4::State;
+
+  std::vector<State::Mask_t> aMaskPartitions;
+  std::istringstream aSs(iStr);
+  std::string aToken;
+  while (std::getline(aSs, aToken, ',')) {
+    std::istringstream aTokenSs(aToken);
+    State::Mask_t aMask;
+    if (!(aTokenSs >> std::hex >> aMask) || !aTokenSs.eof()) return std::nullopt;
+    aMaskPartitions.push_back(aMask);
+  }
+
+  if (!DynamicPatternDB::isValidPartitions(aMaskPartitions)) return std::nullopt;
+  return aMaskPartitions;
+}
+
 //! \brief It prints the solution as sequence of moves.
-void printSolutionMoves(const kpuzzle4::AlgorithmIDA& iAlgorithmIDA) {
+void printSolutionMoves(const kpuzzle4::SearchNode::Path_t& iPath, const int iLength) {
   std::cout << '[';
 
-  for (int i = 0; i < iAlgorithmIDA.getSolutionLength(); ++i) {
+  for (int i = 0; i < iLength; ++i) {
     if (i != 0) std::cout << ',';
-    std::cout << iAlgorithmIDA.getSolutionPath()[i];
+    std::cout << iPath[i];
   }
 
   std::cout << ']';
 }
 
 //! \brief Ir prints all state as sequence of the solution.
-void printSolutionStates(const kpuzzle4::AlgorithmIDA& iAlgorithmIDA, kpuzzle4::State* ioState) {
+void printSolutionStates(const kpuzzle4::SearchNode::Path_t& iPath, const int iLength, kpuzzle4::State* ioState) {
   std::cout << "--- Solution States ---\n";
   ::printState(*ioState);
   std::cout << '\n';
 
-  for (int i = 0; i < iAlgorithmIDA.getSolutionLength(); ++i) {
-    switch (iAlgorithmIDA.getSolutionPath()[i]) {
+  for (int i = 0; i < iLength; ++i) {
+    switch (iPath[i]) {
       case 'L':
         ioState->moveLeft(ioState);
         break;
@@ -143,6 +208,16 @@ void printSolutionStates(const kpuzzle4::AlgorithmIDA& iAlgorithmIDA, kpuzzle4::
   std::cout << "-----------------------\n";
 }
 
+//! \brief The daemon to stop when a termination signal is received.
+std::atomic<kpuzzle4::SolverDaemon*> sDaemonRunning = nullptr;
+
+//! \brief Signal handler which stops the daemon running.
+void stopDaemon(int) {
+  if (kpuzzle4::SolverDaemon* aSolverDaemon = ::sDaemonRunning) {
+    aSolverDaemon->stop();
+  }
+}
+
 }  // anonymous namespace
 
 namespace kpuzzle4 {
@@ -159,7 +234,67 @@ Kpuzzle4::OptionParsed Kpuzzle4::parseCommandLine(int argc, char* argv[]) {
                       "algorithm",
                       "Select the heuristic algorithm to use.",
                       ::cxxopts::value<std::string>(),
-                      "{MANHATTAN|PATTERN}");
+                      "{MANHATTAN|MANHATTAN_LC|WALKING|PATTERN}");
+  aOptions.add_option("",
+                      "p",
+                      "patterns",
+                      "Select the partitions of the patterns database (default 5-5-5).",
+                      ::cxxopts::value<std::string>(),
+                      "{5-5-5|7-8|MASK,MASK,...}");
+  aOptions.add_option("",
+                      "z",
+                      "compression",
+                      "Lossy compression factor of the patterns database (power of two, default 1).",
+                      ::cxxopts::value<int>(),
+                      "FACTOR");
+  aOptions.add_option("",
+                      "r",
+                      "reflected",
+                      "Looks up the patterns database also on the state reflected about the main diagonal (max).",
+                      ::cxxopts::value<bool>(),
+                      "");
+  aOptions.add_option("",
+                      "u",
+                      "dual",
+                      "Looks up the patterns database on the dual state (default NONE).",
+                      ::cxxopts::value<std::string>(),
+                      "{NONE|MAX|REPLACE}");
+  aOptions.add_option("",
+                      "k",
+                      "packed",
+                      "Packs the entries of the patterns database in 4 bits (half the memory).",
+                      ::cxxopts::value<bool>(),
+                      "");
+  aOptions.add_option("",
+                      "y",
+                      "lazy",
+                      "Computes the entries of the patterns database on demand (when its file does not exist).",
+                      ::cxxopts::value<bool>(),
+                      "");
+  aOptions.add_option("",
+                      "l",
+                      "linear-conflict",
+                      "Combines the patterns database with the linear conflicts (max).",
+                      ::cxxopts::value<bool>(),
+                      "");
+  aOptions.add_option("",
+                      "m",
+                      "memory",
+                      "Generates the patterns database on disk within this memory (MB).",
+                      ::cxxopts::value<int>(),
+                      "MB");
+  aOptions.add_option("",
+                      "x",
+                      "mmap",
+                      "Maps the file of the patterns database in memory (shared among processes).",
+                      ::cxxopts::value<bool>(),
+                      "");
+  aOptions.add_option("",
+                      "f",
+                      "prefetch",
+                      "Prefetches the entries of the patterns database of the children of a node.",
+                      ::cxxopts::value<bool>(),
+                      "");
   aOptions.add_option("",
                       "s",
                       "state",
@@ -167,6 +302,24 @@ Kpuzzle4::OptionParsed Kpuzzle4::parseCommandLine(int argc, char* argv[]) {
                       ::cxxopts::value<std::string>(),
                       "{RANDOM|0,1,2,3,...}");
   aOptions.add_option("", "i", "interactive", "Enables the interactive mode.", ::cxxopts::value<bool>(), "");
+  aOptions.add_option("",
+                      "c",
+                      "cache",
+                      "Enables the persistent cache of solutions (shared among processes and daemon workers).",
+                      ::cxxopts::value<std::string>(),
+                      "FILE");
+  aOptions.add_option("",
+                      "d",
+                      "daemon",
+                      "Runs as daemon serving the requests on a Unix domain socket.",
+                      ::cxxopts::value<std::string>(),
+                      "SOCKET");
+  aOptions.add_option("",
+                      "w",
+                      "workers",
+                      "Number of requests served concurrently by the daemon.",
+                      ::cxxopts::value<int>(),
+                      "N");
 
   try {
     auto aParseResult = aOptions.parse(argc, argv);
@@ -182,11 +335,73 @@ Kpuzzle4::OptionParsed Kpuzzle4::parseCommandLine(int argc, char* argv[]) {
     } else if (auto aHeuristicType = parseHeuristicType(aParseResult["algorithm"].as<std::string>())) {
       aOptionParsed._heuristicType = *aHeuristicType;
     } else {
-      std::cerr << "ALG_TYPE can be: 'MANHATTAN' or 'PATTERN'.\n";
+      std::cerr << "ALG_TYPE can be: 'MANHATTAN', 'MANHATTAN_LC', 'WALKING' or 'PATTERN'.\n";
+      std::exit(-1);
+    }
+
+    if (aParseResult.count("patterns") == 0) {
+      aOptionParsed._patternPartitions = PatternPartitions::P5_5_5;
+    } else if (auto aPatternPartitions = parsePatternPartitions(aParseResult["patterns"].as<std::string>())) {
+      aOptionParsed._patternPartitions = *aPatternPartitions;
+    } else if (auto aMaskPartitions = parseMaskPartitions(aParseResult["patterns"].as<std::string>())) {
+      aOptionParsed._patternPartitions = PatternPartitions::CUSTOM;
+      aOptionParsed._customMaskPartitions = std::move(*aMaskPartitions);
+    } else {
+      std::cerr << "PATTERNS can be: '5-5-5', '7-8' or valid partitions masks (e.g., "
+                   "'0xFFFFF0000000000F,0x00000FFFFF00000F,0x0000000000FFFFFF').\n";
+      std::exit(-1);
+    }
+
+    aOptionParsed._compressionFactor = aParseResult.count("compression") ? aParseResult["compression"].as<int>() : 1;
+    if (aOptionParsed._compressionFactor <= 0 ||
+        (aOptionParsed._compressionFactor & (aOptionParsed._compressionFactor - 1)) != 0) {
+      std::cerr << "FACTOR must be a power of two.\n";
+      std::exit(-1);
+    }
+
+    aOptionParsed._dualLookup = DualLookup::NONE;
+    if (aParseResult.count("dual")) {
+      if (auto aDualLookup = parseDualLookup(aParseResult["dual"].as<std::string>())) {
+        aOptionParsed._dualLookup = *aDualLookup;
+      } else {
+        std::cerr << "DUAL can be: 'NONE', 'MAX' or 'REPLACE'.\n";
+        std::exit(-1);
+      }
+    }
+
+    aOptionParsed._reflectedLookup = aParseResult.count("reflected") > 0;
+    aOptionParsed._packedStorage = aParseResult.count("packed") > 0;
+    aOptionParsed._maxLinearConflict = aParseResult.count("linear-conflict") > 0;
+    aOptionParsed._lazyGeneration = aParseResult.count("lazy") > 0;
+    aOptionParsed._prefetch = aParseResult.count("prefetch") > 0;
+    aOptionParsed._mappedPatternDB = aParseResult.count("mmap") > 0;
+    aOptionParsed._generationMemoryLimit = aParseResult.count("memory") ? aParseResult["memory"].as<int>() : 0;
+    if (aOptionParsed._generationMemoryLimit < 0) {
+      std::cerr << "MB cannot be negative.\n";
+      std::exit(-1);
+    }
+    if (aOptionParsed._lazyGeneration && (aOptionParsed._compressionFactor != 1 || aOptionParsed._packedStorage)) {
+      std::cerr << "--lazy cannot be used with --compression or --packed.\n";
       std::exit(-1);
     }
+    if (aOptionParsed._packedStorage && aOptionParsed._compressionFactor != 1) {
+      std::cerr << "--packed cannot be used with --compression.\n";
+      std::exit(-1);
+    }
+
+    if (aParseResult.count("daemon")) {
+      aOptionParsed._daemonSocketPath = aParseResult["daemon"].as<std::string>();
+    }
+
+    aOptionParsed._numWorkers = aParseResult.count("workers") ? aParseResult["workers"].as<int>()
+                                                              : static_cast<int>(std::thread::hardware_concurrency());
+    if (aOptionParsed._numWorkers <= 0) {
+      aOptionParsed._numWorkers = 1;
+    }
 
-    if (aParseResult.count("state") == 0) {
+    if (!aOptionParsed._daemonSocketPath.empty()) {
+      // The state is sent by the clients.
+    } else if (aParseResult.count("state") == 0) {
       std::cerr << "--state option is mandatory.\n";
       std::exit(-1);
     } else if (auto aInitialState = parseInitialState(aParseResult["state"].as<std::string>())) {
@@ -197,6 +412,10 @@ Kpuzzle4::OptionParsed Kpuzzle4::parseCommandLine(int argc, char* argv[]) {
     }
 
     aOptionParsed._interactive = aParseResult.count("interactive");
+
+    if (aParseResult.count("cache")) {
+      aOptionParsed._cacheFileName = aParseResult["cache"].as<std::string>();
+    }
   } catch (const cxxopts::OptionException& aError) {
     std::cerr << aError.what() << ".\n";
     std::exit(-1);
@@ -205,23 +424,10 @@ Kpuzzle4::OptionParsed Kpuzzle4::parseCommandLine(int argc, char* argv[]) {
   return aOptionParsed;
 }
 
-Kpuzzle4::HeuristicFnHandler_t Kpuzzle4::getHeuristicHandler(const HeuristicType iHeuristicType) const {
-  switch (iHeuristicType) {
-    case HeuristicType::MANHATTAN:
-      return DistanceManhattan::computeDistanceWithFinal;
-      break;
-    case HeuristicType::PATTERNS:
-      return std::bind(&PatternDB_t::getCost, _patternDB, std::placeholders::_1);
-      break;
-  }
-
-  throw std::runtime_error("Heuristic function not recognized!");
-}
-
-bool Kpuzzle4::solveProblem(const State& iInitialState,
-                            const HeuristicFnHandler_t& iHeuristicFnHandler,
-                            const bool iInteractive,
-                            AlgorithmIDA* oAlgorithmIDA) {
+Solver::Solution_t Kpuzzle4::solveProblem(const State& iInitialState,
+                                          const Solver& iSolver,
+                                          const bool iInteractive,
+                                          AlgorithmIDA* oAlgorithmIDA) {
   if constexpr (sizeof(void*) < sizeof(std::uint64_t)) {
     std::cout << "[Warning]: No 64bit Architecture detected.\n";
   }
@@ -232,11 +438,10 @@ bool Kpuzzle4::solveProblem(const State& iInitialState,
     std::cout.flush();
   };
 
-  auto aSolverStatus = std::async(iInteractive ? std::launch::async : std::launch::deferred,
-                                  &AlgorithmIDA::findSolution<const HeuristicFnHandler_t&>,
-                                  oAlgorithmIDA,
-                                  std::ref(iInitialState),
-                                  std::ref(iHeuristicFnHandler));
+  auto aSolverStatus =
+      std::async(iInteractive ? std::launch::async : std::launch::deferred, [&iInitialState, &iSolver, oAlgorithmIDA]() {
+        return iSolver.solve(iInitialState, oAlgorithmIDA);
+      });
 
   std::cout << "Initial State: ";
   ::printState(iInitialState);
@@ -252,70 +457,158 @@ bool Kpuzzle4::solveProblem(const State& iInitialState,
 
   aStatsPrinter();
 
-  const AlgorithmIDA::SolverResult_t aResult = aSolverStatus.get();
+  const Solver::Solution_t aSolution = aSolverStatus.get();
 
-  std::cout << "\nTime Elapsed: " << std::chrono::duration_cast<std::chrono::milliseconds>(aResult._timeElapsed).count()
+  std::cout << "\nTime Elapsed: " << std::chrono::duration_cast<std::chrono::milliseconds>(aSolution._timeElapsed).count()
             << " [ms]\n";
+  if (aSolution._cacheMisses != -1) {
+    std::cout << "Cache Misses: " << aSolution._cacheMisses << '\n';
+  }
 
-  return aResult._solutionFound;
+  return aSolution;
 }
 
-void Kpuzzle4::printSolutionDetails(const AlgorithmIDA& iAlgorithmIDA, State iInitialState) {
-  std::cout << "No. Moves Optional Solution: " << iAlgorithmIDA.getSolutionLength() << '\n';
+void Kpuzzle4::printSolutionDetails(const SearchNode::Path_t& iPath, const int iLength, State iInitialState) {
+  std::cout << "No. Moves Optional Solution: " << iLength << '\n';
   std::cout << "Optional Solution Moves: ";
-  ::printSolutionMoves(iAlgorithmIDA);
+  ::printSolutionMoves(iPath, iLength);
   std::cout << '\n';
   std::cout << '\n';
 
-  ::printSolutionStates(iAlgorithmIDA, &iInitialState);
+  ::printSolutionStates(iPath, iLength, &iInitialState);
+}
+
+Solver::Options_t Kpuzzle4::createSolverOptions(const OptionParsed& iOptionParsed) {
+  Solver::Options_t aSolverOptions;
+  aSolverOptions._heuristicType = iOptionParsed._heuristicType;
+  aSolverOptions._patternPartitions = iOptionParsed._patternPartitions;
+  aSolverOptions._compressionFactor = iOptionParsed._compressionFactor;
+  aSolverOptions._reflectedLookup = iOptionParsed._reflectedLookup;
+  aSolverOptions._dualLookup = iOptionParsed._dualLookup;
+  aSolverOptions._packedStorage = iOptionParsed._packedStorage;
+  aSolverOptions._maxLinearConflict = iOptionParsed._maxLinearConflict;
+  aSolverOptions._lazyGeneration = iOptionParsed._lazyGeneration;
+  aSolverOptions._prefetch = iOptionParsed._prefetch;
+  aSolverOptions._mappedPatternDB = iOptionParsed._mappedPatternDB;
+  aSolverOptions._generationMemoryLimit = static_cast<std::uint64_t>(iOptionParsed._generationMemoryLimit) << 20;
+  aSolverOptions._customMaskPartitions = iOptionParsed._customMaskPartitions;
+
+  switch (iOptionParsed._patternPartitions) {
+    case PatternPartitions::P5_5_5:
+      aSolverOptions._fileNamePatternDB = Solver::kFileNamePatternDB;
+      break;
+    case PatternPartitions::P7_8:
+      aSolverOptions._fileNamePatternDB = Solver::kFileNamePatternDB78;
+      break;
+    case PatternPartitions::CUSTOM: {
+      // A file for each model of partitions.
+      std::ostringstream aFileName;
+      aFileName << "patternDB" << std::hex;
+      for (const auto aMask : iOptionParsed._customMaskPartitions) {
+        aFileName << '_' << aMask;
+      }
+      aFileName << ".data";
+      aSolverOptions._fileNamePatternDB = aFileName.str();
+      break;
+    }
+  }
+  aSolverOptions._log = &std::cout;
+  return aSolverOptions;
+}
+
+std::optional<SolutionCache> Kpuzzle4::openSolutionCache(const std::string& iFileName) {
+  std::optional<SolutionCache> aSolutionCache;
+  if (iFileName.empty()) return aSolutionCache;
+
+  try {
+    aSolutionCache.emplace(iFileName.c_str());
+  } catch (const std::runtime_error& aError) {
+    std::cerr << "[Warning]: " << aError.what() << ". The cache is not used.\n";
+  }
+  return aSolutionCache;
+}
+
+int Kpuzzle4::runDaemon(const OptionParsed& iOptionParsed) {
+  const Solver aSolver{createSolverOptions(iOptionParsed)};
+  std::optional<SolutionCache> aSolutionCache = openSolutionCache(iOptionParsed._cacheFileName);
+
+  SolverDaemon aSolverDaemon{aSolver,
+                             iOptionParsed._daemonSocketPath,
+                             iOptionParsed._numWorkers,
+                             aSolutionCache ? &*aSolutionCache : nullptr};
+
+  ::sDaemonRunning = &aSolverDaemon;
+  std::signal(SIGINT, ::stopDaemon);
+  std::signal(SIGTERM, ::stopDaemon);
+
+  std::cout << "Listening on: " << iOptionParsed._daemonSocketPath << " (" << iOptionParsed._numWorkers
+            << " workers)\n";
+  std::cout.flush();
+
+  try {
+    aSolverDaemon.run();
+  } catch (const std::runtime_error& aError) {
+    ::sDaemonRunning = nullptr;
+    std::cerr << aError.what() << ".\n";
+    return -1;
+  }
+
+  ::sDaemonRunning = nullptr;
+  std::cout << "Daemon stopped\n";
+  return 0;
 }
 
 int Kpuzzle4::run(int argc, char* argv[]) {
   const auto aOptionParsed = parseCommandLine(argc, argv);
 
-  if (aOptionParsed._heuristicType == HeuristicType::PATTERNS) {
-    initializePatternDB();
+  if (!aOptionParsed._daemonSocketPath.empty()) {
+    return runDaemon(aOptionParsed);
+  }
+
+  std::optional<SolutionCache> aSolutionCache = openSolutionCache(aOptionParsed._cacheFileName);
+  if (aSolutionCache) {
+    SearchNode::Path_t aPath;
+    int aLength;
+    try {
+      if (aSolutionCache->find(aOptionParsed._initialState, &aPath, &aLength)) {
+        std::cout << "Initial State: ";
+        ::printState(aOptionParsed._initialState);
+        std::cout << "\nFound Solution (cache): true\n";
+        printSolutionDetails(aPath, aLength, aOptionParsed._initialState);
+        return 0;
+      }
+    } catch (const std::runtime_error& aError) {
+      std::cerr << "[Warning]: " << aError.what() << ". The cache is not used.\n";
+      aSolutionCache.reset();
+    }
   }
 
-  const auto aHeuristicFunction = getHeuristicHandler(aOptionParsed._heuristicType);
+  Solver::Options_t aSolverOptions = createSolverOptions(aOptionParsed);
+  aSolverOptions._countCacheMisses = true;
+  const Solver aSolver{std::move(aSolverOptions)};
 
   AlgorithmIDA aAlgorithmIDA;
-  const auto aSolutionFound =
-      solveProblem(aOptionParsed._initialState, aHeuristicFunction, aOptionParsed._interactive, &aAlgorithmIDA);
+  const auto aSolution = solveProblem(aOptionParsed._initialState, aSolver, aOptionParsed._interactive, &aAlgorithmIDA);
 
-  if (!aSolutionFound) {
+  if (!aSolution._solutionFound) {
     std::cout << "Solution not found\n";
     return -1;
   }
 
+  if (aSolutionCache) {
+    try {
+      aSolutionCache->insert(aOptionParsed._initialState, aSolution._path, aSolution._length);
+    } catch (const std::runtime_error& aError) {
+      std::cerr << "[Warning]: " << aError.what() << ". The solution is not cached.\n";
+    }
+  }
+
   std::cout << "Found Solution: true\n";
-  printSolutionDetails(aAlgorithmIDA, aOptionParsed._initialState);
+  printSolutionDetails(aSolution._path, aSolution._length, aOptionParsed._initialState);
 
   return 0;
 }
 
-void Kpuzzle4::initializePatternDB() {
-  std::ifstream aFile(kFileNamePatternDB, std::ios_base::binary);
-  if (aFile.fail()) {
-    std::cout << "Generating Patterns Database...\n";
-    _patternDB.generate();
-    savePatternDBOnFile(kFileNamePatternDB);
-    std::cout << "Done\n";
-  } else {
-    std::cout << "Load Patterns Database...\n";
-    _patternDB.deserialize(&aFile);
-    std::cout << "Done\n";
-  }
-}
-
-void Kpuzzle4::savePatternDBOnFile(const char* iFileName) const {
-  std::ofstream oFile(iFileName, std::ios_base::binary);
-  if (oFile.fail()) {
-    throw std::runtime_error("Cannot save the Pattern Database");
-  }
-  _patternDB.serialize(&oFile);
-}
-
 }  // namespace kpuzzle4
 
 int main(int argc, char* argv[]) {
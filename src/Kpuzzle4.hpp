@@ -18,62 +18,76 @@
 #ifndef KPUZZLE4__KPUZZLE4__HPP
 #define KPUZZLE4__KPUZZLE4__HPP
 #include <chrono>
-#include <functional>
 #include <optional>
 #include <string>
+#include <vector>
 #include "AlgorithmIDA.hpp"
-#include "PatternDB.hpp"
 #include "SearchNode.hpp"
+#include "SolutionCache.hpp"
+#include "Solver.hpp"
 #include "State.hpp"
 
 namespace kpuzzle4 {
 
 class Kpuzzle4 {
  public:
-  enum class HeuristicType { MANHATTAN, PATTERNS };
+  using HeuristicType = Solver::HeuristicType;
+  using PatternPartitions = Solver::PatternPartitions;
+  using DualLookup = Solver::DualLookup;
 
   int run(int argc, char* argv[]);
 
  private:
-  using HeuristicFnHandler_t = std::function<SearchNode::Cost_t(const State&)>;
-  static constexpr std::array<State::Mask_t, 3> kMasksPattern = {0xFFFFF0000000000F,
-                                                                 0x00000FFFFF00000F,
-                                                                 0x0000000000FFFFFF};
-  using PatternDB_t = PatternDB<std::get<0>(kMasksPattern), std::get<1>(kMasksPattern), std::get<2>(kMasksPattern)>;
-  static_assert(PatternDB_t::isValidPartitions());
-
-  PatternDB_t _patternDB;
-
   static constexpr const char* kProgramName = "kpuzzle4";
-  static constexpr const char* kFileNamePatternDB = "patternDB.data";
   static constexpr auto kRefreshScreenPeriod = std::chrono::milliseconds(200);
 
   struct OptionParsed {
     HeuristicType _heuristicType;
+    PatternPartitions _patternPartitions;
+    std::vector<State::Mask_t> _customMaskPartitions;
+    int _compressionFactor;
+    bool _reflectedLookup;
+    DualLookup _dualLookup;
+    bool _packedStorage;
+    bool _maxLinearConflict;
+    bool _lazyGeneration;
+    bool _prefetch;
+    int _generationMemoryLimit;
+    bool _mappedPatternDB;
     State _initialState;
     bool _interactive;
+    std::string _cacheFileName;
+    std::string _daemonSocketPath;
+    int _numWorkers;
   };
 
-  //! \return the proper function handler in accordance with the input.
-  HeuristicFnHandler_t getHeuristicHandler(const HeuristicType iHeuristicType) const;
+  //! \return the options of the solver session.
+  static Solver::Options_t createSolverOptions(const OptionParsed& iOptionParsed);
 
-  void initializePatternDB();
+  /*! \brief Opens the cache of solutions, if a file is given.
+   *  \return an optional null in case the cache cannot be opened (a warning is
+   *  printed): the problems are solved without the cache.
+   */
+  static std::optional<SolutionCache> openSolutionCache(const std::string& iFileName);
 
-  void savePatternDBOnFile(const char* iFileName) const;
+  /*! \brief Runs the daemon serving the requests on the socket until a
+   *  termination signal is received.
+   */
+  static int runDaemon(const OptionParsed& iOptionParsed);
 
-  /*! \brief Solve the problem with AlgorithmIDA.
+  /*! \brief Solve the problem with the solver session.
    *  \note This function will print information on the standard output.
-   *  \return true if the optimal solution has been found.
+   *  \return the solution found.
    */
-  static bool solveProblem(const State& iInitialState,
-                           const HeuristicFnHandler_t& iHeuristicFHnandler,
-                           const bool iInteractive,
-                           AlgorithmIDA* oAlgorithmIDA);
+  static Solver::Solution_t solveProblem(const State& iInitialState,
+                                         const Solver& iSolver,
+                                         const bool iInteractive,
+                                         AlgorithmIDA* oAlgorithmIDA);
 
-  /*! \brief After the AlgorithmIDA has found a solution, this function prints
-   * on the standard output the details of the solution itself.
+  /*! \brief After a solution has been found, this function prints on the
+   * standard output the details of the solution itself.
    */
-  static void printSolutionDetails(const AlgorithmIDA& iAlgorithmIDA, State iInitialState);
+  static void printSolutionDetails(const SearchNode::Path_t& iPath, const int iLength, State iInitialState);
 
   /*! \brief It parses the command line and generate the options.
    *  This function will invoke `std::exit` in case of error.
@@ -0,0 +1,315 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kpuzzle4 {
+
+#ifdef _WIN32
+
+namespace {
+
+// The lock is taken on a byte beyond the end of the file: the locks of Windows are mandatory on the bytes locked.
+constexpr DWORD kLockOffset = 0xFFFFFFFF;
+
+}  // anonymous namespace
+
+MappedFile::MappedFile(const char* iFileName, const std::uint64_t iSize) : _size(iSize), _fileName(iFileName) {
+  if (_size == 0) {
+    throw std::runtime_error(std::string("Cannot map an empty file: ") + iFileName);
+  }
+
+  _fileHandle = ::CreateFileA(iFileName,
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (_fileHandle == INVALID_HANDLE_VALUE) {
+    _fileHandle = nullptr;
+    throw std::runtime_error(std::string("Cannot open the file: ") + iFileName);
+  }
+
+  // The file is truncated only once locked: it may be mapped by another writer.
+  OVERLAPPED aOverlapped = {};
+  aOverlapped.Offset = kLockOffset;
+  if (!::LockFileEx(_fileHandle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &aOverlapped)) {
+    close();
+    throw std::runtime_error(std::string("The file is locked by another process: ") + iFileName);
+  }
+
+  if (!::SetEndOfFile(_fileHandle)) {
+    close();
+    throw std::runtime_error(std::string("Cannot resize the file: ") + iFileName);
+  }
+
+  _mappingHandle = ::CreateFileMappingA(_fileHandle,
+                                        nullptr,
+                                        PAGE_READWRITE,
+                                        static_cast<DWORD>(_size >> 32),
+                                        static_cast<DWORD>(_size & 0xFFFFFFFF),
+                                        nullptr);
+  if (_mappingHandle == nullptr) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+
+  _data = static_cast<char*>(::MapViewOfFile(_mappingHandle, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0));
+  if (_data == nullptr) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+}
+
+MappedFile::MappedFile(const char* iFileName, const Access iAccess) : _fileName(iFileName) {
+  const bool aWritable = iAccess == Access::READ_WRITE;
+  _fileHandle = ::CreateFileA(iFileName,
+                              aWritable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (_fileHandle == INVALID_HANDLE_VALUE) {
+    _fileHandle = nullptr;
+    throw std::runtime_error(std::string("Cannot open the file: ") + iFileName);
+  }
+
+  LARGE_INTEGER aFileSize;
+  if (!::GetFileSizeEx(_fileHandle, &aFileSize)) {
+    close();
+    throw std::runtime_error(std::string("Cannot read the size of the file: ") + iFileName);
+  }
+
+  _size = static_cast<std::uint64_t>(aFileSize.QuadPart);
+  if (_size == 0) {
+    close();
+    throw std::runtime_error(std::string("Cannot map an empty file: ") + iFileName);
+  }
+
+  _mappingHandle =
+      ::CreateFileMappingA(_fileHandle, nullptr, aWritable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+  if (_mappingHandle == nullptr) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+
+  _data = static_cast<char*>(
+      ::MapViewOfFile(_mappingHandle, aWritable ? FILE_MAP_READ | FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+  if (_data == nullptr) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+}
+
+bool MappedFile::rename(const char* iFileName, const bool iReplace) {
+  if (!::MoveFileExA(_fileName.c_str(), iFileName, iReplace ? MOVEFILE_REPLACE_EXISTING : 0)) {
+    const DWORD aError = ::GetLastError();
+    if (!iReplace && (aError == ERROR_ALREADY_EXISTS || aError == ERROR_FILE_EXISTS)) return false;
+    throw std::runtime_error("Cannot move the file: " + _fileName);
+  }
+  _fileName = iFileName;
+  return true;
+}
+
+void MappedFile::lock() {
+  OVERLAPPED aOverlapped = {};
+  aOverlapped.Offset = kLockOffset;
+  if (!::LockFileEx(_fileHandle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &aOverlapped)) {
+    throw std::runtime_error("Cannot lock the file: " + _fileName);
+  }
+}
+
+void MappedFile::unlock() noexcept {
+  OVERLAPPED aOverlapped = {};
+  aOverlapped.Offset = kLockOffset;
+  ::UnlockFileEx(_fileHandle, 0, 1, 0, &aOverlapped);
+}
+
+void MappedFile::close() noexcept {
+  if (_data != nullptr) ::UnmapViewOfFile(_data);
+  if (_mappingHandle != nullptr) ::CloseHandle(_mappingHandle);
+  if (_fileHandle != nullptr) ::CloseHandle(_fileHandle);
+
+  _data = nullptr;
+  _size = 0;
+  _fileName.clear();
+  _mappingHandle = nullptr;
+  _fileHandle = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& ioOther) noexcept
+    : _data(std::exchange(ioOther._data, nullptr)),
+      _size(std::exchange(ioOther._size, 0)),
+      _fileName(std::move(ioOther._fileName)),
+      _fileHandle(std::exchange(ioOther._fileHandle, nullptr)),
+      _mappingHandle(std::exchange(ioOther._mappingHandle, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& ioOther) noexcept {
+  if (this != &ioOther) {
+    close();
+    _data = std::exchange(ioOther._data, nullptr);
+    _size = std::exchange(ioOther._size, 0);
+    _fileName = std::move(ioOther._fileName);
+    _fileHandle = std::exchange(ioOther._fileHandle, nullptr);
+    _mappingHandle = std::exchange(ioOther._mappingHandle, nullptr);
+  }
+  return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const char* iFileName, const std::uint64_t iSize) : _size(iSize), _fileName(iFileName) {
+  if (_size == 0) {
+    throw std::runtime_error(std::string("Cannot map an empty file: ") + iFileName);
+  }
+
+  _fileDescriptor = ::open(iFileName, O_RDWR | O_CREAT, 0644);
+  if (_fileDescriptor == -1) {
+    throw std::runtime_error(std::string("Cannot open the file: ") + iFileName);
+  }
+
+  // The file is truncated only once locked: it may be mapped by another writer.
+  if (::flock(_fileDescriptor, LOCK_EX | LOCK_NB) == -1) {
+    close();
+    throw std::runtime_error(std::string("The file is locked by another process: ") + iFileName);
+  }
+
+  if (::ftruncate(_fileDescriptor, 0) == -1 || ::ftruncate(_fileDescriptor, static_cast<off_t>(iSize)) == -1) {
+    close();
+    throw std::runtime_error(std::string("Cannot resize the file: ") + iFileName);
+  }
+
+  void* aAddress = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fileDescriptor, 0);
+  if (aAddress == MAP_FAILED) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+
+  _data = static_cast<char*>(aAddress);
+}
+
+MappedFile::MappedFile(const char* iFileName, const Access iAccess) : _fileName(iFileName) {
+  const bool aWritable = iAccess == Access::READ_WRITE;
+  _fileDescriptor = ::open(iFileName, aWritable ? O_RDWR : O_RDONLY);
+  if (_fileDescriptor == -1) {
+    throw std::runtime_error(std::string("Cannot open the file: ") + iFileName);
+  }
+
+  struct stat aFileStat;
+  if (::fstat(_fileDescriptor, &aFileStat) == -1) {
+    close();
+    throw std::runtime_error(std::string("Cannot read the size of the file: ") + iFileName);
+  }
+
+  _size = static_cast<std::uint64_t>(aFileStat.st_size);
+  if (_size == 0) {
+    close();
+    throw std::runtime_error(std::string("Cannot map an empty file: ") + iFileName);
+  }
+
+  void* aAddress =
+      ::mmap(nullptr, _size, aWritable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _fileDescriptor, 0);
+  if (aAddress == MAP_FAILED) {
+    close();
+    throw std::runtime_error(std::string("Cannot map the file: ") + iFileName);
+  }
+
+  _data = static_cast<char*>(aAddress);
+}
+
+bool MappedFile::rename(const char* iFileName, const bool iReplace) {
+  if (iReplace) {
+    if (::rename(_fileName.c_str(), iFileName) == -1) {
+      throw std::runtime_error("Cannot move the file: " + _fileName);
+    }
+  } else {
+    // A new link fails (atomically) in case the path exists, rename would replace it.
+    if (::link(_fileName.c_str(), iFileName) == -1) {
+      if (errno == EEXIST) return false;
+      throw std::runtime_error("Cannot move the file: " + _fileName);
+    }
+    ::unlink(_fileName.c_str());
+  }
+  _fileName = iFileName;
+  return true;
+}
+
+void MappedFile::lock() {
+  while (::flock(_fileDescriptor, LOCK_EX) == -1) {
+    if (errno != EINTR) {
+      throw std::runtime_error("Cannot lock the file: " + _fileName);
+    }
+  }
+}
+
+void MappedFile::unlock() noexcept {
+  ::flock(_fileDescriptor, LOCK_UN);
+}
+
+void MappedFile::close() noexcept {
+  if (_data != nullptr) ::munmap(_data, _size);
+  if (_fileDescriptor != -1) ::close(_fileDescriptor);
+
+  _data = nullptr;
+  _size = 0;
+  _fileName.clear();
+  _fileDescriptor = -1;
+}
+
+MappedFile::MappedFile(MappedFile&& ioOther) noexcept
+    : _data(std::exchange(ioOther._data, nullptr)),
+      _size(std::exchange(ioOther._size, 0)),
+      _fileName(std::move(ioOther._fileName)),
+      _fileDescriptor(std::exchange(ioOther._fileDescriptor, -1)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& ioOther) noexcept {
+  if (this != &ioOther) {
+    close();
+    _data = std::exchange(ioOther._data, nullptr);
+    _size = std::exchange(ioOther._size, 0);
+    _fileName = std::move(ioOther._fileName);
+    _fileDescriptor = std::exchange(ioOther._fileDescriptor, -1);
+  }
+  return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+}  // namespace kpuzzle4
@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__MAPPED_FILE__HPP
+#define KPUZZLE4__MAPPED_FILE__HPP
+#include <cstdint>
+#include <string>
+
+namespace kpuzzle4 {
+
+/*! \brief A file mapped in memory (shared, read-write or read-only).
+ *  Changes on the mapped memory are written back on the file by the operating
+ *  system. The processes writing the same file synchronize with lock/unlock:
+ *  the lock is advisory, it does not prevent the access to the mapped memory.
+ */
+class MappedFile {
+ public:
+  enum class Access { READ_ONLY, READ_WRITE };
+
+  //! \brief Default Constructor (no file mapped).
+  MappedFile() = default;
+
+  /*! \brief Creates a file and maps it in memory read-write. An existing file
+   *  is truncated, so it is meant to be a temporary file moved over the final
+   *  one when it is complete (see rename): the other processes never see a
+   *  file partially written.
+   *  \param [in] iFileName   The path of the file to create.
+   *  \param [in] iSize       The size of the file (zero filled).
+   *  \note The file is returned locked (see lock): it is not truncated while
+   *  another process is creating it.
+   *  \throw std::runtime_error in case the file cannot be mapped or it is
+   *  locked.
+   */
+  MappedFile(const char* iFileName, const std::uint64_t iSize);
+
+  /*! \brief Maps an existing file in memory: its pages are read on demand and
+   *  shared with the other processes mapping the file.
+   *  \param [in] iFileName   The path of the file to map.
+   *  \param [in] iAccess     Whether the mapped memory can be written.
+   *  \throw std::runtime_error in case the file cannot be mapped.
+   */
+  explicit MappedFile(const char* iFileName, const Access iAccess = Access::READ_ONLY);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& ioOther) noexcept;
+  MappedFile& operator=(MappedFile&& ioOther) noexcept;
+
+  ~MappedFile();
+
+  //! \return the pointer to the first byte of the mapped file.
+  char* getData() const noexcept {
+    return _data;
+  }
+
+  //! \return the size (in bytes) of the mapped file.
+  std::uint64_t getSize() const noexcept {
+    return _size;
+  }
+
+  /*! \brief Moves the file mapped (read-write) to another path atomically.
+   *  The file stays mapped (and locked, see lock).
+   *  \param [in] iFileName   The new path of the file.
+   *  \param [in] iReplace    Whether a file already on the path is replaced.
+   *  \return false in case a file is already on the path (and not replaced):
+   *  the file is not moved.
+   *  \throw std::runtime_error in case the file cannot be moved.
+   */
+  bool rename(const char* iFileName, const bool iReplace = true);
+
+  /*! \brief Locks the file exclusively: it waits until the other processes (or
+   *  objects) have unlocked it.
+   *  \throw std::runtime_error in case the file cannot be locked.
+   */
+  void lock();
+
+  //! \brief Unlocks the file.
+  void unlock() noexcept;
+
+ private:
+  char* _data = nullptr;
+  std::uint64_t _size = 0;
+  std::string _fileName;
+
+#ifdef _WIN32
+  void* _fileHandle = nullptr;
+  void* _mappingHandle = nullptr;
+#else
+  int _fileDescriptor = -1;
+#endif
+
+  //! \brief Unmaps the file (if any) and closes the handles.
+  void close() noexcept;
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__MAPPED_FILE__HPP
@@ -0,0 +1,1325 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__PATTERN_DB_BASE__HPP
+#define KPUZZLE4__PATTERN_DB_BASE__HPP
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "DistanceManhattan.hpp"
+#include "Crc32c.hpp"
+#include "HugePageAllocator.hpp"
+#include "MappedFile.hpp"
+#include "PatternDBFile.hpp"
+#include "PatternPartition.hpp"
+#include "SearchNode.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief The cost tables of a pattern database and their lookups, whatever
+ *  the partitions are given at compile time (`PatternDB`) or at run time
+ *  (`DynamicPatternDB`).
+ *  The derived class has to provide:
+ *    - `int getNumPartitions()`: the number of partitions.
+ *    - `const PatternPartition& getPartition(int)`: the i-th partition.
+ *    - `bool isValidPartitions()`: whether the partitions are valid.
+ *  and to call `initializeSourcePartitions()` once its partitions are set.
+ *  \note When a partition is the reflection about the main diagonal of a
+ *  previous one (e.g., the two 6-tile partitions of a symmetric 6-6-3 split),
+ *  its table is not stored: its lookups are done on the reflected state in the
+ *  table of the other one (the puzzle is symmetric about that diagonal).
+ */
+template <typename Derived>
+class PatternDBBase {
+ public:
+  static_assert(sizeof(SearchNode::Cost_t) == 1, "the tables are serialized as bytes");
+
+  using Mask_t = SearchNode::Mask_t;
+  using Cost_t = SearchNode::Cost_t;
+  using Index_t = PatternPartition::Index_t;
+
+  //! \brief A cost table: large tables are backed by huge pages (see HugePageMemory).
+  using CostTable_t = std::vector<Cost_t, HugePageAllocator<Cost_t>>;
+
+  /*! \brief A cost table with two entries per byte (the even index in the low
+   *  nibble). The entry is the half of the excess of the cost over the
+   *  Manhattan distance of the pattern tiles, saturated at 15 (backed by huge
+   *  pages as well).
+   */
+  using PackedCostTable_t = std::vector<std::uint8_t, HugePageAllocator<std::uint8_t>>;
+
+  /*! \brief It generates the cost tables for all partitions of Pattern.
+   *  The time and space complexity depends on the size of Partitions.
+   *  The partitions are generated one after the other (the memory of the
+   *  search of only one is used at a time), each one with all the threads
+   *  expanding the layers of its search in parallel.
+   *  \param [in] iNumThreads   The number of threads (all the hardware ones by
+   *                             default).
+   *  \note It disables the lazy generation.
+   */
+  void generate(const int iNumThreads = 0);
+
+  /*! \brief Enables the lazy generation: the tables are not generated, each
+   *  entry is computed on its first lookup by a search in the space of the
+   *  pattern (A* with the Manhattan distance of the pattern tiles) and cached.
+   *  The time depends on the entries the instances hit rather than on the
+   *  size of the tables. The lookup is thread safe (copies of the database
+   *  share the cache).
+   *  The tables already generated (or loaded) are dropped.
+   *  \throw std::runtime_error in case of packed storage or compression.
+   *  \note It is disabled by default. A lazy database cannot be serialized.
+   */
+  void setLazyGeneration(const bool iLazyGeneration);
+
+  //! \return whether the lazy generation is enabled.
+  bool isLazyGeneration() const noexcept;
+
+  //! \return the number of entries computed by the lazy generation so far.
+  std::uint64_t getNumLazyEntries() const;
+
+  /*! \return the Cost Table of the i-th partition.
+   *  \note It is empty with the packed storage, when the partition is folded
+   *  by symmetry or when the tables are on a mapped file.
+   */
+  const CostTable_t& getCostTable(const int iPartitionIndex) const noexcept;
+
+  /*! \return the Packed Cost Table of the i-th partition.
+   *  \note It is empty without the packed storage or when the partition is
+   *  folded by symmetry.
+   */
+  const PackedCostTable_t& getPackedCostTable(const int iPartitionIndex) const noexcept;
+
+  /*! \return the partition whose table answers the lookups of the i-th one:
+   *  itself, or a previous partition which is its reflection about the main
+   *  diagonal (the table of the i-th partition is not stored).
+   */
+  int getSourcePartition(const int iPartitionIndex) const noexcept;
+
+  /*! \brief After the PatternDB has been generated is possible to compute an
+   *  heuristic cost (distance from the sorted state) with this method.
+   *  \note With the lazy generation a missing entry is computed and stored,
+   *  which can throw (e.g., `std::bad_alloc`).
+   */
+  Cost_t getCost(const State& iState) const;
+
+  /*! \brief Enables the reflected lookup: the cost is the max between the
+   *  cost of the state and the cost of the state reflected about the main
+   *  diagonal (with tiles relabeled). The puzzle is symmetric about that
+   *  diagonal so both are admissible, and the same tables are used.
+   *  \note It is disabled by default.
+   */
+  void setReflectedLookup(const bool iReflectedLookup) noexcept;
+
+  //! \return whether the reflected lookup is enabled.
+  bool isReflectedLookup() const noexcept;
+
+  /*! \brief Enables the dual lookup: the cost is the max between the cost of
+   *  the state and the cost of its dual state (the inverse permutation).
+   *  The dual state has the same distance only when the "Space" tile is in
+   *  its goal position, so the dual lookup is done only on those states.
+   *  \note It is disabled by default.
+   *  \see State::getDualState
+   */
+  void setDualLookup(const bool iDualLookup) noexcept;
+
+  //! \return whether the dual lookup is enabled.
+  bool isDualLookup() const noexcept;
+
+  /*! \brief It computes the cost of the dual state (in case it has the same
+   *  distance, otherwise the cost of the state itself).
+   *  Used instead of `getCost`, the heuristic is inconsistent: the cost can
+   *  change by more than one when the "Space" tile reaches its goal position.
+   */
+  Cost_t getCostDual(const State& iState) const;
+
+  //! \return the number of indices written by `prefetch`.
+  int getNumPrefetchIndices() const noexcept;
+
+  /*! \brief It prefetches in cache the entries of the tables the cost of the
+   *  state will be looked up from (also the ones of the reflected lookup, if
+   *  enabled). It should be called ahead of the lookup, e.g., on the children
+   *  of a node when it is expanded, so that the loads of different states
+   *  overlap.
+   *  The indices of the entries are written in `oIndices` (see
+   *  `getNumPrefetchIndices`): `getCostPrefetched` looks them up without
+   *  ranking the state again.
+   *  \note Nothing is prefetched with the lazy generation.
+   */
+  void prefetch(const State& iState, Index_t* oIndices) const noexcept;
+
+  //! \return the same as `getCost`, with the indices written by `prefetch` on the same state.
+  Cost_t getCostPrefetched(const State& iState, const Index_t* iIndices) const;
+
+  /*! \brief Enables the packed storage: the tables take half the memory.
+   *  The cost of an entry is always an even excess over the Manhattan distance
+   *  of its pattern tiles (each move of a pattern tile changes that distance by
+   *  one), so the entry stores only the half of the excess in 4 bits.
+   *  An excess over 30 is saturated: the cost is lower but still admissible.
+   *  The tables already generated (or loaded) are converted.
+   *  \throw std::runtime_error in case of compression or lazy generation.
+   *  \note It is disabled by default.
+   */
+  void setPackedStorage(const bool iPackedStorage);
+
+  //! \return whether the packed storage is enabled.
+  bool isPackedStorage() const noexcept;
+
+  /*! \brief Enables the lossy compression of the tables: each group of
+   *  `iCompressionFactor` consecutive entries (the last tiles of the pattern
+   *  in near positions) is folded into their minimum, so the cost is lower
+   *  but still admissible. With the packed storage the minimum is on the
+   *  excess over the Manhattan distance, which is stronger.
+   *  The tables already generated (or loaded) are folded.
+   *  \param [in] iCompressionFactor  A power of two (1 is no compression).
+   *  \throw std::runtime_error in case the factor is not a power of two or it
+   *  is lower than the current one (the tables cannot be decompressed) or the
+   *  generation is lazy.
+   *  \note A compressed database cannot be serialized.
+   */
+  void setCompressionFactor(const int iCompressionFactor);
+
+  //! \return the compression factor of the tables.
+  int getCompressionFactor() const noexcept;
+
+  //! \return the memory of all tables (in bytes).
+  std::uint64_t getMemoryUsage() const noexcept;
+
+  /*! \return the average cost over all states (the sum of the average cost of
+   *  each partition): the higher the average the stronger the heuristic.
+   *  Along with `getMemoryUsage` it gives the tradeoff of a compression factor.
+   *  \note With the lazy generation the entries are not known: it is the
+   *  average Manhattan distance.
+   */
+  double computeAverageCost() const noexcept;
+
+  /*! \brief It serializes the content of the entire database into a output
+   *  stream, in the latest version of the file (see PatternDBFile): each
+   *  table is written at once, along with its checksum.
+   *  On a seekable stream each table is serialized once (the header with the
+   *  checksums is written again at the end), otherwise twice.
+   *  \note The format does not depend on the storage (packed or not).
+   *  \throw std::runtime_error in case the database is compressed, lazy or
+   *  not generated.
+   */
+  void serialize(std::ostream* oStream) const;
+
+  /*! \brief It deserialies (load) the content of a input stream to construct
+   *  the pattern database. The tables are read in blocks and their checksums
+   *  are verified. The files of the version 1 are rejected (see
+   *  PatternDBFile).
+   *  \note It disables the lazy generation.
+   *  \see serialize
+   *  \throw std::runtime_error in case of file is not compatible, corrupted
+   *  or errors generated.
+   */
+  void deserialize(std::istream* iStream);
+
+  /*! \brief It reads the masks of the partitions from the header of a
+   *  serialized database (the stream is left after the header).
+   *  \throw std::runtime_error in case of errors.
+   */
+  static std::vector<Mask_t> deserializeMaskPartitions(std::istream* iStream);
+
+  /*! \brief It maps a file written by `serialize` in memory and looks up the
+   *  tables straight on it (zero-copy): the loading takes no time, the pages
+   *  of the tables are read by the operating system on demand and they are
+   *  shared with the other processes mapping the same file.
+   *  The tables are copied in memory in case the storage is changed or they
+   *  are compressed later.
+   *  \param [in] iVerifyChecksums   Whether the checksums of the tables are
+   *                                 verified (it reads the whole tables).
+   *  \note It disables the lazy generation.
+   *  \throw std::runtime_error in case the file is not valid, of the version 1
+   *  or the storage is packed or compressed.
+   */
+  void mapFile(const char* iFileName, const bool iVerifyChecksums = false);
+
+  //! \return whether the tables are looked up on a mapped file.
+  bool isMapped() const noexcept;
+
+ protected:
+  std::vector<CostTable_t> _costTablePartitions;
+  std::vector<PackedCostTable_t> _packedCostTablePartitions;
+
+  //! \brief The file the tables are mapped from (copies of the database share it), and the tables on it.
+  std::shared_ptr<const MappedFile> _mappedFile;
+  std::vector<const Cost_t*> _mappedCostTables;
+  bool _packedStorage = false;
+  int _compressionShift = 0;
+  bool _reflectedLookup = false;
+  bool _dualLookup = false;
+
+  //! \brief The entries computed so far: the shards are locked separately.
+  struct LazyCostTable_t {
+    static constexpr int kNumShards = 64;
+
+    struct Shard_t {
+      std::mutex _mutex;
+      std::unordered_map<Index_t, Cost_t> _costs;
+    };
+
+    std::array<Shard_t, kNumShards> _shards;
+  };
+
+  bool _lazyGeneration = false;
+  std::vector<std::shared_ptr<LazyCostTable_t>> _lazyCostTablePartitions;
+
+  //! \see getSourcePartition
+  std::vector<int> _sourcePartitions;
+
+  explicit PatternDBBase(const int iNumPartitions);
+
+  //! \brief It finds the partitions folded by symmetry.
+  void initializeSourcePartitions();
+
+  /*! \return the hash of the state to look up the i-th partition in the table
+   *  of its source partition.
+   */
+  std::uint64_t computeHash(const int iIndexPartition, const State& iState) const noexcept;
+
+  //! \return the derived class (with the partitions).
+  const Derived& derived() const noexcept;
+
+  //! \return whether the dual state has the same distance of the state.
+  static constexpr bool hasDualState(const State& iState) noexcept;
+
+  //! \return the entries of the (not packed) table of a partition: on the mapped file or in memory.
+  const Cost_t* getCostTableData(const int iIndexPartition) const noexcept;
+
+  /*! \return the (not packed) table of a partition as it is serialized:
+   *  unfolded or unpacked in the buffer when needed.
+   *  \throw std::runtime_error in case the table is not generated.
+   */
+  const Cost_t* getSerializedCostTable(const int iIndexPartition, CostTable_t* oBuffer) const;
+
+  /*! \brief It checks whether the partitions of a file are the ones of the
+   *  database and its tables can be read (of the current version).
+   *  \throw std::runtime_error otherwise.
+   */
+  void checkFilePartitions(const PatternDBFile& iFile) const;
+
+  //! \brief It drops the mapped file (the tables on it are no longer looked up).
+  void releaseMappedFile() noexcept;
+
+  //! \brief It copies the tables of the mapped file in memory (if any) and drops it.
+  void copyMappedCostTables();
+
+  //! \brief It prefetches the entries of all partitions of the state (and it writes their indices).
+  void prefetchAdditive(const State& iState, Index_t* oIndices) const noexcept;
+
+  //! \return the sum of the costs of all partitions, with the indices written by `prefetchAdditive`.
+  Cost_t getCostAdditivePrefetched(const State& iState, const Index_t* iIndices) const noexcept;
+
+  //! \return the cost of the state (with the reflected lookup if enabled).
+  Cost_t getCostRegular(const State& iState) const;
+
+  //! \return the sum of the costs of all partitions.
+  Cost_t getCostAdditive(const State& iState) const noexcept;
+
+  //! \return the sum of the costs of all partitions (packed storage).
+  Cost_t getCostAdditivePacked(const State& iState) const noexcept;
+
+  //! \return the sum of the costs of all partitions (lazy generation).
+  Cost_t getCostAdditiveLazy(const State& iState) const;
+
+  //! \return the entry of the i-th partition (computed in case it is missing).
+  Cost_t getLazyEntry(const int iIndexPartition, const std::uint64_t iHash) const;
+
+  /*! \return the cost of an entry: the min number of moves of the pattern
+   *  tiles (from the positions in the hash, whatever the position of the
+   *  "Space" tile) to their goal positions.
+   */
+  static Cost_t searchCost(const PatternPartition& iPartition, const std::uint64_t iHash);
+
+  /*! \brief It builds the (not packed) cost table of a partition folded by
+   *  symmetry from the table of its source partition.
+   */
+  void unfoldCostTable(const int iIndexPartition, CostTable_t* oCostTable) const;
+
+  //! \brief It packs the (not packed) cost table of a partition.
+  static void packCostTable(const PatternPartition& iPartition,
+                            const CostTable_t& iCostTable,
+                            PackedCostTable_t* oPackedCostTable);
+
+  //! \brief It unpacks the packed cost table of a partition.
+  static void unpackCostTable(const PatternPartition& iPartition,
+                              const PackedCostTable_t& iPackedCostTable,
+                              CostTable_t* oCostTable);
+
+  //! \brief Converts the cost table of the i-th partition to the storage in use.
+  void storeCostTable(const int iIndexPartition);
+
+  //! \brief It folds all tables by further `1 << iShift` entries.
+  void foldCostTables(const int iShift);
+
+  //! \return the number of entries in the table of a partition (with compression).
+  std::uint64_t computeNumEntries(const PatternPartition& iPartition) const noexcept;
+
+  //! \return the entry of a packed cost table.
+  static std::uint8_t getPackedEntry(const PackedCostTable_t& iPackedCostTable, const Index_t iIndex) noexcept;
+
+  /*! \brief It generates the cost table of a partition with a breadth-first
+   *  search in the space of the pattern (the positions of its tiles and the
+   *  region of the "Space" tile), backwards from the goal. The entries are
+   *  exact: the same as `searchCost`.
+   *  \param [in] iNumThreads   The threads expanding each layer of the search
+   *                             (the same ones for all layers).
+   */
+  static void bfs(const PatternPartition& iPartition, const int iNumThreads, CostTable_t* oCostTable);
+};
+
+template <typename Derived>
+PatternDBBase<Derived>::PatternDBBase(const int iNumPartitions)
+    : _costTablePartitions(iNumPartitions),
+      _packedCostTablePartitions(iNumPartitions),
+      _mappedCostTables(iNumPartitions, nullptr),
+      _sourcePartitions(iNumPartitions) {}
+
+template <typename Derived>
+void PatternDBBase<Derived>::initializeSourcePartitions() {
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    _sourcePartitions[i] = i;
+
+    const Mask_t aMaskTransposed = PatternPartition::transposeMask(derived().getPartition(i).getMask());
+    for (int j = 0; j < i; ++j) {
+      if (_sourcePartitions[j] == j && derived().getPartition(j).getMask() == aMaskTransposed) {
+        _sourcePartitions[i] = j;
+        break;
+      }
+    }
+  }
+}
+
+template <typename Derived>
+int PatternDBBase<Derived>::getSourcePartition(const int iPartitionIndex) const noexcept {
+  assert(iPartitionIndex < derived().getNumPartitions());
+  return _sourcePartitions[iPartitionIndex];
+}
+
+template <typename Derived>
+std::uint64_t PatternDBBase<Derived>::computeHash(const int iIndexPartition, const State& iState) const noexcept {
+  const int aSourcePartition = _sourcePartitions[iIndexPartition];
+  const PatternPartition& aPartition = derived().getPartition(aSourcePartition);
+
+  return aSourcePartition == iIndexPartition ? iState.getHashWithMask(aPartition.getMask())
+                                             : aPartition.computeTransposedHash(iState.getTilesPositions());
+}
+
+template <typename Derived>
+const Derived& PatternDBBase<Derived>::derived() const noexcept {
+  return static_cast<const Derived&>(*this);
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::generate(const int iNumThreads) {
+  setLazyGeneration(false);
+  releaseMappedFile();
+
+  const int aNumThreads =
+      iNumThreads > 0 ? iNumThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    if (_sourcePartitions[i] == i) bfs(derived().getPartition(i), aNumThreads, &_costTablePartitions[i]);
+  }
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    if (_sourcePartitions[i] == i) storeCostTable(i);
+  }
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::bfs(const PatternPartition& iPartition, const int iNumThreads, CostTable_t* oCostTable) {
+  static constexpr auto kMaxCost = std::numeric_limits<Cost_t>::max();
+  static constexpr int kBitsPerWord = 64;
+  using Layer_t = std::vector<std::uint64_t>;
+
+  // A node is the positions of the pattern tiles and the region of the "Space" tile (its lowest position): all edges
+  // cost one, so the nodes are visited layer by layer in order of cost, and the first node of an entry sets it.
+  // The 16 nodes of an entry are in the same word of the visited bitmap: the thread which sets the first of them (the
+  // word is updated atomically) is the only one writing the entry.
+  oCostTable->assign(iPartition.getSizeOfTable(), kMaxCost);
+  std::vector<std::atomic<std::uint64_t>> aVisited((oCostTable->size() * State::kNumTiles + kBitsPerWord - 1) /
+                                                   kBitsPerWord);
+  const auto aVisit = [&iPartition, &aVisited, oCostTable](const std::uint64_t iHash, const Cost_t iCost) {
+    const Index_t aIndex = iPartition.rank(iHash);
+    const Index_t aIndexVisited = aIndex * State::kNumTiles + (iHash & 0xF);
+    const std::uint64_t aBit = std::uint64_t{1} << (aIndexVisited % kBitsPerWord);
+    std::atomic<std::uint64_t>& aWord = aVisited[aIndexVisited / kBitsPerWord];
+    if (aWord.load(std::memory_order_relaxed) & aBit) return false;
+
+    const std::uint64_t aPrevious = aWord.fetch_or(aBit, std::memory_order_relaxed);
+    if (aPrevious & aBit) return false;
+
+    const std::uint64_t aBitsEntry = std::uint64_t{0xFFFF} << (aIndex * State::kNumTiles % kBitsPerWord);
+    if ((aPrevious & aBitsEntry) == 0) (*oCostTable)[aIndex] = iCost;
+    return true;
+  };
+
+  Layer_t aLayer;
+  std::vector<Layer_t> aNextLayers(iNumThreads);
+  aLayer.push_back(iPartition.normalizeSpace(State::generateSortedState().getHashWithMask(iPartition.getMask())));
+  aVisit(aLayer.front(), 0);
+
+  // Each thread expands a slice of the layer into its own next layer.
+  Cost_t aCost = 1;
+  const auto aExpand = [&iPartition, &aVisit, &aLayer, &aNextLayers, &aCost, iNumThreads](const int iThread) {
+    Layer_t& aNextLayer = aNextLayers[iThread];
+    const std::size_t aBegin = aLayer.size() * iThread / iNumThreads;
+    const std::size_t aEnd = aLayer.size() * (iThread + 1) / iNumThreads;
+    for (std::size_t j = aBegin; j < aEnd; ++j) {
+      iPartition.forEachMove(aLayer[j], [&aVisit, &aNextLayer, aCost](const std::uint64_t iChildHash) {
+        if (aVisit(iChildHash, aCost)) aNextLayer.push_back(iChildHash);
+      });
+    }
+  };
+
+  // The workers are kept for the whole search: each layer starts a new round (the layer is read only by then), and
+  // the calling thread merges the next layers when all workers are done with it.
+  std::mutex aRoundMutex;
+  std::condition_variable aRoundCondition;
+  std::uint64_t aRound = 0;
+  int aNumPending = 0;
+  bool aDone = false;
+  std::exception_ptr aError;
+  const auto aWork = [&](const int iThread) {
+    for (std::uint64_t aRoundWorked = 0;;) {
+      {
+        std::unique_lock<std::mutex> aLock(aRoundMutex);
+        aRoundCondition.wait(aLock, [&aRound, aRoundWorked]() { return aRound != aRoundWorked; });
+        if (aDone) return;
+        aRoundWorked = aRound;
+      }
+      std::exception_ptr aErrorRound;
+      try {
+        aExpand(iThread);
+      } catch (...) {
+        aErrorRound = std::current_exception();
+      }
+      std::lock_guard<std::mutex> aLock(aRoundMutex);
+      if (aErrorRound) aError = aErrorRound;
+      if (--aNumPending == 0) aRoundCondition.notify_all();
+    }
+  };
+
+  std::vector<std::thread> aWorkers;
+  const auto aStopWorkers = [&]() {
+    {
+      std::lock_guard<std::mutex> aLock(aRoundMutex);
+      aDone = true;
+      ++aRound;
+    }
+    aRoundCondition.notify_all();
+    for (std::thread& aWorker : aWorkers) {
+      aWorker.join();
+    }
+  };
+  try {
+    for (int t = 1; t < iNumThreads; ++t) {
+      aWorkers.emplace_back(aWork, t);
+    }
+
+    for (; !aLayer.empty(); ++aCost) {
+      {
+        std::lock_guard<std::mutex> aLock(aRoundMutex);
+        aNumPending = iNumThreads - 1;
+        ++aRound;
+      }
+      aRoundCondition.notify_all();
+
+      // The layer is expanded by the workers until all of them are done, even in case of error.
+      std::exception_ptr aErrorRound;
+      try {
+        aExpand(0);
+      } catch (...) {
+        aErrorRound = std::current_exception();
+      }
+      {
+        std::unique_lock<std::mutex> aLock(aRoundMutex);
+        aRoundCondition.wait(aLock, [&aNumPending]() { return aNumPending == 0; });
+        if (!aErrorRound) aErrorRound = aError;
+      }
+      if (aErrorRound) std::rethrow_exception(aErrorRound);
+
+      // The next layers of the workers are released once merged (only the one of the calling thread is reused).
+      aLayer.swap(aNextLayers[0]);
+      aNextLayers[0].clear();
+      for (int t = 1; t < iNumThreads; ++t) {
+        aLayer.insert(aLayer.end(), aNextLayers[t].cbegin(), aNextLayers[t].cend());
+        Layer_t().swap(aNextLayers[t]);
+      }
+    }
+  } catch (...) {
+    aStopWorkers();
+    throw;
+  }
+  aStopWorkers();
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::setLazyGeneration(const bool iLazyGeneration) {
+  if (iLazyGeneration == _lazyGeneration) return;
+  if (_packedStorage || _compressionShift != 0) {
+    throw std::runtime_error("A packed or compressed PatternDB cannot be lazy");
+  }
+  _lazyGeneration = iLazyGeneration;
+
+  _lazyCostTablePartitions.clear();
+  if (_lazyGeneration) {
+    releaseMappedFile();
+    for (int i = 0; i < derived().getNumPartitions(); ++i) {
+      CostTable_t().swap(_costTablePartitions[i]);
+      _lazyCostTablePartitions.push_back(std::make_shared<LazyCostTable_t>());
+    }
+  }
+}
+
+template <typename Derived>
+bool PatternDBBase<Derived>::isLazyGeneration() const noexcept {
+  return _lazyGeneration;
+}
+
+template <typename Derived>
+std::uint64_t PatternDBBase<Derived>::getNumLazyEntries() const {
+  std::uint64_t aNumEntries = 0;
+  for (const auto& aLazyCostTable : _lazyCostTablePartitions) {
+    for (auto& aShard : aLazyCostTable->_shards) {
+      std::lock_guard<std::mutex> aLock(aShard._mutex);
+      aNumEntries += aShard._costs.size();
+    }
+  }
+  return aNumEntries;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostAdditiveLazy(const State& iState) const {
+  Cost_t aCost = 0;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    aCost += getLazyEntry(_sourcePartitions[i], computeHash(i, iState));
+  }
+
+  return aCost;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getLazyEntry(const int iIndexPartition,
+                                                                             const std::uint64_t iHash) const {
+  const PatternPartition& aPartition = derived().getPartition(iIndexPartition);
+  const Index_t aIndex = aPartition.rank(iHash);
+  auto& aShard = _lazyCostTablePartitions[iIndexPartition]->_shards[aIndex % LazyCostTable_t::kNumShards];
+
+  {
+    std::lock_guard<std::mutex> aLock(aShard._mutex);
+    const auto aFound = aShard._costs.find(aIndex);
+    if (aFound != aShard._costs.end()) return aFound->second;
+  }
+
+  // The search is out of the lock: two threads can compute the same entry (with the same cost).
+  const Cost_t aCost = searchCost(aPartition, iHash);
+
+  std::lock_guard<std::mutex> aLock(aShard._mutex);
+  aShard._costs.emplace(aIndex, aCost);
+  return aCost;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::searchCost(const PatternPartition& iPartition,
+                                                                          const std::uint64_t iHash) {
+  // The hash of a node and its cost.
+  using Node_t = std::pair<std::uint64_t, int>;
+  static constexpr auto kMaxCost = std::numeric_limits<Cost_t>::max();
+  static constexpr int kAllPositions = (1 << State::kNumTiles) - 1;
+
+  // The moves of the "Space" tile among the other tiles are free: a node is the region it can reach (its lowest
+  // position), so that every edge is a move of a pattern tile.
+  const std::uint64_t aGoalHash =
+      iPartition.normalizeSpace(State::generateSortedState().getHashWithMask(iPartition.getMask()));
+
+  // The open list is bucketed by the estimated total cost (the Manhattan distance of the pattern tiles is
+  // consistent): the buckets are expanded in increasing order, a child goes in the same or in the next one.
+  std::vector<std::vector<Node_t>> aBuckets;
+  std::unordered_set<std::uint64_t> aCloseList;
+  const auto aPushNode = [&aBuckets, &iPartition](const std::uint64_t iNodeHash, const int iCost) {
+    const std::size_t aBucket = static_cast<std::size_t>(iCost + iPartition.computeDistance(iNodeHash));
+    if (aBucket >= aBuckets.size()) aBuckets.resize(aBucket + 1);
+    aBuckets[aBucket].push_back({iNodeHash, iCost});
+  };
+
+  // The entry does not depend on the "Space" tile: any region is a start.
+  const std::uint64_t aHashTiles = iHash & ~std::uint64_t{0xF};
+  const int aFreeStart = ~iPartition.computeTakenPositions(iHash) & kAllPositions;
+  for (int aUnvisited = aFreeStart; aUnvisited != 0;) {
+    const int aPosition = PatternPartition::computeLowestPosition(aUnvisited);
+    aUnvisited &= ~PatternPartition::computeRegion(aPosition, aFreeStart);
+    aPushNode(aHashTiles | static_cast<std::uint64_t>(aPosition), 0);
+  }
+
+  for (std::size_t aBucket = 0; aBucket < aBuckets.size(); ++aBucket) {
+    for (std::size_t j = 0; j < aBuckets[aBucket].size(); ++j) {
+      const Node_t aNode = aBuckets[aBucket][j];
+      if (!aCloseList.insert(aNode.first).second) continue;
+      if (aNode.first == aGoalHash) return static_cast<Cost_t>(aNode.second);
+
+      iPartition.forEachMove(aNode.first, [&aPushNode, &aNode](const std::uint64_t iChildHash) {
+        aPushNode(iChildHash, aNode.second + 1);
+      });
+    }
+  }
+
+  // Not reachable (e.g., a permutation of all tiles with the wrong parity).
+  return kMaxCost;
+}
+
+template <typename Derived>
+const typename PatternDBBase<Derived>::CostTable_t& PatternDBBase<Derived>::getCostTable(
+    const int iPartitionIndex) const noexcept {
+  assert(iPartitionIndex < derived().getNumPartitions());
+  return _costTablePartitions[iPartitionIndex];
+}
+
+template <typename Derived>
+const typename PatternDBBase<Derived>::PackedCostTable_t& PatternDBBase<Derived>::getPackedCostTable(
+    const int iPartitionIndex) const noexcept {
+  assert(iPartitionIndex < derived().getNumPartitions());
+  return _packedCostTablePartitions[iPartitionIndex];
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCost(const State& iState) const {
+  const Cost_t aCost = getCostRegular(iState);
+  if (!_dualLookup || !hasDualState(iState)) return aCost;
+
+  return std::max(aCost, getCostRegular(iState.getDualState()));
+}
+
+template <typename Derived>
+int PatternDBBase<Derived>::getNumPrefetchIndices() const noexcept {
+  return _reflectedLookup ? 2 * derived().getNumPartitions() : derived().getNumPartitions();
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::prefetch(const State& iState, Index_t* oIndices) const noexcept {
+  if (_lazyGeneration) return;
+
+  prefetchAdditive(iState, oIndices);
+  if (_reflectedLookup) {
+    prefetchAdditive(iState.getTransposedState(), oIndices + derived().getNumPartitions());
+  }
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::prefetchAdditive(const State& iState, Index_t* oIndices) const noexcept {
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const int aSourcePartition = _sourcePartitions[i];
+    const Index_t aIndex = derived().getPartition(aSourcePartition).rank(computeHash(i, iState)) >> _compressionShift;
+
+    if (_packedStorage) {
+      __builtin_prefetch(_packedCostTablePartitions[aSourcePartition].data() + (aIndex >> 1));
+    } else {
+      __builtin_prefetch(getCostTableData(aSourcePartition) + aIndex);
+    }
+    oIndices[i] = aIndex;
+  }
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostPrefetched(const State& iState,
+                                                                                 const Index_t* iIndices) const {
+  if (_lazyGeneration) return getCost(iState);
+
+  Cost_t aCost = getCostAdditivePrefetched(iState, iIndices);
+  if (_reflectedLookup) {
+    aCost = std::max(aCost,
+                     getCostAdditivePrefetched(iState.getTransposedState(), iIndices + derived().getNumPartitions()));
+  }
+  if (!_dualLookup || !hasDualState(iState)) return aCost;
+
+  return std::max(aCost, getCostRegular(iState.getDualState()));
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostAdditivePrefetched(
+    const State& iState,
+    const Index_t* iIndices) const noexcept {
+  if (!_packedStorage) {
+    Cost_t aCost = 0;
+    for (int i = 0; i < derived().getNumPartitions(); ++i) {
+      aCost += getCostTableData(_sourcePartitions[i])[iIndices[i]];
+    }
+    return aCost;
+  }
+
+  // The same as `getCostAdditivePacked`.
+  const bool aValidPartitions = derived().isValidPartitions();
+  Cost_t aCost = aValidPartitions ? DistanceManhattan::computeDistanceWithFinal(iState) : 0;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const int aSourcePartition = _sourcePartitions[i];
+    if (!aValidPartitions) {
+      aCost += derived().getPartition(aSourcePartition).computeDistance(computeHash(i, iState));
+    }
+    aCost += getPackedEntry(_packedCostTablePartitions[aSourcePartition], iIndices[i]) << 1;
+  }
+
+  return aCost;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostDual(const State& iState) const {
+  return hasDualState(iState) ? getCostRegular(iState.getDualState()) : getCostRegular(iState);
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostRegular(const State& iState) const {
+  if (_lazyGeneration) {
+    const Cost_t aCost = getCostAdditiveLazy(iState);
+    if (!_reflectedLookup) return aCost;
+
+    return std::max(aCost, getCostAdditiveLazy(iState.getTransposedState()));
+  }
+
+  if (_packedStorage) {
+    const Cost_t aCost = getCostAdditivePacked(iState);
+    if (!_reflectedLookup) return aCost;
+
+    return std::max(aCost, getCostAdditivePacked(iState.getTransposedState()));
+  }
+
+  const Cost_t aCost = getCostAdditive(iState);
+  if (!_reflectedLookup) return aCost;
+
+  return std::max(aCost, getCostAdditive(iState.getTransposedState()));
+}
+
+template <typename Derived>
+constexpr bool PatternDBBase<Derived>::hasDualState(const State& iState) noexcept {
+  return iState.getIndexSpace() == State::kNumTilesMinusOne;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::setReflectedLookup(const bool iReflectedLookup) noexcept {
+  _reflectedLookup = iReflectedLookup;
+}
+
+template <typename Derived>
+bool PatternDBBase<Derived>::isReflectedLookup() const noexcept {
+  return _reflectedLookup;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::setDualLookup(const bool iDualLookup) noexcept {
+  _dualLookup = iDualLookup;
+}
+
+template <typename Derived>
+bool PatternDBBase<Derived>::isDualLookup() const noexcept {
+  return _dualLookup;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostAdditive(const State& iState) const noexcept {
+  Cost_t aCost = 0;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const int aSourcePartition = _sourcePartitions[i];
+    const Index_t aIndex = derived().getPartition(aSourcePartition).rank(computeHash(i, iState)) >> _compressionShift;
+    const Cost_t* aCostTable = getCostTableData(aSourcePartition);
+    assert(aIndex < computeNumEntries(derived().getPartition(aSourcePartition)));
+    assert(aCostTable[aIndex] >= 0);
+    assert(aCostTable[aIndex] <= SearchNode::kMaxPath);
+
+    aCost += aCostTable[aIndex];
+  }
+
+  return aCost;
+}
+
+template <typename Derived>
+typename PatternDBBase<Derived>::Cost_t PatternDBBase<Derived>::getCostAdditivePacked(const State& iState) const noexcept {
+  // With valid partitions the distances of the patterns sum up to the Manhattan distance of the state.
+  const bool aValidPartitions = derived().isValidPartitions();
+  Cost_t aCost = aValidPartitions ? DistanceManhattan::computeDistanceWithFinal(iState) : 0;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const int aSourcePartition = _sourcePartitions[i];
+    const PatternPartition& aPartition = derived().getPartition(aSourcePartition);
+    const std::uint64_t aHash = computeHash(i, iState);
+    const Index_t aIndex = aPartition.rank(aHash) >> _compressionShift;
+    assert((aIndex >> 1) < _packedCostTablePartitions[aSourcePartition].size());
+
+    if (!aValidPartitions) {
+      aCost += aPartition.computeDistance(aHash);
+    }
+    aCost += getPackedEntry(_packedCostTablePartitions[aSourcePartition], aIndex) << 1;
+  }
+
+  return aCost;
+}
+
+template <typename Derived>
+std::uint8_t PatternDBBase<Derived>::getPackedEntry(const PackedCostTable_t& iPackedCostTable,
+                                                    const Index_t iIndex) noexcept {
+  return (iPackedCostTable[iIndex >> 1] >> ((iIndex & 1) << 2)) & 0xF;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::packCostTable(const PatternPartition& iPartition,
+                                           const CostTable_t& iCostTable,
+                                           PackedCostTable_t* oPackedCostTable) {
+  static constexpr int kMaxEntry = 0xF;
+
+  oPackedCostTable->assign((iCostTable.size() + 1) / 2, 0);
+  iPartition.forEachDistance([&iCostTable, oPackedCostTable](const Index_t iIndex, const int iDistance) {
+    assert(iCostTable[iIndex] >= iDistance);
+    assert((iCostTable[iIndex] - iDistance) % 2 == 0);
+
+    const int aEntry = std::min((iCostTable[iIndex] - iDistance) >> 1, kMaxEntry);
+    (*oPackedCostTable)[iIndex >> 1] |= static_cast<std::uint8_t>(aEntry << ((iIndex & 1) << 2));
+  });
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::unpackCostTable(const PatternPartition& iPartition,
+                                             const PackedCostTable_t& iPackedCostTable,
+                                             CostTable_t* oCostTable) {
+  oCostTable->resize(iPartition.getSizeOfTable());
+  iPartition.forEachDistance([&iPackedCostTable, oCostTable](const Index_t iIndex, const int iDistance) {
+    (*oCostTable)[iIndex] = static_cast<Cost_t>(iDistance + (getPackedEntry(iPackedCostTable, iIndex) << 1));
+  });
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::unfoldCostTable(const int iIndexPartition, CostTable_t* oCostTable) const {
+  const PatternPartition& aPartition = derived().getPartition(iIndexPartition);
+  const int aSourcePartition = _sourcePartitions[iIndexPartition];
+  const PatternPartition& aSource = derived().getPartition(aSourcePartition);
+
+  CostTable_t aUnpackedCostTable;
+  const Cost_t* aSourceCostTable = getCostTableData(aSourcePartition);
+  if (_packedStorage) {
+    unpackCostTable(aSource, _packedCostTablePartitions[aSourcePartition], &aUnpackedCostTable);
+    aSourceCostTable = aUnpackedCostTable.data();
+  }
+
+  oCostTable->resize(aPartition.getSizeOfTable());
+  aPartition.forEachHash([&aSource, aSourceCostTable, oCostTable](const Index_t iIndex, const std::uint64_t iHash) {
+    (*oCostTable)[iIndex] = aSourceCostTable[aSource.rank(aSource.computeTransposedHash(iHash))];
+  });
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::setPackedStorage(const bool iPackedStorage) {
+  if (iPackedStorage == _packedStorage) return;
+  if (_compressionShift != 0 || _lazyGeneration) {
+    throw std::runtime_error("The storage of a compressed or lazy PatternDB cannot be changed");
+  }
+  copyMappedCostTables();
+  _packedStorage = iPackedStorage;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    if (_packedStorage) {
+      if (!_costTablePartitions[i].empty()) {
+        packCostTable(derived().getPartition(i), _costTablePartitions[i], &_packedCostTablePartitions[i]);
+      }
+      CostTable_t().swap(_costTablePartitions[i]);
+    } else {
+      if (!_packedCostTablePartitions[i].empty()) {
+        unpackCostTable(derived().getPartition(i), _packedCostTablePartitions[i], &_costTablePartitions[i]);
+      }
+      PackedCostTable_t().swap(_packedCostTablePartitions[i]);
+    }
+  }
+}
+
+template <typename Derived>
+bool PatternDBBase<Derived>::isPackedStorage() const noexcept {
+  return _packedStorage;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::storeCostTable(const int iIndexPartition) {
+  if (_packedStorage) {
+    packCostTable(derived().getPartition(iIndexPartition), _costTablePartitions[iIndexPartition],
+                  &_packedCostTablePartitions[iIndexPartition]);
+    CostTable_t().swap(_costTablePartitions[iIndexPartition]);
+  }
+
+  if (_compressionShift == 0) return;
+
+  // The table is folded from the full size.
+  const int aCompressionShift = _compressionShift;
+  _compressionShift = 0;
+  foldCostTables(aCompressionShift);
+  _compressionShift = aCompressionShift;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::setCompressionFactor(const int iCompressionFactor) {
+  if (iCompressionFactor <= 0 || (iCompressionFactor & (iCompressionFactor - 1)) != 0) {
+    throw std::runtime_error("The compression factor of PatternDB must be a power of two");
+  }
+
+  int aCompressionShift = 0;
+  while ((1 << aCompressionShift) < iCompressionFactor) ++aCompressionShift;
+  if (aCompressionShift < _compressionShift) {
+    throw std::runtime_error("PatternDB cannot be decompressed");
+  }
+  if (aCompressionShift != 0 && _lazyGeneration) {
+    throw std::runtime_error("A lazy PatternDB cannot be compressed");
+  }
+
+  if (aCompressionShift != _compressionShift) copyMappedCostTables();
+  foldCostTables(aCompressionShift - _compressionShift);
+  _compressionShift = aCompressionShift;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::foldCostTables(const int iShift) {
+  if (iShift == 0) return;
+  static constexpr Cost_t kMaxCost = std::numeric_limits<Cost_t>::max();
+  static constexpr std::uint8_t kMaxEntry = 0xF;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const Index_t aNumEntries = computeNumEntries(derived().getPartition(i));
+    const Index_t aNumFoldedEntries = ((aNumEntries - 1) >> iShift) + 1;
+
+    if (!_costTablePartitions[i].empty()) {
+      CostTable_t aFoldedCostTable(aNumFoldedEntries, kMaxCost);
+      for (Index_t j = 0; j < aNumEntries; ++j) {
+        aFoldedCostTable[j >> iShift] = std::min(aFoldedCostTable[j >> iShift], _costTablePartitions[i][j]);
+      }
+      _costTablePartitions[i].swap(aFoldedCostTable);
+    }
+
+    if (!_packedCostTablePartitions[i].empty()) {
+      PackedCostTable_t aFoldedCostTable((aNumFoldedEntries + 1) / 2, 0);
+      std::uint8_t aMinEntry = kMaxEntry;
+      for (Index_t j = 0; j < aNumEntries; ++j) {
+        aMinEntry = std::min(aMinEntry, getPackedEntry(_packedCostTablePartitions[i], j));
+
+        const bool aLastOfGroup = ((j + 1) >> iShift) != (j >> iShift) || j + 1 == aNumEntries;
+        if (aLastOfGroup) {
+          const Index_t aFoldedIndex = j >> iShift;
+          aFoldedCostTable[aFoldedIndex >> 1] |= static_cast<std::uint8_t>(aMinEntry << ((aFoldedIndex & 1) << 2));
+          aMinEntry = kMaxEntry;
+        }
+      }
+      _packedCostTablePartitions[i].swap(aFoldedCostTable);
+    }
+  }
+}
+
+template <typename Derived>
+int PatternDBBase<Derived>::getCompressionFactor() const noexcept {
+  return 1 << _compressionShift;
+}
+
+template <typename Derived>
+std::uint64_t PatternDBBase<Derived>::computeNumEntries(const PatternPartition& iPartition) const noexcept {
+  return ((iPartition.getSizeOfTable() - 1) >> _compressionShift) + 1;
+}
+
+template <typename Derived>
+std::uint64_t PatternDBBase<Derived>::getMemoryUsage() const noexcept {
+  std::uint64_t aMemoryUsage = 0;
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    aMemoryUsage += _costTablePartitions[i].size() * sizeof(Cost_t);
+    aMemoryUsage += _packedCostTablePartitions[i].size() * sizeof(std::uint8_t);
+    if (_mappedFile && _sourcePartitions[i] == i) {
+      aMemoryUsage += derived().getPartition(i).getSizeOfTable() * sizeof(Cost_t);
+    }
+  }
+  return aMemoryUsage;
+}
+
+template <typename Derived>
+double PatternDBBase<Derived>::computeAverageCost() const noexcept {
+  double aAverageCost = 0.0;
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    // The reflection is a bijection of the entries: a folded partition has the average of its source.
+    const int aSourcePartition = _sourcePartitions[i];
+    const PatternPartition& aPartition = derived().getPartition(aSourcePartition);
+    if (_lazyGeneration) {
+      aAverageCost += aPartition.computeAverageDistance();
+      continue;
+    }
+
+    const Index_t aSizeTable = aPartition.getSizeOfTable();
+    const Index_t aNumEntries = computeNumEntries(aPartition);
+    const Index_t aGroupSize = Index_t{1} << _compressionShift;
+
+    // The sum of all costs: each entry stands for a group (the last one can be smaller).
+    double aSumCosts = 0.0;
+    for (Index_t j = 0; j < aNumEntries; ++j) {
+      const Index_t aNumFolded = std::min(aGroupSize, aSizeTable - (j << _compressionShift));
+      const int aEntry = _packedStorage ? getPackedEntry(_packedCostTablePartitions[aSourcePartition], j) << 1
+                                        : getCostTableData(aSourcePartition)[j];
+      aSumCosts += static_cast<double>(aEntry) * static_cast<double>(aNumFolded);
+    }
+    aAverageCost += aSumCosts / static_cast<double>(aSizeTable);
+
+    if (_packedStorage) {
+      aAverageCost += aPartition.computeAverageDistance();
+    }
+  }
+
+  return aAverageCost;
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::serialize(std::ostream* oStream) const {
+  if (_compressionShift != 0) {
+    throw std::runtime_error("A compressed PatternDB cannot be serialized");
+  }
+  if (_lazyGeneration) {
+    throw std::runtime_error("A lazy PatternDB cannot be serialized");
+  }
+
+  std::vector<Mask_t> aMaskPartitions;
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    aMaskPartitions.push_back(derived().getPartition(i).getMask());
+  }
+
+  // The checksums are in the header, before the tables: on a seekable stream the header is written again after them.
+  PatternDBFile aFile{aMaskPartitions};
+  CostTable_t aBuffer;
+  const std::ostream::pos_type aStart = oStream->tellp();
+  const bool aSeekable = aStart != std::ostream::pos_type(-1);
+  if (!aSeekable) {
+    for (int i = 0; i < derived().getNumPartitions(); ++i) {
+      aFile.setChecksum(i, Crc32c::compute(getSerializedCostTable(i, &aBuffer), aFile.getSections()[i]._size));
+    }
+  }
+
+  const std::string aHeader = aFile.serializeHeader();
+  oStream->write(aHeader.data(), static_cast<std::streamsize>(aHeader.size()));
+
+  std::uint64_t aPosition = aHeader.size();
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const PatternDBFile::Section_t& aSection = aFile.getSections()[i];
+    const std::string aPadding(aSection._offset - aPosition, '\0');
+    oStream->write(aPadding.data(), static_cast<std::streamsize>(aPadding.size()));
+
+    const Cost_t* aCostTable = getSerializedCostTable(i, &aBuffer);
+    if (aSeekable) {
+      aFile.setChecksum(i, Crc32c::compute(aCostTable, aSection._size));
+    }
+    oStream->write(reinterpret_cast<const char*>(aCostTable), static_cast<std::streamsize>(aSection._size));
+    aPosition = aSection._offset + aSection._size;
+  }
+
+  // The header has the same size with the checksums.
+  if (aSeekable) {
+    const std::string aHeaderChecksums = aFile.serializeHeader();
+    oStream->seekp(aStart);
+    oStream->write(aHeaderChecksums.data(), static_cast<std::streamsize>(aHeaderChecksums.size()));
+    oStream->seekp(aStart + static_cast<std::streamoff>(aPosition));
+  }
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::deserialize(std::istream* iStream) {
+  static constexpr std::uint64_t kBlockSize = std::uint64_t{1} << 20;
+  setLazyGeneration(false);
+  releaseMappedFile();
+
+  const PatternDBFile aFile = PatternDBFile::readHeader(iStream);
+  checkFilePartitions(aFile);
+
+  const auto aSkip = [iStream](const std::uint64_t iSize) {
+    iStream->ignore(static_cast<std::streamsize>(iSize));
+    if (static_cast<std::uint64_t>(iStream->gcount()) != iSize) {
+      throw std::runtime_error("PatternDB File is not valid");
+    }
+  };
+
+  std::uint64_t aPosition = aFile.getHeaderSize();
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const PatternDBFile::Section_t& aSection = aFile.getSections()[i];
+    aSkip(aSection._offset - aPosition);
+    aPosition = aSection._offset + aSection._size;
+
+    // The table of a partition folded by symmetry is not stored.
+    if (_sourcePartitions[i] != i) {
+      aSkip(aSection._size);
+      continue;
+    }
+
+    // The checksum of each block is computed while it is in cache.
+    CostTable_t& aTable = _costTablePartitions[i];
+    aTable.resize(aSection._size);
+    char* aData = reinterpret_cast<char*>(aTable.data());
+    std::uint32_t aChecksum = 0;
+    for (std::uint64_t aRead = 0; aRead < aSection._size; aRead += kBlockSize) {
+      const std::uint64_t aSizeBlock = std::min(kBlockSize, aSection._size - aRead);
+      iStream->read(aData + aRead, static_cast<std::streamsize>(aSizeBlock));
+      if (static_cast<std::uint64_t>(iStream->gcount()) != aSizeBlock) {
+        throw std::runtime_error("PatternDB File is not valid");
+      }
+      aChecksum = Crc32c::compute(aData + aRead, aSizeBlock, aChecksum);
+    }
+    if (aChecksum != aSection._checksum) {
+      CostTable_t().swap(_costTablePartitions[i]);
+      throw std::runtime_error("PatternDB File is corrupted");
+    }
+
+    storeCostTable(i);
+  }
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::mapFile(const char* iFileName, const bool iVerifyChecksums) {
+  if (_packedStorage || _compressionShift != 0) {
+    throw std::runtime_error("A packed or compressed PatternDB cannot be mapped");
+  }
+  setLazyGeneration(false);
+  releaseMappedFile();
+
+  auto aMappedFile = std::make_shared<const MappedFile>(iFileName);
+  const char* aData = aMappedFile->getData();
+  const std::uint64_t aSizeFile = aMappedFile->getSize();
+
+  std::istringstream aHeader(std::string(aData, std::min(aSizeFile, PatternDBFile::getMaxHeaderSize())));
+  const PatternDBFile aFile = PatternDBFile::readHeader(&aHeader);
+  checkFilePartitions(aFile);
+
+  std::vector<const Cost_t*> aMappedCostTables(derived().getNumPartitions(), nullptr);
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    const PatternDBFile::Section_t& aSection = aFile.getSections()[i];
+    if (aSection._offset > aSizeFile || aSizeFile - aSection._offset < aSection._size) {
+      throw std::runtime_error("PatternDB File is not valid");
+    }
+    if (iVerifyChecksums && Crc32c::compute(aData + aSection._offset, aSection._size) != aSection._checksum) {
+      throw std::runtime_error("PatternDB File is corrupted");
+    }
+
+    // The table of a partition folded by symmetry is not looked up.
+    if (_sourcePartitions[i] == i) {
+      aMappedCostTables[i] = reinterpret_cast<const Cost_t*>(aData + aSection._offset);
+    }
+  }
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    CostTable_t().swap(_costTablePartitions[i]);
+  }
+  _mappedFile = std::move(aMappedFile);
+  _mappedCostTables = std::move(aMappedCostTables);
+}
+
+template <typename Derived>
+bool PatternDBBase<Derived>::isMapped() const noexcept {
+  return _mappedFile != nullptr;
+}
+
+template <typename Derived>
+const typename PatternDBBase<Derived>::Cost_t* PatternDBBase<Derived>::getSerializedCostTable(
+    const int iIndexPartition,
+    CostTable_t* oBuffer) const {
+  const int aSourcePartition = _sourcePartitions[iIndexPartition];
+  const bool aGenerated = _packedStorage ? !_packedCostTablePartitions[aSourcePartition].empty()
+                                         : _mappedFile || !_costTablePartitions[aSourcePartition].empty();
+  if (!aGenerated) {
+    throw std::runtime_error("PatternDB is not generated");
+  }
+
+  if (aSourcePartition != iIndexPartition) {
+    unfoldCostTable(iIndexPartition, oBuffer);
+    return oBuffer->data();
+  }
+  if (_packedStorage) {
+    unpackCostTable(derived().getPartition(iIndexPartition), _packedCostTablePartitions[iIndexPartition], oBuffer);
+    return oBuffer->data();
+  }
+  return getCostTableData(iIndexPartition);
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::checkFilePartitions(const PatternDBFile& iFile) const {
+  // The tables of the version 1 were written by a generator which could overestimate the costs, the ones of the
+  // version 2 are ranked in another order.
+  if (iFile.getVersion() == PatternDBFile::kLegacyVersion) {
+    throw std::runtime_error("PatternDB File of the version 1 could overestimate the costs: it has to be generated again");
+  }
+  if (iFile.getVersion() != PatternDBFile::kVersion) {
+    throw std::runtime_error("PatternDB File has the entries in another order: it has to be generated again");
+  }
+
+  const std::vector<PatternDBFile::Section_t>& aSections = iFile.getSections();
+  if (static_cast<int>(aSections.size()) != derived().getNumPartitions()) {
+    throw std::runtime_error("PatternDB File has different number of partitions");
+  }
+
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    if (aSections[i]._mask != derived().getPartition(i).getMask()) {
+      throw std::runtime_error("PatternDB File has different partitions model");
+    }
+    if (aSections[i]._size != derived().getPartition(i).getSizeOfTable()) {
+      throw std::runtime_error("PatternDB File is not valid");
+    }
+  }
+}
+
+template <typename Derived>
+const typename PatternDBBase<Derived>::Cost_t* PatternDBBase<Derived>::getCostTableData(
+    const int iIndexPartition) const noexcept {
+  return _mappedFile ? _mappedCostTables[iIndexPartition] : _costTablePartitions[iIndexPartition].data();
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::releaseMappedFile() noexcept {
+  _mappedFile.reset();
+  std::fill(_mappedCostTables.begin(), _mappedCostTables.end(), nullptr);
+}
+
+template <typename Derived>
+void PatternDBBase<Derived>::copyMappedCostTables() {
+  if (!_mappedFile) return;
+  for (int i = 0; i < derived().getNumPartitions(); ++i) {
+    if (_sourcePartitions[i] != i) continue;
+    _costTablePartitions[i].assign(_mappedCostTables[i],
+                                   _mappedCostTables[i] + derived().getPartition(i).getSizeOfTable());
+  }
+  releaseMappedFile();
+}
+
+template <typename Derived>
+std::vector<typename PatternDBBase<Derived>::Mask_t> PatternDBBase<Derived>::deserializeMaskPartitions(
+    std::istream* iStream) {
+  return PatternDBFile::readHeader(iStream).getMaskPartitions();
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__PATTERN_DB_BASE__HPP
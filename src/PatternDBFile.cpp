@@ -0,0 +1,198 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "PatternDBFile.hpp"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "Crc32c.hpp"
+
+namespace {
+
+constexpr char kMagic[8] = {'K', 'P', 'Z', '4', 'P', 'D', 'B', '\0'};
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+//! \brief The bytes of the magic, the version, the byte order mark, the number of partitions and the alignment.
+constexpr std::size_t kFixedHeaderSize = sizeof(kMagic) + 4 * sizeof(std::uint32_t);
+
+//! \brief The bytes of a section: the mask, the offset, the size and the checksum (padded).
+constexpr std::size_t kSectionSize = 3 * sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t);
+
+//! \brief The bytes of the checksum of the header (padded).
+constexpr std::size_t kHeaderChecksumSize = 2 * sizeof(std::uint32_t);
+
+//! \brief It appends the bytes of a value.
+template <typename T>
+void appendValue(std::string* oBytes, const T iValue) {
+  oBytes->append(reinterpret_cast<const char*>(&iValue), sizeof(iValue));
+}
+
+//! \return the value in the bytes at the offset.
+template <typename T>
+T readValue(const std::string& iBytes, const std::size_t iOffset) noexcept {
+  T aValue;
+  std::memcpy(&aValue, iBytes.data() + iOffset, sizeof(aValue));
+  return aValue;
+}
+
+//! \brief It reads the bytes of the stream (appended to the string).
+void readBytes(std::istream* iStream, const std::size_t iSize, std::string* oBytes) {
+  const std::size_t aOffset = oBytes->size();
+  oBytes->resize(aOffset + iSize);
+  iStream->read(&(*oBytes)[aOffset], static_cast<std::streamsize>(iSize));
+  if (static_cast<std::size_t>(iStream->gcount()) != iSize) {
+    throw std::runtime_error("PatternDB File is not valid");
+  }
+}
+
+}  // anonymous namespace
+
+namespace kpuzzle4 {
+
+static_assert(PatternDBFile::getMaxHeaderSize() ==
+              kFixedHeaderSize + kSectionSize * State::kNumTilesMinusOne + kHeaderChecksumSize);
+
+PatternDBFile::PatternDBFile(const std::vector<Mask_t>& iMaskPartitions) {
+  std::uint64_t aOffset = kFixedHeaderSize + kSectionSize * iMaskPartitions.size() + kHeaderChecksumSize;
+  for (const Mask_t aMask : iMaskPartitions) {
+    Section_t aSection;
+    aSection._mask = aMask;
+    aSection._offset = alignOffset(aOffset);
+    aSection._size = PatternPartition::computeSizeOfTable(aMask);
+    _sections.push_back(aSection);
+    aOffset = aSection._offset + aSection._size;
+  }
+}
+
+std::vector<PatternDBFile::Mask_t> PatternDBFile::getMaskPartitions() const {
+  std::vector<Mask_t> aMaskPartitions;
+  for (const Section_t& aSection : _sections) {
+    aMaskPartitions.push_back(aSection._mask);
+  }
+  return aMaskPartitions;
+}
+
+void PatternDBFile::setChecksum(const int iIndexPartition, const std::uint32_t iChecksum) noexcept {
+  _sections[iIndexPartition]._checksum = iChecksum;
+}
+
+std::uint64_t PatternDBFile::getHeaderSize() const noexcept {
+  if (_version == kLegacyVersion) {
+    return sizeof(std::int32_t) + sizeof(std::uint64_t) * _sections.size();
+  }
+  return kFixedHeaderSize + kSectionSize * _sections.size() + kHeaderChecksumSize;
+}
+
+std::uint64_t PatternDBFile::getFileSize() const noexcept {
+  return _sections.empty() ? getHeaderSize() : _sections.back()._offset + _sections.back()._size;
+}
+
+std::string PatternDBFile::serializeHeader() const {
+  std::string aHeader(kMagic, sizeof(kMagic));
+  appendValue(&aHeader, kVersion);
+  appendValue(&aHeader, kByteOrderMark);
+  appendValue(&aHeader, static_cast<std::uint32_t>(_sections.size()));
+  appendValue(&aHeader, kAlignment);
+  for (const Section_t& aSection : _sections) {
+    appendValue(&aHeader, static_cast<std::uint64_t>(aSection._mask));
+    appendValue(&aHeader, aSection._offset);
+    appendValue(&aHeader, aSection._size);
+    appendValue(&aHeader, aSection._checksum);
+    appendValue(&aHeader, std::uint32_t{0});
+  }
+  appendValue(&aHeader, Crc32c::compute(aHeader.data(), aHeader.size()));
+  appendValue(&aHeader, std::uint32_t{0});
+
+  aHeader.resize(_sections.empty() ? aHeader.size() : _sections.front()._offset, '\0');
+  return aHeader;
+}
+
+PatternDBFile PatternDBFile::readHeader(std::istream* iStream) {
+  static constexpr std::size_t kMagicPrefixSize = sizeof(std::int32_t);
+
+  // A file of the version 1 starts with the number of partitions, which is never the prefix of the magic.
+  std::string aHeader;
+  readBytes(iStream, kMagicPrefixSize, &aHeader);
+  if (std::memcmp(aHeader.data(), kMagic, kMagicPrefixSize) != 0) {
+    return readLegacyHeader(iStream, readValue<std::int32_t>(aHeader, 0));
+  }
+
+  readBytes(iStream, kFixedHeaderSize - kMagicPrefixSize, &aHeader);
+  if (std::memcmp(aHeader.data(), kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("PatternDB File is not valid");
+  }
+  const std::uint32_t aVersion = readValue<std::uint32_t>(aHeader, sizeof(kMagic));
+  if (aVersion != kVersion && aVersion != kRankedByValueVersion) {
+    throw std::runtime_error("PatternDB File has an unsupported version");
+  }
+  if (readValue<std::uint32_t>(aHeader, sizeof(kMagic) + 4) != kByteOrderMark) {
+    throw std::runtime_error("PatternDB File has a different byte order");
+  }
+  const std::uint32_t aNumPartitions = readValue<std::uint32_t>(aHeader, sizeof(kMagic) + 8);
+  if (aNumPartitions == 0 || aNumPartitions > State::kNumTilesMinusOne) {
+    throw std::runtime_error("PatternDB File is not valid");
+  }
+
+  readBytes(iStream, kSectionSize * aNumPartitions + kHeaderChecksumSize, &aHeader);
+  const std::size_t aChecksumOffset = aHeader.size() - kHeaderChecksumSize;
+  if (Crc32c::compute(aHeader.data(), aChecksumOffset) != readValue<std::uint32_t>(aHeader, aChecksumOffset)) {
+    throw std::runtime_error("PatternDB File is corrupted");
+  }
+
+  PatternDBFile aFile;
+  aFile._version = aVersion;
+  std::uint64_t aEnd = aHeader.size();
+  for (std::uint32_t i = 0; i < aNumPartitions; ++i) {
+    const std::size_t aOffset = kFixedHeaderSize + kSectionSize * i;
+    Section_t aSection;
+    aSection._mask = static_cast<Mask_t>(readValue<std::uint64_t>(aHeader, aOffset));
+    aSection._offset = readValue<std::uint64_t>(aHeader, aOffset + 8);
+    aSection._size = readValue<std::uint64_t>(aHeader, aOffset + 16);
+    aSection._checksum = readValue<std::uint32_t>(aHeader, aOffset + 24);
+
+    // The sections follow each other (the file can be read as a stream).
+    if (aSection._offset < aEnd || aSection._size > std::numeric_limits<std::uint64_t>::max() - aSection._offset) {
+      throw std::runtime_error("PatternDB File is not valid");
+    }
+    aEnd = aSection._offset + aSection._size;
+    aFile._sections.push_back(aSection);
+  }
+
+  return aFile;
+}
+
+PatternDBFile PatternDBFile::readLegacyHeader(std::istream* iStream, const std::int32_t iNumPartitions) {
+  if (iNumPartitions <= 0 || iNumPartitions > State::kNumTilesMinusOne) {
+    throw std::runtime_error("PatternDB File is not valid");
+  }
+
+  std::string aMasks;
+  readBytes(iStream, sizeof(std::uint64_t) * iNumPartitions, &aMasks);
+
+  // The tables are not read (see PatternDBBase::checkFilePartitions): the sections only have the masks.
+  PatternDBFile aFile;
+  aFile._version = kLegacyVersion;
+  for (std::int32_t i = 0; i < iNumPartitions; ++i) {
+    Section_t aSection;
+    aSection._mask = static_cast<Mask_t>(readValue<std::uint64_t>(aMasks, sizeof(std::uint64_t) * i));
+    aFile._sections.push_back(aSection);
+  }
+
+  return aFile;
+}
+
+}  // namespace kpuzzle4
@@ -0,0 +1,131 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__PATTERN_DB_FILE__HPP
+#define KPUZZLE4__PATTERN_DB_FILE__HPP
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "PatternPartition.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief The layout of the file of a pattern database (see
+ *  PatternDB::serialize), version 3:
+ *    - the header: the magic "KPZ4PDB", the version, the byte order mark, the
+ *      number of partitions and the alignment of the sections; for each
+ *      partition its mask, the offset and the size of its table and the
+ *      CRC32C of the table; the CRC32C of the header itself.
+ *    - the tables, each one in a section aligned to a page (zero padded), so
+ *      that a mapped table starts on a page.
+ *  The values are written in the byte order of the machine: a file written
+ *  with the other byte order is rejected (by the byte order mark).
+ *  The files of the version 1 (the number of partitions, the masks, then the
+ *  size and the entries of each table, without checksums) were written by a
+ *  generator which could overestimate the costs: only their masks are read,
+ *  their tables have to be generated again. So do the tables of the version 2
+ *  (same layout as the version 3), whose entries are ranked by decreasing value
+ *  of the tiles (see PatternPartition::rank).
+ */
+class PatternDBFile {
+ public:
+  using Mask_t = PatternPartition::Mask_t;
+
+  static constexpr std::uint32_t kVersion = 3;
+  static constexpr std::uint32_t kRankedByValueVersion = 2;
+  static constexpr std::uint32_t kLegacyVersion = 1;
+  static constexpr std::uint32_t kAlignment = 4096;
+
+  //! \brief The table of a partition in the file.
+  struct Section_t {
+    Mask_t _mask = 0;
+    std::uint64_t _offset = 0;
+    std::uint64_t _size = 0;
+    std::uint32_t _checksum = 0;
+  };
+
+  //! \brief Default Constructor (no partitions).
+  PatternDBFile() = default;
+
+  /*! \brief The layout of the latest version for the partitions: the
+   *  checksums of the tables have to be set before writing the header.
+   */
+  explicit PatternDBFile(const std::vector<Mask_t>& iMaskPartitions);
+
+  //! \return the version of the file.
+  std::uint32_t getVersion() const noexcept {
+    return _version;
+  }
+
+  //! \return the sections of the tables (in order of partition).
+  const std::vector<Section_t>& getSections() const noexcept {
+    return _sections;
+  }
+
+  //! \return the masks of the partitions.
+  std::vector<Mask_t> getMaskPartitions() const;
+
+  //! \brief Sets the checksum of the table of the i-th partition.
+  void setChecksum(const int iIndexPartition, const std::uint32_t iChecksum) noexcept;
+
+  /*! \return the size of the header: the first byte after it (before the
+   *  padding of the first section).
+   */
+  std::uint64_t getHeaderSize() const noexcept;
+
+  //! \return the size of the whole file.
+  std::uint64_t getFileSize() const noexcept;
+
+  /*! \return the bytes of the header, padded up to the first section.
+   *  \note Only the latest version is written.
+   */
+  std::string serializeHeader() const;
+
+  /*! \brief It reads the header of a file (of any version): the stream is left
+   *  after it (see getHeaderSize).
+   *  \throw std::runtime_error in case the header is not valid or corrupted.
+   */
+  static PatternDBFile readHeader(std::istream* iStream);
+
+  //! \return the size of the header of the latest version at most.
+  static constexpr std::uint64_t getMaxHeaderSize() noexcept;
+
+ private:
+  std::uint32_t _version = kVersion;
+  std::vector<Section_t> _sections;
+
+  //! \brief It reads the masks of the version 1 (the number of partitions already read), without sections.
+  static PatternDBFile readLegacyHeader(std::istream* iStream, const std::int32_t iNumPartitions);
+
+  //! \return the offset aligned to the next section.
+  static constexpr std::uint64_t alignOffset(const std::uint64_t iOffset) noexcept;
+};
+
+constexpr std::uint64_t PatternDBFile::getMaxHeaderSize() noexcept {
+  // The fixed fields, a section for each partition and the checksum.
+  return 24 + 32 * State::kNumTilesMinusOne + 8;
+}
+
+constexpr std::uint64_t PatternDBFile::alignOffset(const std::uint64_t iOffset) noexcept {
+  return (iOffset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__PATTERN_DB_FILE__HPP
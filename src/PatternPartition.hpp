@@ -0,0 +1,488 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__PATTERN_PARTITION__HPP
+#define KPUZZLE4__PATTERN_PARTITION__HPP
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include "SearchNode.hpp"
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief A partition of the tiles of a pattern database, described by a mask
+ *  (the nibble of a tile is enabled when the tile belongs to the partition).
+ *  It ranks the positions of its tiles into the index of the cost table.
+ *  It can be built at compile time (as for `PatternDB`) or at run time.
+ */
+class PatternPartition {
+ public:
+  using Mask_t = SearchNode::Mask_t;
+  using Index_t = std::uint64_t;
+
+  constexpr PatternPartition() noexcept = default;
+
+  explicit constexpr PatternPartition(const Mask_t iMask) noexcept;
+
+  //! \return the mask of the partition.
+  constexpr Mask_t getMask() const noexcept;
+
+  //! \return the number of tiles in the partition (the "Space" tile excluded).
+  constexpr int getNumTiles() const noexcept;
+
+  //! \return the i-th tile of the partition (in the order of the ranking: the most mobile tile is the last one).
+  constexpr int getTile(const int iIndexTile) const noexcept;
+
+  //! \return the size (in terms of number of element) of the cost table.
+  constexpr std::uint64_t getSizeOfTable() const noexcept;
+
+  /*! \brief Ranks the positions of the tiles as a partial permutation,
+   *  generating the index to insert the node into the cost table.
+   *  The ranking is perfect and dense: a table of k tiles has 16!/(16-k)!
+   *  entries (no position is shared among tiles).
+   *  The j-th tile is a digit in base (16 - j): its position minus the number
+   *  of positions before it already taken by previous tiles.
+   *  \note The "Space" tile is not considered.
+   *  \note A move of the last tile changes only the least significant digit:
+   *  the entries of the two nodes are in the same cache line, at most. The
+   *  tiles are ranked in increasing order of mobility, so that the moves of
+   *  the search are the ones which keep the lookups closest.
+   */
+  constexpr Index_t rank(const std::uint64_t iHash) const noexcept;
+
+  //! \return the Manhattan distance of the tiles of the partition.
+  constexpr int computeDistance(const std::uint64_t iHash) const noexcept;
+
+  //! \return the positions taken by the tiles of the partition (one per bit).
+  constexpr int computeTakenPositions(const std::uint64_t iHash) const noexcept;
+
+  /*! \return the hash with the "Space" tile moved to the lowest position it
+   *  can reach without moving the tiles of the partition: the hashes of the
+   *  states which are only free moves away are the same.
+   */
+  constexpr std::uint64_t normalizeSpace(const std::uint64_t iHash) const noexcept;
+
+  /*! \return the hash of the state reflected about the main diagonal (see
+   *  State::getTransposedState) for this partition.
+   *  \param [in] iTilesPositions   The positions of the tiles of the state
+   *                                 (or the hash of the transposed partition).
+   */
+  constexpr std::uint64_t computeTransposedHash(const std::uint64_t iTilesPositions) const noexcept;
+
+  /*! \return the average Manhattan distance of the tiles over all entries.
+   *  The position of a tile over all entries is uniform, so it is the sum of
+   *  the average distance of each tile over all positions.
+   */
+  constexpr double computeAverageDistance() const noexcept;
+
+  /*! \brief It calls `iFunction(index, distance)` for all entries of the
+   *  cost table in order of index, where distance is the Manhattan distance
+   *  of the tiles. The positions are enumerated in the order of the ranking,
+   *  so no ranking is needed.
+   *  \see rank
+   */
+  template <typename Function>
+  void forEachDistance(Function&& iFunction) const;
+
+  /*! \brief It calls `iFunction(index, hash)` for all entries of the cost
+   *  table in order of index (the "Space" tile is in the position 0).
+   *  \see forEachDistance
+   */
+  template <typename Function>
+  void forEachHash(Function&& iFunction) const;
+
+  /*! \brief It calls `iFunction(hash)` for each move of a tile of the
+   *  partition into the region of the "Space" tile (see `normalizeSpace`): the
+   *  moves of the other tiles are free, so every move of a node whose "Space"
+   *  is normalized costs one. The "Space" of the hashes of the children is
+   *  normalized as well.
+   */
+  template <typename Function>
+  void forEachMove(const std::uint64_t iHash, Function&& iFunction) const;
+
+  /*! \brief It counts how many tile are in the mask (partition).
+   *  E.g., 0xFF00 -> 2
+   *        0xF00F -> 2
+   *        0xF000 -> 1
+   */
+  static constexpr int countEnabledField(const Mask_t iMask) noexcept;
+
+  //! \return the size (in terms of number of element) of the table for a mask.
+  static constexpr std::uint64_t computeSizeOfTable(const Mask_t iMask) noexcept;
+
+  //! \return the Manhattan distance of a tile in a position from its goal position.
+  static constexpr int computeTileDistance(const int iTile, const int iPosition) noexcept;
+
+  /*! \return the mask of the partition reflected about the main diagonal:
+   *  the one of the tiles whose goal positions are the transposed ones.
+   */
+  static constexpr Mask_t transposeMask(const Mask_t iMask) noexcept;
+
+  //! \return the tile whose goal position is the transposed one of the tile.
+  static constexpr int transposeTile(const int iTile) noexcept;
+
+  //! \return the positions adjacent to the given ones (one per bit).
+  static constexpr int computeAdjacentPositions(const int iPositions) noexcept;
+
+  //! \return the free positions (one per bit) connected to a position.
+  static constexpr int computeRegion(const int iPosition, const int iFreePositions) noexcept;
+
+  //! \return the lowest position (one per bit), which cannot be empty.
+  static constexpr int computeLowestPosition(const int iPositions) noexcept;
+
+  /*! \brief Given a tile value and partitions, it computes the partition-index
+   *  in which the tile is enabled (the tile belongs to that partition).
+   *  \param [in] iMaskPartitions   The masks of the partitions.
+   *  \param [in] iTileValue        The value of the tile to investigate.
+   *                                (E.g. 0xf, 0x2, ...).
+   *  \note 'iTileValue' cannot be 0 because it belogs to multiple partitions.
+   *  \return the index of the partition or -1 in case not belong any partition.
+   */
+  template <typename MaskPartitions>
+  static constexpr int getPartitionIndexOfTileIndex(const MaskPartitions& iMaskPartitions,
+                                                    const int iTileValue) noexcept;
+
+  /*! \brief Checks whether all partitions are disjointed or not.
+   *  \note the zero (the last 4 bits) are not considered.
+   */
+  template <typename MaskPartitions>
+  static constexpr bool checkPartitionsDisjoint(const MaskPartitions& iMaskPartitions) noexcept;
+
+  //! \brief Checks whether all partitions have zero active in the mask.
+  template <typename MaskPartitions>
+  static constexpr bool checkAllPartitionsHasZero(const MaskPartitions& iMaskPartitions) noexcept;
+
+  /*! \brief Check whther all partitions are total:
+   *  That is, the union of all partition is the universal set (no mask).
+   */
+  template <typename MaskPartitions>
+  static constexpr bool checkPartitionsAreTotal(const MaskPartitions& iMaskPartitions) noexcept;
+
+  //! \return whether the partition model is valid or not.
+  template <typename MaskPartitions>
+  static constexpr bool isValidPartitions(const MaskPartitions& iMaskPartitions) noexcept;
+
+ private:
+  /*! \brief The tiles in increasing order of mobility: the fraction of the
+   *  moves of IDA* which move the tile, measured on random instances (from
+   *  5.9% of the tile 13 to 7.5% of the tile 11). The tiles whose goal is near
+   *  the center of the board or the goal of the "Space" tile move the most.
+   */
+  static constexpr std::array<int, State::kNumTilesMinusOne> kTilesByMobility = {
+      13, 1, 2, 5, 4, 3, 9, 6, 14, 8, 12, 10, 7, 15, 11};
+
+  Mask_t _mask = 0;
+  int _numTiles = 0;
+  std::array<int, State::kNumTilesMinusOne> _tiles = {};
+};
+
+constexpr PatternPartition::PatternPartition(const Mask_t iMask) noexcept : _mask(iMask) {
+  // The most mobile tiles are the least significant digits of the ranking.
+  for (const int aTile : kTilesByMobility) {
+    if ((iMask >> (aTile << 2)) & 0xF) {
+      _tiles[_numTiles++] = aTile;
+    }
+  }
+}
+
+constexpr PatternPartition::Mask_t PatternPartition::getMask() const noexcept {
+  return _mask;
+}
+
+constexpr int PatternPartition::getNumTiles() const noexcept {
+  return _numTiles;
+}
+
+constexpr int PatternPartition::getTile(const int iIndexTile) const noexcept {
+  assert(iIndexTile < _numTiles);
+  return _tiles[iIndexTile];
+}
+
+constexpr std::uint64_t PatternPartition::getSizeOfTable() const noexcept {
+  return computeSizeOfTable(_mask);
+}
+
+constexpr PatternPartition::Index_t PatternPartition::rank(const std::uint64_t iHash) const noexcept {
+  // The nibble j counts the positions before j already taken.
+  constexpr std::uint64_t kOnesFromSecondNibble = 0x1111111111111110;
+
+  Index_t aRank = 0;
+  std::uint64_t aTakenBefore = 0;
+
+  for (int i = 0; i < _numTiles; ++i) {
+    const int aPositionTimes4 = static_cast<int>((iHash >> (_tiles[i] << 2)) & 0xF) << 2;
+    const int aDigit = (aPositionTimes4 >> 2) - static_cast<int>((aTakenBefore >> aPositionTimes4) & 0xF);
+    assert(aDigit >= 0 && aDigit < State::kNumTiles - i);
+
+    aRank = aRank * static_cast<Index_t>(State::kNumTiles - i) + static_cast<Index_t>(aDigit);
+    aTakenBefore += kOnesFromSecondNibble << aPositionTimes4;
+  }
+
+  return aRank;
+}
+
+constexpr int PatternPartition::computeDistance(const std::uint64_t iHash) const noexcept {
+  int aDistance = 0;
+
+  for (int i = 0; i < _numTiles; ++i) {
+    aDistance += computeTileDistance(_tiles[i], static_cast<int>((iHash >> (_tiles[i] << 2)) & 0xF));
+  }
+
+  return aDistance;
+}
+
+constexpr int PatternPartition::computeTakenPositions(const std::uint64_t iHash) const noexcept {
+  int aTaken = 0;
+
+  for (int i = 0; i < _numTiles; ++i) {
+    aTaken |= 1 << ((iHash >> (_tiles[i] << 2)) & 0xF);
+  }
+
+  return aTaken;
+}
+
+constexpr std::uint64_t PatternPartition::normalizeSpace(const std::uint64_t iHash) const noexcept {
+  constexpr int kAllPositions = (1 << State::kNumTiles) - 1;
+
+  const int aRegion = computeRegion(static_cast<int>(iHash & 0xF), ~computeTakenPositions(iHash) & kAllPositions);
+  return (iHash & ~std::uint64_t{0xF}) | static_cast<std::uint64_t>(computeLowestPosition(aRegion));
+}
+
+constexpr std::uint64_t PatternPartition::computeTransposedHash(const std::uint64_t iTilesPositions) const noexcept {
+  // The tile t of the transposed state is in the transposed position of the tile transposeTile(t).
+  std::uint64_t aHash = static_cast<std::uint64_t>(State::getTransposedIndex(static_cast<int>(iTilesPositions & 0xF)));
+
+  for (int i = 0; i < _numTiles; ++i) {
+    const int aPosition = static_cast<int>((iTilesPositions >> (transposeTile(_tiles[i]) << 2)) & 0xF);
+    aHash |= static_cast<std::uint64_t>(State::getTransposedIndex(aPosition)) << (_tiles[i] << 2);
+  }
+
+  return aHash;
+}
+
+constexpr double PatternPartition::computeAverageDistance() const noexcept {
+  double aDistance = 0.0;
+
+  for (int i = 0; i < _numTiles; ++i) {
+    for (int aPosition = 0; aPosition < State::kNumTiles; ++aPosition) {
+      aDistance += static_cast<double>(computeTileDistance(_tiles[i], aPosition)) / State::kNumTiles;
+    }
+  }
+
+  return aDistance;
+}
+
+template <typename Function>
+void PatternPartition::forEachDistance(Function&& iFunction) const {
+  Index_t aIndex = 0;
+
+  // The free positions of a tile in increasing order are its digits in increasing order.
+  const auto aPlaceTile = [&](const auto& iPlaceTile, const int iIndexTile, const int iTakenPositions,
+                              const int iDistance) -> void {
+    if (iIndexTile == _numTiles) {
+      iFunction(aIndex++, iDistance);
+      return;
+    }
+
+    const int aTile = _tiles[iIndexTile];
+    for (int aPosition = 0; aPosition < State::kNumTiles; ++aPosition) {
+      if ((iTakenPositions >> aPosition) & 1) continue;
+      iPlaceTile(iPlaceTile, iIndexTile + 1, iTakenPositions | (1 << aPosition),
+                 iDistance + computeTileDistance(aTile, aPosition));
+    }
+  };
+
+  aPlaceTile(aPlaceTile, 0, 0, 0);
+  assert(aIndex == getSizeOfTable());
+}
+
+template <typename Function>
+void PatternPartition::forEachHash(Function&& iFunction) const {
+  Index_t aIndex = 0;
+
+  const auto aPlaceTile = [&](const auto& iPlaceTile, const int iIndexTile, const int iTakenPositions,
+                              const std::uint64_t iHash) -> void {
+    if (iIndexTile == _numTiles) {
+      iFunction(aIndex++, iHash);
+      return;
+    }
+
+    const int aShiftTile = _tiles[iIndexTile] << 2;
+    for (int aPosition = 0; aPosition < State::kNumTiles; ++aPosition) {
+      if ((iTakenPositions >> aPosition) & 1) continue;
+      iPlaceTile(iPlaceTile, iIndexTile + 1, iTakenPositions | (1 << aPosition),
+                 iHash | (static_cast<std::uint64_t>(aPosition) << aShiftTile));
+    }
+  };
+
+  aPlaceTile(aPlaceTile, 0, 0, 0);
+  assert(aIndex == getSizeOfTable());
+}
+
+template <typename Function>
+void PatternPartition::forEachMove(const std::uint64_t iHash, Function&& iFunction) const {
+  constexpr int kAllPositions = (1 << State::kNumTiles) - 1;
+
+  const int aFree = ~computeTakenPositions(iHash) & kAllPositions;
+  const int aRegion = computeRegion(static_cast<int>(iHash & 0xF), aFree);
+  const std::uint64_t aHashNoSpace = iHash & ~std::uint64_t{0xF};
+
+  // A tile next to the region moves in it, the "Space" takes its position.
+  for (int i = 0; i < _numTiles; ++i) {
+    const int aShiftTile = _tiles[i] << 2;
+    const int aPosition = static_cast<int>((iHash >> aShiftTile) & 0xF);
+
+    int aTargets = computeAdjacentPositions(1 << aPosition) & aRegion;
+    while (aTargets != 0) {
+      const int aTarget = computeLowestPosition(aTargets);
+      aTargets &= aTargets - 1;
+
+      const int aFreeChild = (aFree & ~(1 << aTarget)) | (1 << aPosition);
+      const int aSpaceChild = computeLowestPosition(computeRegion(aPosition, aFreeChild));
+      iFunction((aHashNoSpace & ~(std::uint64_t{0xF} << aShiftTile)) |
+                (static_cast<std::uint64_t>(aTarget) << aShiftTile) | static_cast<std::uint64_t>(aSpaceChild));
+    }
+  }
+}
+
+constexpr int PatternPartition::countEnabledField(const Mask_t iMask) noexcept {
+  int aCounter = 0;
+
+  for (int i = 0; i < State::kNumTiles; ++i) {
+    assert(((iMask >> (i << 2)) & 0xF) == 0xF || ((iMask >> (i << 2)) & 0xF) == 0x0);
+
+    aCounter += (iMask >> (i << 2)) & 0x1;
+  }
+
+  return aCounter;
+}
+
+constexpr std::uint64_t PatternPartition::computeSizeOfTable(const Mask_t iMask) noexcept {
+  const int kSizeMask = countEnabledField(iMask) - 1;
+
+  std::uint64_t aSize = 1;
+  for (int i = 0; i < kSizeMask; ++i) {
+    aSize *= State::kNumTiles - i;
+  }
+  return aSize;
+}
+
+constexpr int PatternPartition::computeTileDistance(const int iTile, const int iPosition) noexcept {
+  const int aGoalPosition = iTile - 1;
+  const int aDistanceX = iPosition % State::kSize - aGoalPosition % State::kSize;
+  const int aDistanceY = iPosition / State::kSize - aGoalPosition / State::kSize;
+  return (aDistanceX < 0 ? -aDistanceX : aDistanceX) + (aDistanceY < 0 ? -aDistanceY : aDistanceY);
+}
+
+constexpr PatternPartition::Mask_t PatternPartition::transposeMask(const Mask_t iMask) noexcept {
+  Mask_t aMask = iMask & 0xF;
+
+  for (int aTile = 1; aTile < State::kNumTiles; ++aTile) {
+    aMask |= ((iMask >> (aTile << 2)) & 0xF) << (transposeTile(aTile) << 2);
+  }
+
+  return aMask;
+}
+
+constexpr int PatternPartition::transposeTile(const int iTile) noexcept {
+  return State::getTransposedIndex(iTile - 1) + 1;
+}
+
+constexpr int PatternPartition::computeAdjacentPositions(const int iPositions) noexcept {
+  // The positions which are not in the first (last) column of a row.
+  constexpr int kNotFirstColumn = 0xEEEE;
+  constexpr int kNotLastColumn = 0x7777;
+  constexpr int kAllPositions = (1 << State::kNumTiles) - 1;
+
+  return ((iPositions << State::kSize) | (iPositions >> State::kSize) | ((iPositions << 1) & kNotFirstColumn) |
+          ((iPositions >> 1) & kNotLastColumn)) &
+         kAllPositions;
+}
+
+constexpr int PatternPartition::computeRegion(const int iPosition, const int iFreePositions) noexcept {
+  int aRegion = 1 << iPosition;
+
+  while (true) {
+    const int aGrown = (aRegion | computeAdjacentPositions(aRegion)) & iFreePositions;
+    if (aGrown == aRegion) return aRegion;
+    aRegion = aGrown;
+  }
+}
+
+constexpr int PatternPartition::computeLowestPosition(const int iPositions) noexcept {
+  assert(iPositions != 0);
+
+  // De Bruijn sequence: the lowest bit times the sequence has a distinct top 5 bits for each position.
+  constexpr std::uint32_t kDeBruijn = 0x077CB531;
+  constexpr std::array<int, 32> kPositions = {0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+                                              31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9};
+  const std::uint32_t aLowest = static_cast<std::uint32_t>(iPositions & -iPositions);
+  return kPositions[(aLowest * kDeBruijn) >> 27];
+}
+
+template <typename MaskPartitions>
+constexpr int PatternPartition::getPartitionIndexOfTileIndex(const MaskPartitions& iMaskPartitions,
+                                                             const int iTileValue) noexcept {
+  assert(iTileValue != 0);
+
+  const int aNumPartitions = static_cast<int>(iMaskPartitions.size());
+  for (int i = 0; i < aNumPartitions; ++i) {
+    if ((iMaskPartitions[i] >> (iTileValue << 2)) & 0xF) return i;
+  }
+
+  return -1;
+}
+
+template <typename MaskPartitions>
+constexpr bool PatternPartition::checkPartitionsDisjoint(const MaskPartitions& iMaskPartitions) noexcept {
+  const int aNumPartitions = static_cast<int>(iMaskPartitions.size());
+
+  for (int i = 0; i < aNumPartitions - 1; ++i) {
+    for (int j = i + 1; j < aNumPartitions; ++j) {
+      if ((iMaskPartitions[i] & iMaskPartitions[j]) != 0xF) return false;
+    }
+  }
+
+  return true;
+}
+
+template <typename MaskPartitions>
+constexpr bool PatternPartition::checkAllPartitionsHasZero(const MaskPartitions& iMaskPartitions) noexcept {
+  for (const Mask_t aMask : iMaskPartitions) {
+    if ((aMask & 0xF) != 0xF) return false;
+  }
+  return true;
+}
+
+template <typename MaskPartitions>
+constexpr bool PatternPartition::checkPartitionsAreTotal(const MaskPartitions& iMaskPartitions) noexcept {
+  for (int i = State::kNumTilesMinusOne; i > 0; --i) {
+    if (getPartitionIndexOfTileIndex(iMaskPartitions, i) == -1) return false;
+  }
+  return true;
+}
+
+template <typename MaskPartitions>
+constexpr bool PatternPartition::isValidPartitions(const MaskPartitions& iMaskPartitions) noexcept {
+  return checkPartitionsDisjoint(iMaskPartitions) && checkAllPartitionsHasZero(iMaskPartitions) &&
+         checkPartitionsAreTotal(iMaskPartitions);
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__PATTERN_PARTITION__HPP
@@ -0,0 +1,222 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SolutionCache.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace kpuzzle4 {
+
+namespace {
+
+std::uint64_t computeFileSize(const std::uint64_t iHeaderSize,
+                              const std::uint64_t iEntrySize,
+                              const std::uint64_t iCapacity) noexcept {
+  return iHeaderSize + iEntrySize * iCapacity;
+}
+
+//! \brief It holds the lock of a file in a scope.
+class FileLock {
+ public:
+  explicit FileLock(MappedFile* ioFile) : _file(ioFile) {
+    _file->lock();
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+  ~FileLock() {
+    _file->unlock();
+  }
+
+ private:
+  MappedFile* _file;
+};
+
+}  // anonymous namespace
+
+SolutionCache::SolutionCache(const char* iFileName, const std::uint32_t iCapacity) {
+  if (iCapacity == 0) {
+    throw std::runtime_error("SolutionCache capacity cannot be zero");
+  }
+
+  if (std::ifstream(iFileName).good()) {
+    _file = MappedFile(iFileName, MappedFile::Access::READ_WRITE);
+  } else {
+    // A new file is initialized aside and then moved in place: the other processes never see it partially written.
+    // The name is unique: the processes creating the cache at the same time do not lock each other out.
+    const std::string aTemporaryFileName = std::string(iFileName) + ".tmp" + std::to_string(std::random_device{}());
+    _file = MappedFile(aTemporaryFileName.c_str(), computeFileSize(sizeof(Header_t), sizeof(Entry_t), iCapacity));
+
+    Header_t* aHeader = getHeader();
+    std::memcpy(aHeader->_magic, kMagic, sizeof(kMagic));
+    aHeader->_version = kVersion;
+    aHeader->_capacity = iCapacity;
+    aHeader->_clock = 0;
+
+    // Another process has created the file in the meantime.
+    const bool aRenamed = _file.rename(iFileName, false);
+    _file.unlock();
+    if (!aRenamed) {
+      std::remove(aTemporaryFileName.c_str());
+      _file = MappedFile(iFileName, MappedFile::Access::READ_WRITE);
+    }
+  }
+
+  const Header_t* aHeader = getHeader();
+  if (std::memcmp(aHeader->_magic, kMagic, sizeof(kMagic)) != 0 || aHeader->_version != kVersion ||
+      aHeader->_capacity == 0 ||
+      _file.getSize() != computeFileSize(sizeof(Header_t), sizeof(Entry_t), aHeader->_capacity)) {
+    throw std::runtime_error("SolutionCache File is not valid");
+  }
+
+  // The index is built (and the entries checked) whatever the clock.
+  const FileLock aLock(&_file);
+  _clockIndexed = aHeader->_clock + 1;
+  updateIndex();
+}
+
+std::uint32_t SolutionCache::getCapacity() const noexcept {
+  return getHeader()->_capacity;
+}
+
+bool SolutionCache::find(const State& iState, Path_t* oPath, int* oLength) {
+  const FileLock aLock(&_file);
+  updateIndex();
+
+  bool aTransposed;
+  const auto aSlot = _slots.find(canonicalize(iState, &aTransposed));
+  if (aSlot == _slots.cend()) return false;
+
+  const Entry_t* aEntry = getEntry(aSlot->second);
+  *oLength = aEntry->_length;
+  for (int i = 0; i < aEntry->_length; ++i) {
+    (*oPath)[i] = aTransposed ? transposeMove(aEntry->_path[i]) : aEntry->_path[i];
+  }
+
+  touch(aSlot->second);
+  return true;
+}
+
+void SolutionCache::insert(const State& iState, const Path_t& iPath, const int iLength) {
+  assert(iLength >= 0 && iLength <= SearchNode::kMaxPath);
+
+  const FileLock aLock(&_file);
+  updateIndex();
+
+  bool aTransposed;
+  const StateConfiguration_t aConfiguration = canonicalize(iState, &aTransposed);
+
+  const auto aSlotFound = _slots.find(aConfiguration);
+  if (aSlotFound != _slots.cend()) {
+    touch(aSlotFound->second);
+    return;
+  }
+
+  std::uint32_t aSlot;
+  if (_slots.size() < getCapacity()) {
+    aSlot = static_cast<std::uint32_t>(_slots.size());
+    while (getEntry(aSlot)->_configuration != kEmptyEntry) {
+      aSlot = (aSlot + 1) % getCapacity();
+    }
+  } else {
+    // Evicts the least recently used entry.
+    assert(!_recency.empty());
+    aSlot = _recency.cbegin()->second;
+    _recency.erase(_recency.cbegin());
+    _slots.erase(getEntry(aSlot)->_configuration);
+  }
+
+  Entry_t* aEntry = getEntry(aSlot);
+  aEntry->_configuration = aConfiguration;
+  aEntry->_lastAccess = 0;
+  aEntry->_length = static_cast<std::uint8_t>(iLength);
+  aEntry->_path.fill(0);
+  for (int i = 0; i < iLength; ++i) {
+    aEntry->_path[i] = aTransposed ? transposeMove(iPath[i]) : iPath[i];
+  }
+
+  _slots.emplace(aConfiguration, aSlot);
+  touch(aSlot);
+}
+
+SolutionCache::Header_t* SolutionCache::getHeader() const noexcept {
+  return reinterpret_cast<Header_t*>(_file.getData());
+}
+
+SolutionCache::Entry_t* SolutionCache::getEntry(const std::uint32_t iSlot) const noexcept {
+  assert(iSlot < getCapacity());
+  return reinterpret_cast<Entry_t*>(_file.getData() + sizeof(Header_t)) + iSlot;
+}
+
+void SolutionCache::touch(const std::uint32_t iSlot) noexcept {
+  Entry_t* aEntry = getEntry(iSlot);
+
+  const auto aRecency = _recency.find(aEntry->_lastAccess);
+  if (aRecency != _recency.cend() && aRecency->second == iSlot) {
+    _recency.erase(aRecency);
+  }
+
+  aEntry->_lastAccess = ++getHeader()->_clock;
+  _recency.emplace(aEntry->_lastAccess, iSlot);
+  _clockIndexed = aEntry->_lastAccess;
+}
+
+void SolutionCache::updateIndex() {
+  // Every change of the file advances its clock.
+  if (getHeader()->_clock == _clockIndexed) return;
+
+  _slots.clear();
+  _recency.clear();
+  for (std::uint32_t i = 0; i < getCapacity(); ++i) {
+    const Entry_t* aEntry = getEntry(i);
+    if (aEntry->_configuration == kEmptyEntry) continue;
+
+    if (!isValid(*aEntry) || !_slots.emplace(aEntry->_configuration, i).second) {
+      _slots.clear();
+      _recency.clear();
+      throw std::runtime_error("SolutionCache File is not valid: the entry " + std::to_string(i) + " is corrupted");
+    }
+    _recency.emplace(aEntry->_lastAccess, i);
+  }
+
+  _clockIndexed = getHeader()->_clock;
+}
+
+bool SolutionCache::isValid(const Entry_t& iEntry) noexcept {
+  if (iEntry._length > SearchNode::kMaxPath) return false;
+
+  return std::all_of(iEntry._path.cbegin(), iEntry._path.cbegin() + iEntry._length, [](const char iMove) {
+    return iMove == 'L' || iMove == 'R' || iMove == 'U' || iMove == 'D';
+  });
+}
+
+SolutionCache::StateConfiguration_t SolutionCache::canonicalize(const State& iState, bool* oTransposed) noexcept {
+  const StateConfiguration_t aConfiguration = iState.getStateConfiguration();
+  const StateConfiguration_t aTransposedConfiguration = iState.getTransposedState().getStateConfiguration();
+
+  *oTransposed = aTransposedConfiguration < aConfiguration;
+  return std::min(aConfiguration, aTransposedConfiguration);
+}
+
+}  // namespace kpuzzle4
@@ -0,0 +1,152 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__SOLUTION_CACHE__HPP
+#define KPUZZLE4__SOLUTION_CACHE__HPP
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include "MappedFile.hpp"
+#include "SearchNode.hpp"
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief Persistent (on disk) cache of optimal solutions.
+ *  The cache is a memory mapped file with a bounded number of entries, the
+ *  least recently used entry is evicted when the cache is full.
+ *  States are canonicalized under the diagonal reflection of the board, so
+ *  that a state and its transposed share the same entry.
+ *  Many processes can share the file: it is locked only during a lookup or an
+ *  insertion (see MappedFile::lock), and the index in memory is rebuilt when
+ *  another process has changed the file since.
+ */
+class SolutionCache {
+ public:
+  using StateConfiguration_t = State::StateConfiguration_t;
+  using Path_t = SearchNode::Path_t;
+
+  static constexpr std::uint32_t kDefaultCapacity = 1 << 16;
+
+  /*! \brief Opens (or creates) the cache file.
+   *  \param [in] iFileName   The path of the cache file.
+   *  \param [in] iCapacity   The max number of entries, only used when the
+   *                          file is created.
+   *  \throw std::runtime_error in case of file is not compatible (e.g., an
+   *  entry with a path which is not valid) or errors generated.
+   */
+  explicit SolutionCache(const char* iFileName, const std::uint32_t iCapacity = kDefaultCapacity);
+
+  /*! \brief Looks for the solution of a state.
+   *  \param [in]  iState     The state to search.
+   *  \param [out] oPath      The solution path (if found).
+   *  \param [out] oLength    The length of the solution path (if found).
+   *  \return true in case of cache hit.
+   *  \throw std::runtime_error in case the file changed by another process is
+   *  not valid.
+   */
+  bool find(const State& iState, Path_t* oPath, int* oLength);
+
+  /*! \brief Inserts the solution of a state. In case the cache is full the
+   *  least recently used entry is replaced.
+   *  \throw std::runtime_error in case the file changed by another process is
+   *  not valid.
+   */
+  void insert(const State& iState, const Path_t& iPath, const int iLength);
+
+  //! \return the number of solutions stored.
+  std::uint32_t getSize() const noexcept {
+    return static_cast<std::uint32_t>(_slots.size());
+  }
+
+  //! \return the max number of solutions which can be stored.
+  std::uint32_t getCapacity() const noexcept;
+
+  /*! \brief Maps a move into the move of the transposed state.
+   *  E.g., 'L' -> 'U', 'D' -> 'R'.
+   */
+  static constexpr char transposeMove(const char iMove) noexcept;
+
+ protected:
+  static constexpr char kMagic[8] = {'K', 'P', '4', 'C', 'A', 'C', 'H', 'E'};
+  static constexpr std::uint32_t kVersion = 1;
+  static constexpr StateConfiguration_t kEmptyEntry = 0x0;
+
+  struct Header_t {
+    char _magic[sizeof(kMagic)];
+    std::uint32_t _version;
+    std::uint32_t _capacity;
+    std::uint64_t _clock;
+  };
+
+  struct Entry_t {
+    StateConfiguration_t _configuration;
+    std::uint64_t _lastAccess;
+    std::uint8_t _length;
+    Path_t _path;
+  };
+
+  MappedFile _file;
+
+  //! \brief Index of the entries in the file: configuration -> slot.
+  std::unordered_map<StateConfiguration_t, std::uint32_t> _slots;
+
+  //! \brief Recency of the entries: last access -> slot.
+  std::map<std::uint64_t, std::uint32_t> _recency;
+
+  //! \brief The clock of the file when the index was last updated.
+  std::uint64_t _clockIndexed = 0;
+
+  Header_t* getHeader() const noexcept;
+  Entry_t* getEntry(const std::uint32_t iSlot) const noexcept;
+
+  //! \brief Marks the entry as the most recently used.
+  void touch(const std::uint32_t iSlot) noexcept;
+
+  /*! \brief Rebuilds the index in case another process has changed the file.
+   *  \note The file must be locked.
+   *  \throw std::runtime_error in case an entry is not valid.
+   */
+  void updateIndex();
+
+  //! \return whether an entry holds a path which can be a solution.
+  static bool isValid(const Entry_t& iEntry) noexcept;
+
+  /*! \brief Computes the canonical representation of a state.
+   *  \param [out] oTransposed   Whether the canonical representation is the
+   *                             transposed state.
+   */
+  static StateConfiguration_t canonicalize(const State& iState, bool* oTransposed) noexcept;
+};
+
+constexpr char SolutionCache::transposeMove(const char iMove) noexcept {
+  switch (iMove) {
+    case 'L':
+      return 'U';
+    case 'U':
+      return 'L';
+    case 'R':
+      return 'D';
+    case 'D':
+      return 'R';
+  }
+  return iMove;
+}
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__SOLUTION_CACHE__HPP
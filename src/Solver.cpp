@@ -0,0 +1,457 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "Solver.hpp"
+#include <array>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "CacheMissCounter.hpp"
+#include "DistanceLinearConflict.hpp"
+#include "DistanceManhattan.hpp"
+#include "DistanceWalking.hpp"
+#include "DynamicPatternDB.hpp"
+#include "ExternalPatternDBGenerator.hpp"
+#include "HeuristicComposer.hpp"
+#include "PatternDB.hpp"
+
+namespace kpuzzle4 {
+
+struct Solver::Impl {
+  static constexpr std::array<State::Mask_t, 3> kMasksPattern = {0xFFFFF0000000000F,
+                                                                 0x00000FFFFF00000F,
+                                                                 0x0000000000FFFFFF};
+  using PatternDB_t = PatternDB<std::get<0>(kMasksPattern), std::get<1>(kMasksPattern), std::get<2>(kMasksPattern)>;
+  static_assert(PatternDB_t::isValidPartitions());
+
+  static constexpr std::array<State::Mask_t, 2> kMasksPattern78 = {0x00000000FFFFFFFF, 0xFFFFFFFF0000000F};
+  using PatternDB78_t = PatternDB<std::get<0>(kMasksPattern78), std::get<1>(kMasksPattern78)>;
+  static_assert(PatternDB78_t::isValidPartitions());
+
+  /*! \brief The prefetches of the pattern database in a search: it keeps the
+   *  indices of the entries of each slot of the open list (see AlgorithmIDA),
+   *  so that a state prefetched is not ranked again to look up its cost.
+   */
+  template <typename PatternDBType>
+  class PatternDBPrefetcher {
+   public:
+    PatternDBPrefetcher(const Impl& iImpl, const PatternDBType& iPatternDB) noexcept
+        : _patternDB(iPatternDB),
+          _enabled(iImpl._options._prefetch && iImpl._options._dualLookup != DualLookup::REPLACE) {}
+
+    //! \return whether the lookups are prefetched (see Options_t::_prefetch).
+    bool isEnabled() const noexcept {
+      return _enabled;
+    }
+
+    void prefetch(const State& iState, const std::size_t iSlot) const {
+      if (!_enabled) return;
+
+      const std::size_t aNumIndices = static_cast<std::size_t>(_patternDB.getNumPrefetchIndices());
+      if (_indices.size() < (iSlot + 1) * aNumIndices) {
+        _indices.resize((iSlot + 1) * aNumIndices);
+      }
+      _patternDB.prefetch(iState, _indices.data() + iSlot * aNumIndices);
+    }
+
+    //! \return the cost of the state prefetched in the slot.
+    SearchNode::Cost_t getCost(const State& iState, const std::size_t iSlot) const {
+      const std::size_t aNumIndices = static_cast<std::size_t>(_patternDB.getNumPrefetchIndices());
+      return _patternDB.getCostPrefetched(iState, _indices.data() + iSlot * aNumIndices);
+    }
+
+   private:
+    const PatternDBType& _patternDB;
+    const bool _enabled;
+    mutable std::vector<typename PatternDBType::Index_t> _indices;
+  };
+
+  /*! \brief Heuristic used while the pattern database is generated in
+   *  background: it is the Manhattan distance until the database is ready,
+   *  then it switches to the database at the next iteration of the search.
+   *  That is safe because both heuristics are admissible.
+   */
+  template <typename PatternDBType>
+  class HeuristicHotSwap {
+   public:
+    HeuristicHotSwap(const Impl& iImpl, const PatternDBType& iPatternDB) noexcept
+        : _impl(iImpl), _patternDB(iPatternDB) {}
+
+    SearchNode::Cost_t operator()(const State& iState) const {
+      if (!_usePatternDB) return DistanceManhattan::computeDistanceWithFinal(iState);
+      return _impl._options._dualLookup == DualLookup::REPLACE ? _patternDB.getCostDual(iState)
+                                                               : _patternDB.getCost(iState);
+    }
+
+    void onNewIteration() noexcept {
+      _usePatternDB = _impl._patternDBReady.load(std::memory_order_acquire);
+    }
+
+    void prefetch(const State& iState, const std::size_t iSlot) const {
+      if (_usePatternDB) _prefetcher.prefetch(iState, iSlot);
+    }
+
+    SearchNode::Cost_t getCostPrefetched(const State& iState, const std::size_t iSlot, const int) const {
+      if (!_usePatternDB || !_prefetcher.isEnabled()) return (*this)(iState);
+      return _prefetcher.getCost(iState, iSlot);
+    }
+
+   private:
+    const Impl& _impl;
+    const PatternDBType& _patternDB;
+    PatternDBPrefetcher<PatternDBType> _prefetcher{_impl, _patternDB};
+    bool _usePatternDB = false;
+  };
+
+  //! \brief Heuristic of the pattern database when it is ready (regular or dual lookup).
+  template <typename PatternDBType>
+  class HeuristicPatternDB {
+   public:
+    HeuristicPatternDB(const Impl& iImpl, const PatternDBType& iPatternDB) noexcept
+        : _impl(iImpl), _patternDB(iPatternDB) {}
+
+    SearchNode::Cost_t operator()(const State& iState) const {
+      return _impl._options._dualLookup == DualLookup::REPLACE ? _patternDB.getCostDual(iState)
+                                                               : _patternDB.getCost(iState);
+    }
+
+    void prefetch(const State& iState, const std::size_t iSlot) const {
+      _prefetcher.prefetch(iState, iSlot);
+    }
+
+    SearchNode::Cost_t getCostPrefetched(const State& iState, const std::size_t iSlot, const int) const {
+      if (!_prefetcher.isEnabled()) return (*this)(iState);
+      return _prefetcher.getCost(iState, iSlot);
+    }
+
+   private:
+    const Impl& _impl;
+    const PatternDBType& _patternDB;
+    PatternDBPrefetcher<PatternDBType> _prefetcher{_impl, _patternDB};
+  };
+
+  Options_t _options;
+
+  //! \brief The pattern database of the partitions in the options.
+  std::variant<PatternDB_t, PatternDB78_t, DynamicPatternDB> _patternDB;
+
+  //! \brief Whether `_patternDB` can be read.
+  std::atomic<bool> _patternDBReady{false};
+
+  //! \brief The thread generating the pattern database (if any).
+  std::thread _patternDBGenerator;
+
+  std::mutex _workspacesMutex;
+  std::vector<std::unique_ptr<AlgorithmIDA>> _workspaces;
+
+  explicit Impl(Options_t iOptions);
+
+  //! \brief It waits the background generation of the database (if any).
+  ~Impl();
+
+  void initializePatternDB();
+
+  /*! \return the masks of the CUSTOM partitions (from the options or from
+   *  the header of the file).
+   *  \throw std::runtime_error in case they are not available.
+   */
+  std::vector<State::Mask_t> getCustomMaskPartitions() const;
+
+  //! \brief Generates the pattern database and saves it on file.
+  void generatePatternDB();
+
+  void savePatternDBOnFile(const char* iFileName) const;
+
+  //! \brief Loads the pattern database from file: it is mapped or read (see Options_t::_mappedPatternDB).
+  void loadPatternDBFromFile(const char* iFileName);
+
+  /*! \brief Loads the pattern database from file (see loadPatternDBFromFile).
+   *  \return false in case the file is not valid (e.g. written by a previous
+   *  version, or corrupted): the error is logged and the database has to be
+   *  generated again.
+   */
+  bool tryLoadPatternDBFromFile(const char* iFileName);
+
+  /*! \brief Compresses the pattern database (when the file is already saved)
+   *  and logs its memory and average cost.
+   */
+  void compressPatternDB();
+
+  //! \return a workspace from the pool (a new one in case the pool is empty).
+  std::unique_ptr<AlgorithmIDA> acquireWorkspace();
+
+  //! \brief Gives back the workspace to the pool.
+  void releaseWorkspace(std::unique_ptr<AlgorithmIDA> iAlgorithmIDA);
+
+  //! \brief Log a message (in case the log is enabled).
+  void log(const char* iMessage) const;
+};
+
+Solver::Impl::Impl(Options_t iOptions) : _options(std::move(iOptions)) {
+  if (_options._patternPartitions == PatternPartitions::P7_8) {
+    _patternDB.emplace<PatternDB78_t>();
+  } else if (_options._patternPartitions == PatternPartitions::CUSTOM) {
+    _patternDB.emplace<DynamicPatternDB>(getCustomMaskPartitions());
+  }
+
+  std::visit(
+      [this](auto& ioPatternDB) {
+        ioPatternDB.setReflectedLookup(_options._reflectedLookup);
+        ioPatternDB.setDualLookup(_options._dualLookup == DualLookup::MAX);
+        ioPatternDB.setPackedStorage(_options._packedStorage);
+      },
+      _patternDB);
+  if (_options._heuristicType == HeuristicType::PATTERNS) {
+    initializePatternDB();
+  }
+}
+
+std::vector<State::Mask_t> Solver::Impl::getCustomMaskPartitions() const {
+  if (!_options._customMaskPartitions.empty()) return _options._customMaskPartitions;
+
+  std::ifstream aFile(_options._fileNamePatternDB, std::ios_base::binary);
+  if (aFile.fail()) {
+    throw std::runtime_error("The partitions of the Pattern Database are not given");
+  }
+  return DynamicPatternDB::deserializeMaskPartitions(&aFile);
+}
+
+void Solver::Impl::initializePatternDB() {
+  const char* aFileName = _options._fileNamePatternDB.c_str();
+
+  const bool aFileExists = !std::ifstream(aFileName, std::ios_base::binary).fail();
+  if (aFileExists && tryLoadPatternDBFromFile(aFileName)) {
+    compressPatternDB();
+    _patternDBReady.store(true, std::memory_order_release);
+    log("Done\n");
+  } else if (_options._lazyGeneration) {
+    std::visit([](auto& ioPatternDB) { ioPatternDB.setLazyGeneration(true); }, _patternDB);
+    _patternDBReady.store(true, std::memory_order_release);
+    log("Patterns Database computed on demand\n");
+  } else if (_options._backgroundGeneration) {
+    log("Generating Patterns Database in background...\n");
+    _patternDBGenerator = std::thread([this]() {
+      try {
+        generatePatternDB();
+        log("Patterns Database ready\n");
+      } catch (const std::exception& aError) {
+        log(aError.what());
+        log("\n");
+      }
+    });
+  } else {
+    log("Generating Patterns Database...\n");
+    generatePatternDB();
+    log("Done\n");
+  }
+}
+
+bool Solver::Impl::tryLoadPatternDBFromFile(const char* iFileName) {
+  log("Load Patterns Database...\n");
+  try {
+    loadPatternDBFromFile(iFileName);
+    return true;
+  } catch (const std::runtime_error& aError) {
+    log(aError.what());
+    log("\n");
+    return false;
+  }
+}
+
+void Solver::Impl::generatePatternDB() {
+  if (_options._generationMemoryLimit != 0) {
+    std::vector<State::Mask_t> aMaskPartitions;
+    std::visit(
+        [&aMaskPartitions](const auto& iPatternDB) {
+          for (int i = 0; i < iPatternDB.getNumPartitions(); ++i) {
+            aMaskPartitions.push_back(iPatternDB.getPartition(i).getMask());
+          }
+        },
+        _patternDB);
+    ExternalPatternDBGenerator{std::move(aMaskPartitions), _options._generationMemoryLimit}.generate(
+        _options._fileNamePatternDB);
+    // The tables generated within the memory limit are mapped rather than read all into memory.
+    if (_options._packedStorage) {
+      loadPatternDBFromFile(_options._fileNamePatternDB.c_str());
+    } else {
+      const char* aFileName = _options._fileNamePatternDB.c_str();
+      std::visit([aFileName](auto& ioPatternDB) { ioPatternDB.mapFile(aFileName); }, _patternDB);
+    }
+  } else {
+    std::visit([](auto& ioPatternDB) { ioPatternDB.generate(); }, _patternDB);
+    savePatternDBOnFile(_options._fileNamePatternDB.c_str());
+  }
+  compressPatternDB();
+  _patternDBReady.store(true, std::memory_order_release);
+}
+
+void Solver::Impl::compressPatternDB() {
+  std::visit(
+      [this](auto& ioPatternDB) {
+        ioPatternDB.setCompressionFactor(_options._compressionFactor);
+
+        std::ostringstream aReport;
+        aReport << "Patterns Database: " << ioPatternDB.getMemoryUsage() << " bytes, average cost "
+                << ioPatternDB.computeAverageCost() << " (compression factor " << _options._compressionFactor
+                << ")\n";
+        log(aReport.str().c_str());
+      },
+      _patternDB);
+}
+
+Solver::Impl::~Impl() {
+  if (_patternDBGenerator.joinable()) {
+    _patternDBGenerator.join();
+  }
+}
+
+void Solver::Impl::savePatternDBOnFile(const char* iFileName) const {
+  std::ofstream oFile(iFileName, std::ios_base::binary);
+  if (oFile.fail()) {
+    throw std::runtime_error("Cannot save the Pattern Database");
+  }
+  std::visit([&oFile](const auto& iPatternDB) { iPatternDB.serialize(&oFile); }, _patternDB);
+}
+
+void Solver::Impl::loadPatternDBFromFile(const char* iFileName) {
+  if (_options._mappedPatternDB && !_options._packedStorage) {
+    std::visit([iFileName](auto& ioPatternDB) { ioPatternDB.mapFile(iFileName); }, _patternDB);
+    return;
+  }
+
+  std::ifstream aFile(iFileName, std::ios_base::binary);
+  std::visit([&aFile](auto& ioPatternDB) { ioPatternDB.deserialize(&aFile); }, _patternDB);
+}
+
+std::unique_ptr<AlgorithmIDA> Solver::Impl::acquireWorkspace() {
+  {
+    std::lock_guard<std::mutex> aLock(_workspacesMutex);
+    if (!_workspaces.empty()) {
+      auto aAlgorithmIDA = std::move(_workspaces.back());
+      _workspaces.pop_back();
+      return aAlgorithmIDA;
+    }
+  }
+
+  return std::make_unique<AlgorithmIDA>();
+}
+
+void Solver::Impl::releaseWorkspace(std::unique_ptr<AlgorithmIDA> iAlgorithmIDA) {
+  std::lock_guard<std::mutex> aLock(_workspacesMutex);
+  _workspaces.push_back(std::move(iAlgorithmIDA));
+}
+
+void Solver::Impl::log(const char* iMessage) const {
+  if (_options._log != nullptr) {
+    *_options._log << iMessage;
+    _options._log->flush();
+  }
+}
+
+Solver::Solver(Options_t iOptions) : _impl(std::make_unique<Impl>(std::move(iOptions))) {}
+
+Solver::Solver(Solver&&) noexcept = default;
+Solver& Solver::operator=(Solver&&) noexcept = default;
+Solver::~Solver() = default;
+
+Solver::Solution_t Solver::solve(const State& iInitialState) const {
+  auto aAlgorithmIDA = _impl->acquireWorkspace();
+  const Solution_t aSolution = solve(iInitialState, aAlgorithmIDA.get());
+  _impl->releaseWorkspace(std::move(aAlgorithmIDA));
+
+  return aSolution;
+}
+
+Solver::Solution_t Solver::solve(const State& iInitialState, AlgorithmIDA* ioAlgorithmIDA) const {
+  AlgorithmIDA::SolverResult_t aResult;
+  std::optional<CacheMissCounter> aCacheMissCounter;
+  if (_impl->_options._countCacheMisses) {
+    aCacheMissCounter.emplace();
+    aCacheMissCounter->start();
+  }
+
+  ioAlgorithmIDA->setBidirectionalPathMax(_impl->_options._heuristicType == HeuristicType::PATTERNS &&
+                                          _impl->_options._dualLookup == DualLookup::REPLACE);
+
+  switch (_impl->_options._heuristicType) {
+    case HeuristicType::MANHATTAN:
+      aResult = ioAlgorithmIDA->findSolution(iInitialState, DistanceManhattan::computeDistanceWithFinal);
+      break;
+    case HeuristicType::MANHATTAN_LC:
+      aResult = ioAlgorithmIDA->findSolution(iInitialState, DistanceLinearConflict::computeDistanceWithFinal);
+      break;
+    case HeuristicType::WALKING:
+      aResult = ioAlgorithmIDA->findSolution(
+          iInitialState,
+          makeHeuristicMax(DistanceWalking::Incremental{}, DistanceLinearConflict::computeDistanceWithFinal));
+      break;
+    case HeuristicType::PATTERNS: {
+      // The linear conflicts are computed only when the database is not enough to prune the node.
+      const auto aFindSolution = [&](const State& iState, auto&& ioHeuristicPatternDB) {
+        if (_impl->_options._maxLinearConflict) {
+          return ioAlgorithmIDA->findSolution(
+              iState, makeHeuristicMax(ioHeuristicPatternDB, DistanceLinearConflict::computeDistanceWithFinal));
+        }
+        return ioAlgorithmIDA->findSolution(iState, ioHeuristicPatternDB);
+      };
+
+      std::visit(
+          [&](const auto& aPatternDB) {
+            if (!_impl->_patternDBReady.load(std::memory_order_acquire)) {
+              aResult = aFindSolution(iInitialState, Impl::HeuristicHotSwap{*_impl, aPatternDB});
+            } else {
+              aResult = aFindSolution(iInitialState, Impl::HeuristicPatternDB{*_impl, aPatternDB});
+            }
+          },
+          _impl->_patternDB);
+      break;
+    }
+  }
+
+  Solution_t aSolution;
+  if (aCacheMissCounter) {
+    aCacheMissCounter->stop();
+    aSolution._cacheMisses = aCacheMissCounter->getCount();
+  }
+  aSolution._solutionFound = aResult._solutionFound;
+  aSolution._exploredNodes = ioAlgorithmIDA->getExploredNodes();
+  aSolution._timeElapsed = aResult._timeElapsed;
+  if (aResult._solutionFound) {
+    aSolution._length = ioAlgorithmIDA->getSolutionLength();
+    aSolution._path = ioAlgorithmIDA->getSolutionPath();
+  }
+
+  return aSolution;
+}
+
+Solver::HeuristicType Solver::getHeuristicType() const noexcept {
+  return _impl->_options._heuristicType;
+}
+
+bool Solver::isPatternDBReady() const noexcept {
+  return _impl->_patternDBReady.load(std::memory_order_acquire);
+}
+
+}  // namespace kpuzzle4
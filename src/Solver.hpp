@@ -0,0 +1,202 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__SOLVER__HPP
+#define KPUZZLE4__SOLVER__HPP
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "AlgorithmIDA.hpp"
+#include "SearchNode.hpp"
+#include "State.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief A solver session.
+ *  The session initializes the heuristic once (e.g., loading the pattern
+ *  database) and then it can solve many problems, even concurrently from
+ *  different threads.
+ */
+class Solver {
+ public:
+  /*! \brief The heuristic of the search:
+   *    - MANHATTAN:     Manhattan distance.
+   *    - MANHATTAN_LC:  Manhattan distance plus the linear conflicts.
+   *    - WALKING:       the max of the walking distance and MANHATTAN_LC
+   *                     (small tables generated at startup).
+   *    - PATTERNS:      pattern database.
+   */
+  enum class HeuristicType { MANHATTAN, MANHATTAN_LC, WALKING, PATTERNS };
+
+  /*! \brief How the pattern database is looked up on the dual state:
+   *    - NONE:    never.
+   *    - MAX:     the max between the regular and the dual lookups.
+   *    - REPLACE: the dual lookup instead of the regular one on the states
+   *               where it is possible (the "Space" tile in its goal
+   *               position), with the bidirectional pathmax in the search.
+   *  \note The lookups cannot alternate on the depth: the states with the
+   *  "Space" tile in its goal position are all at depths of the same parity.
+   */
+  enum class DualLookup { NONE, MAX, REPLACE };
+
+  /*! \brief The partitions of the tiles of the pattern database:
+   *    - P5_5_5: three partitions of 5 tiles (a few MB).
+   *    - P7_8:   the tiles 1-7 and 8-15 (about 600MB, much stronger).
+   *    - CUSTOM: the masks given at run time (see `_customMaskPartitions`).
+   */
+  enum class PatternPartitions { P5_5_5, P7_8, CUSTOM };
+
+  using Path_t = SearchNode::Path_t;
+  using Duration_t = AlgorithmIDA::Duration_t;
+
+  static constexpr const char* kFileNamePatternDB = "patternDB.data";
+  static constexpr const char* kFileNamePatternDB78 = "patternDB78.data";
+
+  struct Options_t {
+    HeuristicType _heuristicType = HeuristicType::PATTERNS;
+    PatternPartitions _patternPartitions = PatternPartitions::P5_5_5;
+
+    /*! \brief The masks of the CUSTOM partitions. In case they are empty,
+     *  they are read from the header of the file of the pattern database.
+     */
+    std::vector<State::Mask_t> _customMaskPartitions;
+
+    /*! \brief The file of the pattern database. It is generated (and saved)
+     *  in case it does not exist or it cannot be loaded (e.g. written by a
+     *  previous version, or corrupted).
+     */
+    std::string _fileNamePatternDB = kFileNamePatternDB;
+
+    /*! \brief Whether the pattern database (when it has to be generated) is
+     *  generated in background. In the meanwhile problems are solved with the
+     *  Manhattan distance.
+     */
+    bool _backgroundGeneration = true;
+
+    /*! \brief Whether the pattern database is looked up also on the state
+     *  reflected about the main diagonal (the max of the two costs).
+     */
+    bool _reflectedLookup = false;
+
+    DualLookup _dualLookup = DualLookup::NONE;
+
+    /*! \brief Whether the tables of the pattern database are packed in 4 bits
+     *  per entry (half the memory, see PatternDB::setPackedStorage).
+     */
+    bool _packedStorage = false;
+
+    /*! \brief The lossy compression factor of the tables of the pattern
+     *  database, a power of two (see PatternDB::setCompressionFactor).
+     *  The memory and the average cost are reported in the log.
+     */
+    int _compressionFactor = 1;
+
+    /*! \brief Whether the entries of the pattern database are computed on
+     *  demand (see PatternDB::setLazyGeneration) when its file does not exist,
+     *  instead of generating it: nothing is saved on file.
+     *  \note It cannot be used with the packed storage or the compression.
+     */
+    bool _lazyGeneration = false;
+
+    /*! \brief Whether the file of the pattern database is mapped in memory
+     *  rather than read (see PatternDB::mapFile): the loading takes no time
+     *  and the processes solving with the same file share its pages.
+     *  It is ignored with the packed storage; with the compression the tables
+     *  are copied anyway.
+     */
+    bool _mappedPatternDB = false;
+
+    /*! \brief The memory (in bytes) for the generation of the pattern
+     *  database: when it is not zero the tables are generated on disk within
+     *  this limit (see ExternalPatternDBGenerator), the temporary files next to
+     *  the file of the database. The tables are mapped from the file after
+     *  (see _mappedPatternDB), or loaded with the packed storage.
+     */
+    std::uint64_t _generationMemoryLimit = 0;
+
+    /*! \brief Whether the cost of the pattern database is combined (max) with
+     *  the Manhattan distance plus the linear conflicts, which is sometimes
+     *  greater (fewer nodes are explored).
+     */
+    bool _maxLinearConflict = false;
+
+    /*! \brief Whether the entries of the pattern database of the children of
+     *  a node are prefetched when it is expanded (see PatternDB::prefetch).
+     *  It pays off only when the tables are much larger than the cache (e.g.,
+     *  7-8): otherwise the entries are already cached.
+     */
+    bool _prefetch = false;
+
+    /*! \brief Whether the cache misses of each search are counted (see
+     *  Solution_t::_cacheMisses): it costs some system calls per search.
+     */
+    bool _countCacheMisses = false;
+
+    //! \brief Where to print the progress of the initialization (optional).
+    std::ostream* _log = nullptr;
+  };
+
+  struct Solution_t {
+    bool _solutionFound = false;
+    int _length = 0;
+    Path_t _path = {};
+    long long _exploredNodes = 0ll;
+    Duration_t _timeElapsed = Duration_t::zero();
+
+    /*! \brief The cache misses of the search (-1 when they are not counted, see
+     *  Options_t::_countCacheMisses, or they cannot be, see CacheMissCounter).
+     */
+    long long _cacheMisses = -1;
+  };
+
+  /*! \brief Initializes the session.
+   *  \throw std::runtime_error in case the heuristic cannot be initialized.
+   */
+  explicit Solver(Options_t iOptions);
+
+  Solver(Solver&&) noexcept;
+  Solver& operator=(Solver&&) noexcept;
+  ~Solver();
+
+  /*! \brief Finds the optimal solution of a problem.
+   *  \note It is thread-safe: the search workspaces are pooled and reused
+   *  among calls.
+   */
+  Solution_t solve(const State& iInitialState) const;
+
+  /*! \brief Finds the optimal solution of a problem using the workspace
+   *  provided by the caller (e.g., to monitor the search progress).
+   *  \note It is thread-safe as long as the workspace is not shared.
+   */
+  Solution_t solve(const State& iInitialState, AlgorithmIDA* ioAlgorithmIDA) const;
+
+  //! \return the heuristic used by the session.
+  HeuristicType getHeuristicType() const noexcept;
+
+  //! \return whether the pattern database has been loaded (or generated).
+  bool isPatternDBReady() const noexcept;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__SOLVER__HPP
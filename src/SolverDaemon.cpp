@@ -0,0 +1,355 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SolverDaemon.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace kpuzzle4 {
+
+namespace {
+
+/*! \brief Given a request in the format:
+ *       1,2,3,4,...
+ *  it returns the state. It returns false in case of parsing error.
+ */
+bool parseState(const std::string& iRequest, State* oState, std::string* oError) {
+  std::array<int, State::kNumTiles> aValues;
+
+  std::istringstream aSs(iRequest);
+  for (int i = 0; i < State::kNumTiles; ++i) {
+    char aSeparator = ',';
+    if (i != 0) aSs >> aSeparator;
+    aSs >> aValues[i];
+
+    if (aSs.fail() || aSeparator != ',' || aValues[i] < 0 || aValues[i] > State::kNumTilesMinusOne) {
+      *oError = "malformed state";
+      return false;
+    }
+  }
+
+  aSs >> std::ws;
+  if (!aSs.eof()) {
+    *oError = "malformed state";
+    return false;
+  }
+
+  *oState = State{aValues};
+  if (!oState->isValid()) {
+    *oError = "state not valid";
+    return false;
+  }
+  if (!oState->isSolveable()) {
+    *oError = "state not solveable";
+    return false;
+  }
+
+  return true;
+}
+
+}  // anonymous namespace
+
+SolverDaemon::SolverDaemon(const Solver& iSolver,
+                           std::string iSocketPath,
+                           const int iNumWorkers,
+                           SolutionCache* iSolutionCache)
+    : _solver(iSolver),
+      _socketPath(std::move(iSocketPath)),
+      _numWorkers(iNumWorkers > 0 ? iNumWorkers : 1),
+      _solutionCache(iSolutionCache) {}
+
+std::string SolverDaemon::processRequest(const std::string& iRequest) const {
+  State aState;
+  std::string aError;
+  if (!parseState(iRequest, &aState, &aError)) {
+    return "ERROR " + aError;
+  }
+
+  Solver::Solution_t aSolution;
+  if (_solutionCache != nullptr) {
+    // A cache which cannot be read is not used: the problem is solved.
+    std::lock_guard<std::mutex> aLock(_solutionCacheMutex);
+    try {
+      aSolution._solutionFound = _solutionCache->find(aState, &aSolution._path, &aSolution._length);
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  if (!aSolution._solutionFound) {
+    aSolution = _solver.solve(aState);
+    if (!aSolution._solutionFound) {
+      return "ERROR solution not found";
+    }
+
+    if (_solutionCache != nullptr) {
+      std::lock_guard<std::mutex> aLock(_solutionCacheMutex);
+      try {
+        _solutionCache->insert(aState, aSolution._path, aSolution._length);
+      } catch (const std::runtime_error&) {
+      }
+    }
+  }
+
+  std::ostringstream aResponse;
+  aResponse << "OK " << aSolution._length << ' ';
+  if (aSolution._length == 0) {
+    aResponse << '-';
+  } else {
+    aResponse.write(aSolution._path.data(), aSolution._length);
+  }
+  aResponse << ' ' << aSolution._exploredNodes << ' ' << aSolution._timeElapsed.count();
+
+  return aResponse.str();
+}
+
+void SolverDaemon::stop() noexcept {
+  _stopRequested = true;
+}
+
+#ifdef _WIN32
+
+void SolverDaemon::run() {
+  throw std::runtime_error("SolverDaemon is not supported on this platform");
+}
+
+void SolverDaemon::serveConnections() {}
+
+bool SolverDaemon::serveConnection(Connection_t*) {
+  return false;
+}
+
+#else
+
+void SolverDaemon::run() {
+  sockaddr_un aAddress = {};
+  aAddress.sun_family = AF_UNIX;
+  if (_socketPath.empty() || _socketPath.size() >= sizeof(aAddress.sun_path)) {
+    throw std::runtime_error("SolverDaemon socket path is not valid");
+  }
+  std::memcpy(aAddress.sun_path, _socketPath.c_str(), _socketPath.size() + 1);
+
+  const int aListener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (aListener == -1) {
+    throw std::runtime_error("SolverDaemon cannot create the socket");
+  }
+
+  // A stale socket left by a previous daemon is replaced; any other file at that path is not ours to remove.
+  struct stat aStat;
+  if (::lstat(_socketPath.c_str(), &aStat) == 0) {
+    if (!S_ISSOCK(aStat.st_mode)) {
+      ::close(aListener);
+      throw std::runtime_error("SolverDaemon socket path is not a socket: " + _socketPath);
+    }
+
+    // Only a socket nobody listens on is stale.
+    const int aProbe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    const bool aRefused = aProbe != -1 &&
+                          ::connect(aProbe, reinterpret_cast<const sockaddr*>(&aAddress), sizeof(aAddress)) == -1 &&
+                          errno == ECONNREFUSED;
+    if (aProbe != -1) ::close(aProbe);
+    if (!aRefused) {
+      ::close(aListener);
+      throw std::runtime_error("SolverDaemon socket is in use: " + _socketPath);
+    }
+    ::unlink(_socketPath.c_str());
+  }
+
+  if (::bind(aListener, reinterpret_cast<const sockaddr*>(&aAddress), sizeof(aAddress)) == -1 ||
+      ::listen(aListener, SOMAXCONN) == -1) {
+    ::close(aListener);
+    throw std::runtime_error("SolverDaemon cannot listen on the socket: " + _socketPath);
+  }
+
+  if (::pipe(_wakeUpPipe.data()) == -1) {
+    ::close(aListener);
+    ::unlink(_socketPath.c_str());
+    throw std::runtime_error("SolverDaemon cannot create the pipe of the workers");
+  }
+  for (const int aEnd : _wakeUpPipe) {
+    ::fcntl(aEnd, F_SETFL, ::fcntl(aEnd, F_GETFL) | O_NONBLOCK);
+  }
+
+  std::vector<std::thread> aWorkers;
+  for (int i = 0; i < _numWorkers; ++i) {
+    aWorkers.emplace_back(&SolverDaemon::serveConnections, this);
+  }
+
+  // The listener, the pipe, then the idle connections (same order in `aPolled`).
+  std::vector<Connection_t> aIdleConnections;
+  std::vector<pollfd> aPolled;
+  while (!_stopRequested) {
+    {
+      std::lock_guard<std::mutex> aLock(_connectionsMutex);
+      std::move(_idleConnections.begin(), _idleConnections.end(), std::back_inserter(aIdleConnections));
+      _idleConnections.clear();
+    }
+
+    aPolled.assign({{aListener, POLLIN, 0}, {_wakeUpPipe[0], POLLIN, 0}});
+    for (const Connection_t& aConnection : aIdleConnections) {
+      aPolled.push_back({aConnection._socket, POLLIN, 0});
+    }
+
+    const int aPollResult = ::poll(aPolled.data(), aPolled.size(), static_cast<int>(kPollPeriod.count()));
+    if (aPollResult <= 0) continue;
+
+    if ((aPolled[1].revents & POLLIN) != 0) {
+      std::array<char, 64> aDrain;
+      while (::read(_wakeUpPipe[0], aDrain.data(), aDrain.size()) > 0) {
+      }
+    }
+
+    // The connections with something to read (or closed) go to the workers.
+    std::size_t aNumReady = 0;
+    {
+      std::lock_guard<std::mutex> aLock(_connectionsMutex);
+      std::size_t aKept = 0;
+      for (std::size_t i = 0; i < aIdleConnections.size(); ++i) {
+        if (aPolled[i + 2].revents != 0) {
+          _connections.push_back(std::move(aIdleConnections[i]));
+          ++aNumReady;
+        } else if (aKept++ != i) {
+          aIdleConnections[aKept - 1] = std::move(aIdleConnections[i]);
+        }
+      }
+      aIdleConnections.resize(aKept);
+    }
+    for (std::size_t i = 0; i < aNumReady; ++i) {
+      _connectionsCondition.notify_one();
+    }
+
+    if ((aPolled[0].revents & POLLIN) != 0) {
+      const int aConnection = ::accept(aListener, nullptr, nullptr);
+      if (aConnection == -1) continue;
+
+#ifdef SO_NOSIGPIPE
+      const int aNoSigPipe = 1;
+      ::setsockopt(aConnection, SOL_SOCKET, SO_NOSIGPIPE, &aNoSigPipe, sizeof(aNoSigPipe));
+#endif
+
+      aIdleConnections.push_back({aConnection, {}});
+    }
+  }
+
+  ::close(aListener);
+  ::unlink(_socketPath.c_str());
+
+  _connectionsCondition.notify_all();
+  for (auto& aWorker : aWorkers) {
+    aWorker.join();
+  }
+
+  for (const auto* aConnections : {&aIdleConnections, &_idleConnections}) {
+    for (const Connection_t& aConnection : *aConnections) {
+      ::close(aConnection._socket);
+    }
+  }
+  for (const Connection_t& aConnection : _connections) {
+    ::close(aConnection._socket);
+  }
+  _idleConnections.clear();
+  _connections.clear();
+
+  for (int& ioEnd : _wakeUpPipe) {
+    ::close(ioEnd);
+    ioEnd = -1;
+  }
+}
+
+void SolverDaemon::serveConnections() {
+  while (true) {
+    Connection_t aConnection;
+    {
+      std::unique_lock<std::mutex> aLock(_connectionsMutex);
+      _connectionsCondition.wait_for(
+          aLock, kPollPeriod, [this]() { return _stopRequested || !_connections.empty(); });
+
+      if (_stopRequested) return;
+      if (_connections.empty()) continue;
+
+      aConnection = std::move(_connections.front());
+      _connections.pop_front();
+    }
+
+    if (!serveConnection(&aConnection)) continue;
+
+    {
+      std::lock_guard<std::mutex> aLock(_connectionsMutex);
+      _idleConnections.push_back(std::move(aConnection));
+    }
+    static constexpr char kWakeUp = 0;
+    static_cast<void>(::write(_wakeUpPipe[1], &kWakeUp, 1));
+  }
+}
+
+bool SolverDaemon::serveConnection(Connection_t* ioConnection) {
+#ifdef MSG_NOSIGNAL
+  static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+  static constexpr int kSendFlags = 0;
+#endif
+
+  std::array<char, kMaxRequestLength> aChunk;
+  std::string& aBuffer = ioConnection->_buffer;
+  bool aConnectionOpen = true;
+
+  const auto aReceived = ::recv(ioConnection->_socket, aChunk.data(), aChunk.size(), 0);
+  if (aReceived <= 0) {
+    aConnectionOpen = false;
+  } else {
+    aBuffer.append(aChunk.data(), static_cast<std::size_t>(aReceived));
+  }
+
+  std::size_t aEndLine;
+  while (aConnectionOpen && !_stopRequested && (aEndLine = aBuffer.find('\n')) != std::string::npos) {
+    std::string aRequest = aBuffer.substr(0, aEndLine);
+    aBuffer.erase(0, aEndLine + 1);
+    if (!aRequest.empty() && aRequest.back() == '\r') aRequest.pop_back();
+
+    const std::string aResponse = processRequest(aRequest) + '\n';
+    const ssize_t aSent = ::send(ioConnection->_socket, aResponse.data(), aResponse.size(), kSendFlags);
+    aConnectionOpen = aSent == static_cast<ssize_t>(aResponse.size());
+  }
+
+  if (aConnectionOpen && aBuffer.size() > kMaxRequestLength) {
+    static constexpr const char kResponse[] = "ERROR request too long\n";
+    ::send(ioConnection->_socket, kResponse, sizeof(kResponse) - 1, kSendFlags);
+    aConnectionOpen = false;
+  }
+
+  if (!aConnectionOpen) ::close(ioConnection->_socket);
+  return aConnectionOpen;
+}
+
+#endif
+
+}  // namespace kpuzzle4
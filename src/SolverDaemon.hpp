@@ -0,0 +1,122 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__SOLVER_DAEMON__HPP
+#define KPUZZLE4__SOLVER_DAEMON__HPP
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SolutionCache.hpp"
+#include "Solver.hpp"
+
+namespace kpuzzle4 {
+
+/*! \brief A long-running server which solves the problems sent by clients
+ *  through a Unix domain socket.
+ *  The protocol is line-based. Each request is a line with the initial state:
+ *        1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15
+ *  and each response is a line:
+ *        OK <length> <moves> <explored nodes> <time ms>
+ *        ERROR <message>
+ *  where <moves> is the sequence of moves (e.g., "LLUR"), "-" when empty.
+ *  A client can send many requests on the same connection. Requests are
+ *  served concurrently by a pool of workers sharing the same solver session:
+ *  a worker takes a connection only when it has something to read, and gives
+ *  it back once its complete lines are served, so idle clients hold no worker.
+ *  The solutions found in the cache (if any) are reported with no explored
+ *  nodes.
+ */
+class SolverDaemon {
+ public:
+  static constexpr int kMaxRequestLength = 256;
+  static constexpr auto kPollPeriod = std::chrono::milliseconds(100);
+
+  /*! \param [in] iSolver       The solver session (it must outlive the
+   *                            daemon).
+   *  \param [in] iSocketPath   The path of the Unix domain socket.
+   *  \param [in] iNumWorkers   The number of connections served concurrently
+   *                            (the idle ones are not counted).
+   *  \param [in] iSolutionCache The cache of solutions shared by the workers
+   *                            (it must outlive the daemon), nullptr for none.
+   */
+  SolverDaemon(const Solver& iSolver,
+               std::string iSocketPath,
+               const int iNumWorkers,
+               SolutionCache* iSolutionCache = nullptr);
+
+  /*! \brief Listens on the socket and serves the clients until `stop` is
+   *  invoked. A socket left at the path by a daemon no longer running is
+   *  replaced.
+   *  \throw std::runtime_error in case the socket cannot be created (e.g.,
+   *  another daemon is listening on it).
+   */
+  void run();
+
+  /*! \brief Requests the daemon to stop.
+   *  \note It is safe to invoke it from another thread or from a signal
+   *  handler.
+   */
+  void stop() noexcept;
+
+  //! \return the response line (without new line) for a request line.
+  std::string processRequest(const std::string& iRequest) const;
+
+ private:
+  //! \brief A connection with the part of the request not received yet.
+  struct Connection_t {
+    int _socket;
+    std::string _buffer;
+  };
+
+  const Solver& _solver;
+  const std::string _socketPath;
+  const int _numWorkers;
+
+  SolutionCache* const _solutionCache;
+  mutable std::mutex _solutionCacheMutex;
+
+  std::atomic<bool> _stopRequested{false};
+
+  std::mutex _connectionsMutex;
+  std::condition_variable _connectionsCondition;
+
+  //! \brief The connections with something to read, waiting for a worker.
+  std::deque<Connection_t> _connections;
+
+  //! \brief The connections given back by the workers, to be polled again.
+  std::vector<Connection_t> _idleConnections;
+
+  //! \brief A worker giving back a connection writes on it to wake up `run`.
+  std::array<int, 2> _wakeUpPipe = {-1, -1};
+
+  //! \brief The body of a worker: it serves connections until the stop.
+  void serveConnections();
+
+  /*! \brief Serves the complete request lines received on a connection.
+   *  \return false in case the connection has been closed.
+   */
+  bool serveConnection(Connection_t* ioConnection);
+};
+
+}  // namespace kpuzzle4
+
+#endif  // KPUZZLE4__SOLVER_DAEMON__HPP
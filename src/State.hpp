@@ -102,6 +102,28 @@ class State {
   //! \return the Hash of the state applying a mask.
   constexpr std::uint64_t getHashWithMask(const Mask_t iMask) const noexcept;
 
+  /*! \brief Reflects the state about the main diagonal of the board.
+   *  Tiles are relabeled so that the sorted state maps onto itself, therefore
+   *  the reflected state has the same optimal solution length. Moves map as
+   *  LEFT <-> UP and RIGHT <-> DOWN.
+   *  \return the reflected (transposed) state.
+   */
+  constexpr State getTransposedState() const noexcept;
+
+  //! \return the index reflected about the main diagonal of the board.
+  static constexpr int getTransposedIndex(const int iIndex) noexcept;
+
+  /*! \brief The dual state is the inverse permutation (relabeled so that the
+   *  sorted state maps onto itself): the tile of each position is the tile
+   *  whose goal is the position of that tile in this state.
+   *  \note Only when the "Space" tile is in its goal position the dual state
+   *  has the same optimal solution length (the moves of a solution, applied
+   *  in reverse order, solve the dual state). Otherwise it might not even be
+   *  solveable.
+   *  \return the dual state.
+   */
+  constexpr State getDualState() const noexcept;
+
   //! \brief Generates a sorted state.
   static constexpr State generateSortedState() noexcept;
 
@@ -229,6 +251,33 @@ constexpr std::uint64_t State::getHashWithMask(const Mask_t iMask) const noexcep
   return _tilesPositions & iMask;
 }
 
+constexpr int State::getTransposedIndex(const int iIndex) noexcept {
+  return (iIndex % kSize) * kSize + iIndex / kSize;
+}
+
+constexpr State State::getDualState() const noexcept {
+  // The tile t at position p becomes the tile (p + 1) at position (t - 1),
+  // both modulo 16: add one to each nibble (no carry) and rotate by a nibble.
+  constexpr std::uint64_t kMaskLowBits = 0x7777777777777777;
+  constexpr std::uint64_t kMaskHighBit = 0x8888888888888888;
+  constexpr std::uint64_t kOnes = 0x1111111111111111;
+
+  const std::uint64_t aNext = ((_tilesPositions & kMaskLowBits) + kOnes) ^ (_tilesPositions & kMaskHighBit);
+  return State{static_cast<StateConfiguration_t>((aNext >> 4) | (aNext << 60))};
+}
+
+constexpr State State::getTransposedState() const noexcept {
+  StateConfiguration_t aConfiguration = 0;
+
+  for (int i = 0; i < kNumTiles; ++i) {
+    const int aTile = getValueTileAt(i);
+    const int aTransposedTile = aTile != kValueSpaceTile ? getTransposedIndex(aTile - 1) + 1 : kValueSpaceTile;
+    aConfiguration |= static_cast<std::uint64_t>(aTransposedTile) << (getTransposedIndex(i) << 2);
+  }
+
+  return State{aConfiguration};
+}
+
 }  // namespace kpuzzle4
 
 #endif  // KPUZZLE4__STATE__HPP
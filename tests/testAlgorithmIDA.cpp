@@ -18,6 +18,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <AlgorithmIDA.hpp>
+#include <DistanceManhattan.hpp>
+#include <unordered_set>
+#include <vector>
+#include "testHelpers.hpp"
 
 namespace kpuzzle4::testing {
 
@@ -86,4 +90,102 @@ TEST(AlgorithmIDA, ImpossibleCase) {
                    ._solutionFound);
 }
 
+TEST(AlgorithmIDA, IterationHook) {
+  class HeuristicWithHook {
+   public:
+    int operator()(const State&) const { return 0; }
+    void onNewIteration() { ++_numIterations; }
+
+    int _numIterations = 0;
+  };
+
+  State aState = State::generateSortedState();
+  aState.moveLeft(&aState);
+  aState.moveUp(&aState);
+
+  HeuristicWithHook aHeuristicFunction;
+  AlgorithmIDA aAlgorithmIDA;
+  ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aHeuristicFunction)._solutionFound);
+
+  // Iterations with MaxDepth: 0, 2.
+  ASSERT_EQ(aAlgorithmIDA.getCurrentMaxDepth(), 2);
+  ASSERT_EQ(aHeuristicFunction._numIterations, 2);
+}
+
+TEST(AlgorithmIDA, Prefetch) {
+  class HeuristicWithPrefetch {
+   public:
+    explicit HeuristicWithPrefetch(const State& iStartingState) : _startingState(iStartingState) {}
+
+    int operator()(const State& iState) const {
+      if (!(iState == _startingState)) ++_numNotPrefetched;
+      return DistanceManhattan::computeDistanceWithFinal(iState);
+    }
+    void prefetch(const State& iState, const std::size_t iSlot) {
+      ++_numPrefetches;
+      if (_slots.size() <= iSlot) _slots.resize(iSlot + 1);
+      _slots[iSlot] = iState;
+    }
+    int getCostPrefetched(const State& iState, const std::size_t iSlot, const int) const {
+      // The slot is the one given when the state has been prefetched.
+      if (iSlot >= _slots.size() || !(_slots[iSlot] == iState)) ++_numMissing;
+      return DistanceManhattan::computeDistanceWithFinal(iState);
+    }
+
+    State _startingState;
+    int _numPrefetches = 0;
+    mutable int _numNotPrefetched = 0;
+    mutable int _numMissing = 0;
+    std::vector<State> _slots;
+  };
+
+  State aState = State::generateSortedState();
+  for (int i = 0; i < 6; ++i) {
+    i % 2 ? aState.moveLeft(&aState) : aState.moveUp(&aState);
+  }
+
+  HeuristicWithPrefetch aHeuristicFunction{aState};
+  AlgorithmIDA aAlgorithmIDA;
+  ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aHeuristicFunction)._solutionFound);
+  ASSERT_GT(aHeuristicFunction._numPrefetches, 0);
+  ASSERT_EQ(aHeuristicFunction._numNotPrefetched, 0);
+  ASSERT_EQ(aHeuristicFunction._numMissing, 0);
+
+  // With the bidirectional pathmax the children are looked up at once.
+  HeuristicWithPrefetch aHeuristicFunctionPathMax{aState};
+  aAlgorithmIDA.setBidirectionalPathMax(true);
+  ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aHeuristicFunctionPathMax)._solutionFound);
+  ASSERT_EQ(aHeuristicFunctionPathMax._numPrefetches, 0);
+}
+
+TEST(AlgorithmIDA, BidirectionalPathMax) {
+  // Inconsistent (but admissible) heuristic: the Manhattan distance only when
+  // the "Space" tile is on a even cell.
+  const auto aHeuristicFunction = [](const State& iState) {
+    const int aIndexSpace = iState.getIndexSpace();
+    const bool aEvenCell = (aIndexSpace / State::kSize + aIndexSpace % State::kSize) % 2 == 0;
+    return aEvenCell ? DistanceManhattan::computeDistanceWithFinal(iState) : 0;
+  };
+
+  AlgorithmIDA aAlgorithmIDA;
+  ASSERT_FALSE(aAlgorithmIDA.isBidirectionalPathMax());
+
+  AlgorithmIDA aAlgorithmIDAPathMax;
+  aAlgorithmIDAPathMax.setBidirectionalPathMax(true);
+  ASSERT_TRUE(aAlgorithmIDAPathMax.isBidirectionalPathMax());
+
+  std::unordered_set<State::StateConfiguration_t> aStates;
+  for (std::uint64_t aSeed = 0; aSeed < 8; ++aSeed) {
+    const State aState = generateNearState(aSeed, 40);
+    aStates.insert(aState.getStateConfiguration());
+
+    ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aHeuristicFunction)._solutionFound);
+    ASSERT_TRUE(aAlgorithmIDAPathMax.findSolution(aState, aHeuristicFunction)._solutionFound);
+
+    ASSERT_EQ(aAlgorithmIDAPathMax.getSolutionLength(), aAlgorithmIDA.getSolutionLength());
+    ASSERT_LE(aAlgorithmIDAPathMax.getExploredNodes(), aAlgorithmIDA.getExploredNodes());
+  }
+  ASSERT_EQ(aStates.size(), 8u);
+}
+
 }  // namespace kpuzzle4::testing
@@ -0,0 +1,46 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <CacheMissCounter.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kpuzzle4::testing {
+
+TEST(CacheMissCounter, Count) {
+  CacheMissCounter aCacheMissCounter;
+  if (!aCacheMissCounter.isAvailable()) {
+    ASSERT_EQ(aCacheMissCounter.getCount(), -1);
+    GTEST_SKIP() << "Hardware counters not available";
+  }
+
+  // Far larger than the cache.
+  std::vector<std::uint64_t> aBuffer(std::uint64_t{1} << 25, 1);
+  std::uint64_t aSum = 0;
+
+  aCacheMissCounter.start();
+  for (std::uint64_t i = 0; i < aBuffer.size(); i += 8) {
+    aSum += aBuffer[(i * 4099) % aBuffer.size()];
+  }
+  aCacheMissCounter.stop();
+
+  ASSERT_GT(aSum, 0u);
+  ASSERT_GT(aCacheMissCounter.getCount(), 0);
+}
+
+}  // namespace kpuzzle4::testing
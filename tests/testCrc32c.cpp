@@ -0,0 +1,70 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <Crc32c.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kpuzzle4::testing {
+
+TEST(Crc32c, knownValues) {
+  const std::string aDigits = "123456789";
+  ASSERT_EQ(Crc32c::compute(aDigits.data(), aDigits.size()), 0xE3069283);
+  ASSERT_EQ(Crc32c::computeScalar(aDigits.data(), aDigits.size()), 0xE3069283);
+
+  const std::vector<std::uint8_t> aZeros(32, 0x00);
+  ASSERT_EQ(Crc32c::compute(aZeros.data(), aZeros.size()), 0x8A9136AA);
+  const std::vector<std::uint8_t> aOnes(32, 0xFF);
+  ASSERT_EQ(Crc32c::compute(aOnes.data(), aOnes.size()), 0x62A8AB43);
+
+  ASSERT_EQ(Crc32c::compute(nullptr, 0), 0);
+}
+
+TEST(Crc32c, pieces) {
+  std::vector<std::uint8_t> aData(1000);
+  for (std::size_t i = 0; i < aData.size(); ++i) {
+    aData[i] = static_cast<std::uint8_t>(i * 31 + 7);
+  }
+
+  const std::uint32_t aCrc = Crc32c::compute(aData.data(), aData.size());
+  for (const std::size_t aSplit : {1, 7, 8, 333, 999}) {
+    const std::uint32_t aFirst = Crc32c::compute(aData.data(), aSplit);
+    ASSERT_EQ(Crc32c::compute(aData.data() + aSplit, aData.size() - aSplit, aFirst), aCrc);
+  }
+}
+
+TEST(Crc32c, sameKernels) {
+  std::vector<std::uint8_t> aData(4096 + 64);
+  for (std::size_t i = 0; i < aData.size(); ++i) {
+    aData[i] = static_cast<std::uint8_t>((i * 2654435761u) >> 13);
+  }
+
+  // Any length and alignment.
+  for (std::size_t aOffset = 0; aOffset < 8; ++aOffset) {
+    for (const std::size_t aSize : {0, 1, 5, 8, 15, 64, 4096}) {
+      const std::uint32_t aCrc = Crc32c::computeScalar(aData.data() + aOffset, aSize);
+      ASSERT_EQ(Crc32c::compute(aData.data() + aOffset, aSize), aCrc);
+      if (Crc32c::isHardwareSupported()) {
+        ASSERT_EQ(Crc32c::computeHardware(aData.data() + aOffset, aSize), aCrc);
+      }
+    }
+  }
+}
+
+}  // namespace kpuzzle4::testing
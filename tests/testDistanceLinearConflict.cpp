@@ -0,0 +1,71 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <DistanceLinearConflict.hpp>
+#include <DistanceManhattan.hpp>
+#include <Solver.hpp>
+
+namespace kpuzzle4::testing {
+
+TEST(DistanceLinearConflict, DistanceWithFinal) {
+  const State aState = State::generateSortedState();
+  ASSERT_EQ(DistanceLinearConflict::computeDistanceWithFinal(aState), 0);
+  ASSERT_EQ(DistanceLinearConflict::computeConflictsWithFinal(aState), 0);
+}
+
+TEST(DistanceLinearConflict, RowConflicts) {
+  const State aState{{2, 1, 4, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0}};
+  ASSERT_EQ(DistanceLinearConflict::computeConflictsWithFinal(aState), 4);
+  ASSERT_EQ(DistanceLinearConflict::computeDistanceWithFinal(aState), 8);
+}
+
+TEST(DistanceLinearConflict, ColumnConflicts) {
+  const State aState{{5, 2, 3, 4, 1, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0}};
+  ASSERT_EQ(DistanceLinearConflict::computeConflictsWithFinal(aState), 2);
+  ASSERT_EQ(DistanceLinearConflict::computeDistanceWithFinal(aState), 4);
+}
+
+TEST(DistanceLinearConflict, LongestIncreasingSubsequence) {
+  // Only one tile (out of four) has to leave the row.
+  const State aState{{4, 1, 2, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0, 15}};
+  ASSERT_EQ(DistanceLinearConflict::computeConflictsWithFinal(aState), 2);
+}
+
+TEST(DistanceLinearConflict, Admissible) {
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::MANHATTAN;
+  const Solver aSolver{aOptions};
+
+  for (std::uint64_t aSeed = 0; aSeed < 32; ++aSeed) {
+    const State aState = State::generateValidRandState(aSeed);
+    const auto aManhattan = DistanceManhattan::computeDistanceWithFinal(aState);
+    const auto aLinearConflict = DistanceLinearConflict::computeDistanceWithFinal(aState);
+    ASSERT_GE(aLinearConflict, aManhattan);
+    ASSERT_EQ((aLinearConflict - aManhattan) % 2, 0);
+  }
+
+  State aState = State::generateSortedState();
+  for (int i = 0; i < 24; ++i) {
+    i % 2 == 0 ? aState.moveLeft(&aState) : aState.moveUp(&aState);
+    const Solver::Solution_t aSolution = aSolver.solve(aState);
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_LE(DistanceLinearConflict::computeDistanceWithFinal(aState), aSolution._length);
+  }
+}
+
+}  // namespace kpuzzle4::testing
@@ -74,4 +74,22 @@ TEST(DistanceManhattan, DistanceWithFinal) {
   ASSERT_EQ(DistanceManhattan::computeDistanceWithFinal(aState), 0);
 }
 
+TEST(DistanceManhattan, ScalarAndSimdIdentical) {
+  if (!DistanceManhattan::isSimdSupported()) {
+    GTEST_SKIP() << "SIMD kernel not supported";
+  }
+
+  for (std::uint64_t aSeed = 0; aSeed < 1024; ++aSeed) {
+    const State aStateA = State::generateValidRandState(aSeed);
+    const State aStateB = State::generateValidRandState(aSeed + 1024);
+
+    ASSERT_EQ(DistanceManhattan::computeDistanceScalar(aStateA, aStateB),
+              DistanceManhattan::computeDistanceSimd(aStateA, aStateB));
+    ASSERT_EQ(DistanceManhattan::computeDistanceScalar(aStateA, aStateB),
+              DistanceManhattan::computeDistance(aStateA, aStateB));
+    ASSERT_EQ(DistanceManhattan::computeDistanceScalar(aStateA, DistanceManhattan::kFinalState),
+              DistanceManhattan::computeDistanceSimd(aStateA, DistanceManhattan::kFinalState));
+  }
+}
+
 }  // namespace kpuzzle4::testing
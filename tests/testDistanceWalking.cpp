@@ -0,0 +1,129 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <DistanceManhattan.hpp>
+#include <DistanceWalking.hpp>
+#include <HeuristicComposer.hpp>
+#include <Solver.hpp>
+#include <cstdint>
+#include <vector>
+#include "testHelpers.hpp"
+
+namespace kpuzzle4::testing {
+
+TEST(DistanceWalking, DistanceWithFinal) {
+  const State aState = State::generateSortedState();
+  ASSERT_EQ(DistanceWalking::computeDistanceWithFinal(aState), 0);
+
+  State aStateMoved;
+  aState.moveUp(&aStateMoved);
+  ASSERT_EQ(DistanceWalking::computeRowsDistanceWithFinal(aStateMoved), 1);
+  ASSERT_EQ(DistanceWalking::computeColumnsDistanceWithFinal(aStateMoved), 0);
+
+  aState.moveLeft(&aStateMoved);
+  ASSERT_EQ(DistanceWalking::computeRowsDistanceWithFinal(aStateMoved), 0);
+  ASSERT_EQ(DistanceWalking::computeColumnsDistanceWithFinal(aStateMoved), 1);
+}
+
+TEST(DistanceWalking, NumWalkStates) {
+  ASSERT_EQ(DistanceWalking::getNumWalkStates(), 24964);
+}
+
+TEST(DistanceWalking, SwappedTiles) {
+  // The tiles are in their goal row, but the swaps need the "Space" to walk
+  // there: more moves than the Manhattan distance.
+  const State aState{{2, 1, 4, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0}};
+  ASSERT_EQ(DistanceWalking::computeRowsDistanceWithFinal(aState), 0);
+  ASSERT_EQ(DistanceWalking::computeColumnsDistanceWithFinal(aState), 6);
+  ASSERT_GT(DistanceWalking::computeDistanceWithFinal(aState), DistanceManhattan::computeDistanceWithFinal(aState));
+}
+
+TEST(DistanceWalking, Admissible) {
+  for (std::uint64_t aSeed = 0; aSeed < 32; ++aSeed) {
+    const State aState = State::generateValidRandState(aSeed);
+    const auto aManhattan = DistanceManhattan::computeDistanceWithFinal(aState);
+    const auto aWalking = DistanceWalking::computeDistanceWithFinal(aState);
+    ASSERT_GE(aWalking, aManhattan);
+    ASSERT_EQ((aWalking - aManhattan) % 2, 0);
+  }
+
+  // The optimal lengths are given by an independent heuristic.
+  Solver::Options_t aOptionsLinearConflict;
+  aOptionsLinearConflict._heuristicType = Solver::HeuristicType::MANHATTAN_LC;
+  const Solver aSolverLinearConflict{aOptionsLinearConflict};
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::WALKING;
+  const Solver aSolver{aOptions};
+
+  for (std::uint64_t aSeed = 0; aSeed < 16; ++aSeed) {
+    const State aState = generateNearState(aSeed, 100);
+    const Solver::Solution_t aSolution = aSolverLinearConflict.solve(aState);
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_LE(DistanceWalking::computeDistanceWithFinal(aState), aSolution._length);
+    ASSERT_EQ(aSolver.solve(aState)._length, aSolution._length);
+  }
+}
+
+TEST(DistanceWalking, Incremental) {
+  const DistanceWalking::Incremental aIncremental;
+  State aState = generateNearState(0, 40);
+  ASSERT_EQ(aIncremental(aState), DistanceWalking::computeDistanceWithFinal(aState));
+
+  // Along a walk: the children of the last node are prefetched, then one of them is visited.
+  for (int i = 0; i < 64; ++i) {
+    std::vector<State> aChildren(4);
+    const bool aMoved[] = {aState.moveLeft(&aChildren[0]) != -1, aState.moveRight(&aChildren[1]) != -1,
+                           aState.moveUp(&aChildren[2]) != -1, aState.moveDown(&aChildren[3]) != -1};
+    for (std::size_t j = 0; j < aChildren.size(); ++j) {
+      if (aMoved[j]) aIncremental.prefetch(aChildren[j], j);
+    }
+
+    std::size_t aVisited = static_cast<std::size_t>(i * 3) % aChildren.size();
+    while (!aMoved[aVisited]) aVisited = (aVisited + 1) % aChildren.size();
+    aState = aChildren[aVisited];
+    ASSERT_EQ(aIncremental.getCostPrefetched(aState, aVisited, 0), DistanceWalking::computeDistanceWithFinal(aState));
+  }
+}
+
+TEST(DistanceWalking, IncrementalNotComputed) {
+  // Second in a composition: it is not computed when the first one exceeds the bound.
+  const auto aHeuristic = makeHeuristicMax(DistanceManhattan::computeDistanceWithFinal, DistanceWalking::Incremental{});
+  State aState = generateNearState(1, 40);
+  ASSERT_EQ(aHeuristic(aState), DistanceWalking::computeDistanceWithFinal(aState));
+
+  for (int i = 0; i < 64; ++i) {
+    std::vector<State> aChildren(4);
+    const bool aMoved[] = {aState.moveLeft(&aChildren[0]) != -1, aState.moveRight(&aChildren[1]) != -1,
+                           aState.moveUp(&aChildren[2]) != -1, aState.moveDown(&aChildren[3]) != -1};
+    for (std::size_t j = 0; j < aChildren.size(); ++j) {
+      if (aMoved[j]) aHeuristic.prefetch(aChildren[j], j);
+    }
+
+    std::size_t aVisited = static_cast<std::size_t>(i * 3) % aChildren.size();
+    while (!aMoved[aVisited]) aVisited = (aVisited + 1) % aChildren.size();
+    aState = aChildren[aVisited];
+    if (i % 3 == 0) {
+      // Only the Manhattan distance is computed, even though the node is then expanded.
+      ASSERT_EQ(aHeuristic.getCostPrefetched(aState, aVisited, -1), DistanceManhattan::computeDistanceWithFinal(aState));
+    } else {
+      ASSERT_EQ(aHeuristic.getCostPrefetched(aState, aVisited, 1000), DistanceWalking::computeDistanceWithFinal(aState));
+    }
+  }
+}
+
+}  // namespace kpuzzle4::testing
@@ -0,0 +1,107 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <DynamicPatternDB.hpp>
+#include <PatternDB.hpp>
+#include <sstream>
+#include <stdexcept>
+
+namespace kpuzzle4::testing {
+
+namespace {
+
+constexpr SearchNode::Mask_t kMaskA = 0x000000000000FFFF;
+constexpr SearchNode::Mask_t kMaskB = 0x000000000FFF000F;
+constexpr SearchNode::Mask_t kMaskC = 0x000000FFF000000F;
+constexpr SearchNode::Mask_t kMaskD = 0x000FFF000000000F;
+constexpr SearchNode::Mask_t kMaskE = 0xFFF000000000000F;
+
+using PatternDB_t = PatternDB<kMaskA, kMaskB, kMaskC, kMaskD, kMaskE>;
+
+}  // anonymous namespace
+
+TEST(DynamicPatternDB, isValidPartitions) {
+  ASSERT_TRUE(DynamicPatternDB::isValidPartitions({kMaskA, kMaskB, kMaskC, kMaskD, kMaskE}));
+  ASSERT_TRUE(DynamicPatternDB::isValidPartitions({0x00000000FFFFFFFF, 0xFFFFFFFF0000000F}));
+
+  // Not disjoint, without zero, not total, empty, not a nibble mask.
+  ASSERT_FALSE(DynamicPatternDB::isValidPartitions({0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF}));
+  ASSERT_FALSE(DynamicPatternDB::isValidPartitions({0xFFFFFFF00000000F, 0x0000000FFFFFFFF0}));
+  ASSERT_FALSE(DynamicPatternDB::isValidPartitions({0xFFFFFFF00000000F, 0x0000000FFFFFFF0F}));
+  ASSERT_FALSE(DynamicPatternDB::isValidPartitions({}));
+  ASSERT_FALSE(DynamicPatternDB::isValidPartitions({0x00000000FFFFFFF1, 0xFFFFFFFF0000000F}));
+
+  ASSERT_THROW(DynamicPatternDB({0xFFFFFFF00000000F}), std::runtime_error);
+}
+
+TEST(DynamicPatternDB, sameCostOfPatternDB) {
+  PatternDB_t aPatternDB;
+  aPatternDB.generate();
+
+  DynamicPatternDB aDynamicPatternDB({kMaskA, kMaskB, kMaskC, kMaskD, kMaskE});
+  ASSERT_EQ(aDynamicPatternDB.getNumPartitions(), PatternDB_t::kNumPartitions);
+  aDynamicPatternDB.generate();
+
+  for (int i = 0; i < PatternDB_t::kNumPartitions; ++i) {
+    ASSERT_EQ(aDynamicPatternDB.getCostTable(i), aPatternDB.getCostTable(i));
+  }
+
+  aPatternDB.setReflectedLookup(true);
+  aDynamicPatternDB.setReflectedLookup(true);
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aDynamicPatternDB.getCost(aState), aPatternDB.getCost(aState));
+  }
+
+  aPatternDB.setPackedStorage(true);
+  aDynamicPatternDB.setPackedStorage(true);
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aDynamicPatternDB.getCost(aState), aPatternDB.getCost(aState));
+  }
+}
+
+TEST(DynamicPatternDB, partitionsFromFile) {
+  PatternDB_t aPatternDB;
+  aPatternDB.generate();
+
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+
+  aSs.seekg(std::ios_base::beg);
+  const DynamicPatternDB::MaskPartitions_t aMaskPartitions = DynamicPatternDB::deserializeMaskPartitions(&aSs);
+  ASSERT_EQ(aMaskPartitions,
+            DynamicPatternDB::MaskPartitions_t(aPatternDB.getMaskPartitions().begin(),
+                                               aPatternDB.getMaskPartitions().end()));
+
+  DynamicPatternDB aDynamicPatternDB(aMaskPartitions);
+  aSs.seekg(std::ios_base::beg);
+  aDynamicPatternDB.deserialize(&aSs);
+
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aDynamicPatternDB.getCost(aState), aPatternDB.getCost(aState));
+  }
+
+  // Other partitions are rejected.
+  DynamicPatternDB aOtherPatternDB({0x00000000FFFFFFFF, 0xFFFFFFFF0000000F});
+  aSs.seekg(std::ios_base::beg);
+  ASSERT_THROW(aOtherPatternDB.deserialize(&aSs), std::runtime_error);
+}
+
+}  // namespace kpuzzle4::testing
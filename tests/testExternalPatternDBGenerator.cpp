@@ -0,0 +1,99 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <ExternalPatternDBGenerator.hpp>
+#include <PatternDB.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace kpuzzle4::testing {
+
+class ExternalPatternDBGeneratorTest : public ::testing::Test {
+ protected:
+  static constexpr const char* kFileName = "testExternalPatternDBGenerator.data";
+
+  void SetUp() override { std::remove(kFileName); }
+  void TearDown() override { std::remove(kFileName); }
+
+  //! \return the content of the file.
+  static std::string readFile(const char* iFileName) {
+    std::ifstream aFile(iFileName, std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(aFile), std::istreambuf_iterator<char>());
+  }
+};
+
+TEST_F(ExternalPatternDBGeneratorTest, sameFileOfPatternDB) {
+  // The second partition is the transposition of the first one.
+  static constexpr PatternPartition::Mask_t kMask = 0x00000000000FFF0F;
+  static constexpr PatternPartition::Mask_t kMaskTransposed = 0x00F000F000F0000F;
+  static constexpr PatternPartition::Mask_t kMaskOther = 0x000000FFF000000F;
+  PatternDB<kMask, kMaskTransposed, kMaskOther> aPatternDB;
+  aPatternDB.generate();
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+
+  // A small limit of memory: the children of a layer are sorted in many runs.
+  const ExternalPatternDBGenerator aGenerator{{kMask, kMaskTransposed, kMaskOther}, 0};
+  ASSERT_EQ(aGenerator.getRunSize(), 1024);
+  aGenerator.generate(kFileName);
+  ASSERT_EQ(readFile(kFileName), aSs.str());
+
+  // The temporary files are removed.
+  for (int i = 0; i < 3; ++i) {
+    const std::string aLayerFileName = std::string(kFileName) + ".tmp.layer" + std::to_string(i);
+    ASSERT_TRUE(std::ifstream(aLayerFileName).fail());
+  }
+  ASSERT_TRUE(std::ifstream(std::string(kFileName) + ".tmp.run0").fail());
+
+  // The file is loaded as the one of the pattern database.
+  std::ifstream aFile(kFileName, std::ios_base::binary);
+  PatternDB<kMask, kMaskTransposed, kMaskOther> aPatternDBLoaded;
+  aPatternDBLoaded.deserialize(&aFile);
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aPatternDBLoaded.getCost(aState), aPatternDB.getCost(aState));
+  }
+}
+
+TEST_F(ExternalPatternDBGeneratorTest, invalidTemporaryDirectory) {
+  const ExternalPatternDBGenerator aGenerator{{0x000000FFF000000F}, 0, "notExistingDirectory"};
+  ASSERT_THROW(aGenerator.generate(kFileName), std::runtime_error);
+}
+
+TEST_F(ExternalPatternDBGeneratorTest, temporaryFilesRemovedOnError) {
+  // The first run cannot be written: a directory has its name.
+  const std::string aRunFileName = std::string(kFileName) + ".tmp.run0";
+  std::filesystem::create_directory(aRunFileName);
+  std::ofstream(kFileName) << "previous";
+  const ExternalPatternDBGenerator aGenerator{{0x000000FFF000000F}, 0};
+  ASSERT_THROW(aGenerator.generate(kFileName), std::runtime_error);
+  std::filesystem::remove(aRunFileName);
+
+  // Neither the temporary files nor the incomplete file are left, the previous file is kept.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_FALSE(std::filesystem::exists(std::string(kFileName) + ".tmp.layer" + std::to_string(i)));
+  }
+  ASSERT_FALSE(std::filesystem::exists(std::string(kFileName) + ".tmp"));
+  ASSERT_EQ(readFile(kFileName), "previous");
+}
+
+}  // namespace kpuzzle4::testing
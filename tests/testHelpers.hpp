@@ -0,0 +1,99 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef KPUZZLE4__TEST_HELPERS__HPP
+#define KPUZZLE4__TEST_HELPERS__HPP
+#include <State.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kpuzzle4::testing {
+
+/*! \brief It generates a state at most `iNumMoves` moves away from the sorted
+ *  one, with a random walk given by the seed (different seeds give different
+ *  states, the same seed always the same state).
+ */
+inline State generateNearState(const std::uint64_t iSeed, const int iNumMoves = 20) {
+  State aState = State::generateSortedState();
+  std::uint64_t aSeed = iSeed;
+  for (int i = 0; i < iNumMoves; ++i) {
+    aSeed = aSeed * 6364136223846793005ull + 1442695040888963407ull;
+    switch ((aSeed >> 33) % 4) {
+      case 0:
+        aState.moveLeft(&aState);
+        break;
+      case 1:
+        aState.moveRight(&aState);
+        break;
+      case 2:
+        aState.moveUp(&aState);
+        break;
+      case 3:
+        aState.moveDown(&aState);
+        break;
+    }
+  }
+  return aState;
+}
+
+/*! \return the file of the pattern database in the original format: the
+ *  number of partitions, the masks, then the size and the entries of each
+ *  table, sparse (the position of the j-th tile, in decreasing order of value,
+ *  is the j-th nibble of the index) or dense.
+ */
+template <typename PatternDBType>
+std::string serializeLegacyPatternDB(const PatternDBType& iPatternDB, const bool iDenseTables = false) {
+  std::string aFile;
+  const auto aAppend = [&aFile](const auto& iValue) {
+    aFile.append(reinterpret_cast<const char*>(&iValue), sizeof(iValue));
+  };
+
+  aAppend(static_cast<std::int32_t>(iPatternDB.getNumPartitions()));
+  for (int i = 0; i < iPatternDB.getNumPartitions(); ++i) {
+    aAppend(static_cast<std::uint64_t>(iPatternDB.getPartition(i).getMask()));
+  }
+  for (int i = 0; i < iPatternDB.getNumPartitions(); ++i) {
+    const auto& aPartition = iPatternDB.getPartition(i);
+    const auto& aCostTable = iPatternDB.getCostTable(i);
+
+    // The positions not taken by any entry were never reached.
+    std::vector<std::int8_t> aTable(aCostTable.begin(), aCostTable.end());
+    if (!iDenseTables) {
+      aTable.assign(std::uint64_t{1} << (aPartition.getNumTiles() << 2), -1);
+      aPartition.forEachHash([&aTable, &aPartition, &aCostTable](const auto iIndex, const std::uint64_t iHash) {
+        std::uint64_t aIndexLegacy = 0;
+        int aShift = 0;
+        for (int aTile = State::kNumTilesMinusOne; aTile > 0; --aTile) {
+          if (((aPartition.getMask() >> (aTile << 2)) & 0xF) == 0) continue;
+          aIndexLegacy |= ((iHash >> (aTile << 2)) & 0xF) << aShift;
+          aShift += 4;
+        }
+        aTable[aIndexLegacy] = aCostTable[iIndex];
+      });
+    }
+
+    aAppend(static_cast<std::uint64_t>(aTable.size()));
+    aFile.append(reinterpret_cast<const char*>(aTable.data()), aTable.size());
+  }
+
+  return aFile;
+}
+
+}  // namespace kpuzzle4::testing
+
+#endif  // KPUZZLE4__TEST_HELPERS__HPP
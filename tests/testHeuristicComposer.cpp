@@ -0,0 +1,174 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <AlgorithmIDA.hpp>
+#include <DistanceLinearConflict.hpp>
+#include <DistanceManhattan.hpp>
+#include <HeuristicComposer.hpp>
+#include <cstdint>
+#include "testHelpers.hpp"
+
+namespace kpuzzle4::testing {
+
+class HeuristicConstant {
+ public:
+  HeuristicConstant(const int iCost, int* ioNumCalls) : _cost(iCost), _numCalls(ioNumCalls) {}
+
+  int operator()(const State&) const {
+    ++*_numCalls;
+    return _cost;
+  }
+
+ private:
+  int _cost;
+  int* _numCalls;
+};
+
+TEST(HeuristicComposer, maxAndSum) {
+  const State aState = State::generateSortedState();
+  int aNumCalls = 0;
+
+  const auto aMax = makeHeuristicMax(HeuristicConstant{3, &aNumCalls},
+                                     HeuristicConstant{7, &aNumCalls},
+                                     HeuristicConstant{5, &aNumCalls});
+  ASSERT_EQ(aMax(aState), 7);
+  ASSERT_EQ(aNumCalls, 3);
+
+  const auto aSum = makeHeuristicSum(HeuristicConstant{3, &aNumCalls},
+                                     HeuristicConstant{7, &aNumCalls},
+                                     HeuristicConstant{5, &aNumCalls});
+  ASSERT_EQ(aSum(aState), 15);
+  ASSERT_EQ(aNumCalls, 6);
+
+  const auto aNested = makeHeuristicMax(aSum, HeuristicConstant{20, &aNumCalls});
+  ASSERT_EQ(aNested(aState), 20);
+  ASSERT_EQ(aNumCalls, 10);
+}
+
+TEST(HeuristicComposer, shortCircuit) {
+  const State aState = State::generateSortedState();
+  int aNumCallsFirst = 0;
+  int aNumCallsSecond = 0;
+
+  const auto aMax = makeHeuristicMax(HeuristicConstant{10, &aNumCallsFirst}, HeuristicConstant{12, &aNumCallsSecond});
+  ASSERT_EQ(aMax(aState, 9), 10);
+  ASSERT_EQ(aNumCallsSecond, 0);
+  ASSERT_EQ(aMax(aState, 10), 12);
+  ASSERT_EQ(aNumCallsSecond, 1);
+
+  const auto aSum = makeHeuristicSum(HeuristicConstant{4, &aNumCallsFirst}, HeuristicConstant{4, &aNumCallsSecond});
+  ASSERT_EQ(aSum(aState, 3), 4);
+  ASSERT_EQ(aNumCallsSecond, 1);
+  ASSERT_EQ(aSum(aState, 4), 8);
+  ASSERT_EQ(aNumCallsSecond, 2);
+
+  // The bound left to the sum is the same, the one left to its second
+  // heuristic is reduced by the first one.
+  const auto aNested = makeHeuristicMax(aSum, HeuristicConstant{1, &aNumCallsFirst});
+  ASSERT_EQ(aNested(aState, 3), 4);
+  ASSERT_EQ(aNumCallsSecond, 2);
+}
+
+TEST(HeuristicComposer, iterationHook) {
+  class HeuristicWithHook {
+   public:
+    explicit HeuristicWithHook(int* ioNumIterations) : _numIterations(ioNumIterations) {}
+
+    int operator()(const State&) const { return 0; }
+    void onNewIteration() { ++*_numIterations; }
+
+   private:
+    int* _numIterations;
+  };
+
+  int aNumIterations = 0;
+  auto aMax = makeHeuristicMax(HeuristicWithHook{&aNumIterations}, DistanceManhattan::computeDistanceWithFinal);
+
+  State aState = State::generateSortedState();
+  aState.moveLeft(&aState);
+  aState.moveUp(&aState);
+
+  AlgorithmIDA aAlgorithmIDA;
+  ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aMax)._solutionFound);
+  ASSERT_EQ(aAlgorithmIDA.getSolutionLength(), 2);
+
+  // Only one iteration: the Manhattan distance is exact.
+  ASSERT_EQ(aNumIterations, 1);
+}
+
+TEST(HeuristicComposer, prefetch) {
+  class HeuristicWithPrefetch {
+   public:
+    explicit HeuristicWithPrefetch(int* ioNumPrefetches) : _numPrefetches(ioNumPrefetches) {}
+
+    int operator()(const State&) const { return 0; }
+    void prefetch(const State&, const std::size_t iSlot) const {
+      ++*_numPrefetches;
+      _lastSlot = iSlot;
+    }
+    int getCostPrefetched(const State&, const std::size_t iSlot, const int) const {
+      return iSlot == _lastSlot ? 1 : 0;
+    }
+
+   private:
+    int* _numPrefetches;
+    mutable std::size_t _lastSlot = 0;
+  };
+
+  int aNumPrefetches = 0;
+  const auto aMax =
+      makeHeuristicMax(HeuristicWithPrefetch{&aNumPrefetches}, DistanceManhattan::computeDistanceWithFinal);
+
+  // The slot is forwarded, the heuristics without prefetch are computed as usual.
+  const State aSortedState = State::generateSortedState();
+  aMax.prefetch(aSortedState, 3);
+  ASSERT_EQ(aNumPrefetches, 1);
+  ASSERT_EQ(aMax.getCostPrefetched(aSortedState, 3, 10), 1);
+  ASSERT_EQ(aMax.getCostPrefetched(aSortedState, 2, 10), 0);
+  ASSERT_EQ(aMax(aSortedState), 0);
+
+  State aState = State::generateSortedState();
+  aState.moveLeft(&aState);
+  aState.moveUp(&aState);
+
+  AlgorithmIDA aAlgorithmIDA;
+  ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aMax)._solutionFound);
+
+  // The children of each expanded node.
+  ASSERT_GT(aNumPrefetches, 1);
+}
+
+TEST(HeuristicComposer, AlgorithmIDA) {
+  const auto aMax = makeHeuristicMax(DistanceManhattan::computeDistanceWithFinal,
+                                     DistanceLinearConflict::computeDistanceWithFinal);
+
+  for (std::uint64_t aSeed = 0; aSeed < 8; ++aSeed) {
+    const State aState = generateNearState(aSeed, 60);
+
+    AlgorithmIDA aAlgorithmIDA;
+    ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, DistanceLinearConflict::computeDistanceWithFinal)._solutionFound);
+
+    AlgorithmIDA aAlgorithmIDAComposed;
+    ASSERT_TRUE(aAlgorithmIDAComposed.findSolution(aState, aMax)._solutionFound);
+
+    ASSERT_EQ(aAlgorithmIDAComposed.getSolutionLength(), aAlgorithmIDA.getSolutionLength());
+    ASSERT_EQ(aAlgorithmIDAComposed.getExploredNodes(), aAlgorithmIDA.getExploredNodes());
+  }
+}
+
+}  // namespace kpuzzle4::testing
@@ -0,0 +1,47 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <HugePageAllocator.hpp>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace kpuzzle4::testing {
+
+TEST(HugePageAllocator, SmallBlock) {
+  ASSERT_FALSE(HugePageMemory::isHugePageBlock(1024));
+
+  std::vector<int, HugePageAllocator<int>> aVector(256);
+  std::iota(aVector.begin(), aVector.end(), 0);
+  ASSERT_EQ(std::accumulate(aVector.cbegin(), aVector.cend(), 0), 255 * 256 / 2);
+}
+
+TEST(HugePageAllocator, LargeBlock) {
+  // Not a multiple of the huge page.
+  const std::size_t kSize = 3 * HugePageMemory::kHugePageSize + 1;
+  std::vector<std::uint8_t, HugePageAllocator<std::uint8_t>> aVector(kSize, 1);
+
+  if (HugePageMemory::isHugePageBlock(kSize)) {
+    const auto aAddress = reinterpret_cast<std::uintptr_t>(aVector.data());
+    ASSERT_EQ(aAddress % HugePageMemory::kHugePageSize, 0u);
+  }
+  aVector.back() = 2;
+  ASSERT_EQ(std::accumulate(aVector.cbegin(), aVector.cend(), std::size_t{0}), kSize + 1);
+}
+
+}  // namespace kpuzzle4::testing
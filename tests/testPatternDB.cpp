@@ -16,8 +16,23 @@
 
 */
 #include <gtest/gtest.h>
+#include <AlgorithmIDA.hpp>
+#include <Crc32c.hpp>
+#include <DistanceManhattan.hpp>
 #include <PatternDB.hpp>
+#include <PatternDBFile.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <random>
 #include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "testHelpers.hpp"
 
 namespace kpuzzle4::testing {
 
@@ -32,11 +47,11 @@ class PatternDBTest : public PatternDB<Masks...> {
   using Parent_t::checkAllPartitionsHasZero;
   using Parent_t::checkPartitionsAreTotal;
   using Parent_t::checkPartitionsDisjoint;
-  using Parent_t::computeIndicesOfIndex;
   using Parent_t::computeSizeOfTableCost;
   using Parent_t::countEnabledField;
   using Parent_t::getPartitionIndexOfTileIndex;
-  using Parent_t::hash2index;
+  using Parent_t::rankPattern;
+  using Parent_t::searchCost;
 };
 
 TEST(PatternDB, countEnabledField) {
@@ -72,38 +87,6 @@ TEST(PatternDB, getPartitionIndexOfTileIndexInvalid) {
   }
 }
 
-TEST(PatternDB, computeIndicesOfIndex) {
-  const PatternDBTest<0xFFFFFFFF0000000F, 0x00000000FFFFFFFF> aPatternDBA;
-  const PatternDBTest<0xF0F0F0F0F0F0F0FF, 0x0F0F0F0F0F0F0F0F> aPatternDBB;
-  const PatternDBTest<0xFF0000000000000F, 0x00FFFFFFFFFFFFFF> aPatternDBC;
-
-  ASSERT_EQ(aPatternDBA.computeIndicesOfIndex(), 0x0123456701234560);
-  ASSERT_EQ(aPatternDBB.computeIndicesOfIndex(), 0x0011223344556670);
-  ASSERT_EQ(aPatternDBC.computeIndicesOfIndex(), 0x010123456789abc0);
-}
-
-TEST(PatternDB, hash2index) {
-  static constexpr int kNumTests = 2048;
-  constexpr Mask_t kMask = 0xFF0000000000000F;
-  constexpr Mask_t kMaskNoZero = kMask ^ 0xF;
-  const PatternDBTest<kMask> aPatternDB;
-
-  for (int i = 0; i < kNumTests; ++i) {
-    const SearchNode aNodeA = State::generateValidRandState(i);
-    const SearchNode aNodeB = State::generateValidRandState(i + kNumTests);
-    const auto aHashA = aNodeA.getHashWithMask(kMask);
-    const auto aHashB = aNodeB.getHashWithMask(kMask);
-    const auto aIndexA = aPatternDB.hash2index(aHashA);
-    const auto aIndexB = aPatternDB.hash2index(aHashB);
-
-    if ((aHashA & kMaskNoZero) == (aHashB & kMaskNoZero)) {
-      ASSERT_EQ(aIndexA, aIndexB) << "Test Case i: " << i;
-    } else {
-      ASSERT_NE(aIndexA, aIndexB) << "Test Case i: " << i;
-    }
-  }
-}
-
 TEST(PatternDB, checkDisjoint) {
   PatternDBTest<0xFFFFFFFF0000000F, 0x00000000FFFFFFFF> aPatDBValid;
   PatternDBTest<0xF0F0F0F0F0F0F0FF, 0x0F0FFF0F0F0F0F0F> aPatDBNotValid;
@@ -165,36 +148,154 @@ TEST(PatternDB, checkSizeIndices) {
     const SearchNode aNodeB = State::generateValidRandState(i + kNumTests);
     const auto aHashA = aNodeA.getHashWithMask(kMaskA);
     const auto aHashB = aNodeB.getHashWithMask(kMaskB);
-    const auto aIndexA = aPatternDB.hash2index(aHashA);
-    const auto aIndexB = aPatternDB.hash2index(aHashB);
+    const auto aIndexA = aPatternDB.rankPattern(0, aHashA);
+    const auto aIndexB = aPatternDB.rankPattern(1, aHashB);
 
-    ASSERT_LE(aIndexA, 0xFFFFFFFF);
-    ASSERT_LE(aIndexB, 0xFFFFFFF);
+    ASSERT_LT(aIndexA, aPatternDB.computeSizeOfTableCost(kMaskA));
+    ASSERT_LT(aIndexB, aPatternDB.computeSizeOfTableCost(kMaskB));
   }
 }
 
 TEST(PatternDB, computeSizeOfTableCost) {
+  // All the partitions are ranked densely, whatever their number of tiles (e.g., 5 and 6 as well as 7 and 8).
   const PatternDBTest<0xFFFFFFFF0000000F,
                       0x00000000FFFFFFFF,
                       0xF,
                       0xFF,
                       0xFFF,
-                      0xFF0FF>
+                      0xFF0FF,
+                      0xFFFFF0000000000F,
+                      0x000000000FFFFFFF>
       aPatternDB;
 
   for (const auto aPartition : aPatternDB.getMaskPartitions()) {
     const int kSizePartition = aPatternDB.countEnabledField(aPartition) - 1;
     ASSERT_GE(kSizePartition, 0);
 
-    std::uint64_t aRightShiftedMask = 0x0;
+    std::uint64_t aNumPermutations = 1;
     for (int i = 0; i < kSizePartition; ++i) {
-      aRightShiftedMask <<= 4;
-      aRightShiftedMask |= 0xf;
+      aNumPermutations *= State::kNumTiles - i;
     }
 
-    ASSERT_EQ(aPatternDB.computeSizeOfTableCost(aPartition),
-              aRightShiftedMask + 1);
+    ASSERT_EQ(aPatternDB.computeSizeOfTableCost(aPartition), aNumPermutations);
   }
+  ASSERT_EQ(aPatternDB.computeSizeOfTableCost(0xFFFFF0000000000F), 16u * 15 * 14 * 13 * 12);
+}
+
+TEST(PatternDB, rankPattern) {
+  static constexpr int kNumTests = 2048;
+  constexpr Mask_t kMask = 0x00000000FFFFFFFF;
+  constexpr Mask_t kMaskNoZero = kMask ^ 0xF;
+  const PatternDBTest<kMask, 0xFFFFFFFF0000000F> aPatternDB;
+
+  const auto kSizeTable = aPatternDB.computeSizeOfTableCost(kMask);
+  ASSERT_EQ(kSizeTable, 16u * 15 * 14 * 13 * 12 * 11 * 10);
+
+  for (int i = 0; i < kNumTests; ++i) {
+    const SearchNode aNodeA = State::generateValidRandState(i);
+    const SearchNode aNodeB = State::generateValidRandState(i + kNumTests);
+    const auto aHashA = aNodeA.getHashWithMask(kMask);
+    const auto aHashB = aNodeB.getHashWithMask(kMask);
+    const auto aIndexA = aPatternDB.rankPattern(0, aHashA);
+    const auto aIndexB = aPatternDB.rankPattern(0, aHashB);
+
+    ASSERT_LT(aIndexA, kSizeTable);
+    if ((aHashA & kMaskNoZero) == (aHashB & kMaskNoZero)) {
+      ASSERT_EQ(aIndexA, aIndexB) << "Test Case i: " << i;
+    } else {
+      ASSERT_NE(aIndexA, aIndexB) << "Test Case i: " << i;
+    }
+  }
+}
+
+TEST(PatternDB, rankPatternDense) {
+  // All the partial permutations of 2 tiles have a different rank.
+  constexpr Mask_t kMask = 0x0000000000000FFF;
+  std::vector<bool> aRanked(16 * 15, false);
+
+  for (std::uint64_t aPositionA = 0; aPositionA < 16; ++aPositionA) {
+    for (std::uint64_t aPositionB = 0; aPositionB < 16; ++aPositionB) {
+      if (aPositionA == aPositionB) continue;
+      const std::uint64_t aHash = (aPositionB << 8) | (aPositionA << 4);
+      const auto aRank = PatternDBTest<kMask>::rankPattern(0, aHash);
+
+      ASSERT_LT(aRank, aRanked.size());
+      ASSERT_FALSE(aRanked[aRank]);
+      aRanked[aRank] = true;
+    }
+  }
+}
+
+TEST(PatternDB, rankLocality) {
+  // The lookups of the searches of IDA* on the tables of the 7-8 and 5-5-5 partitions: the entries (one byte) of two
+  // consecutive lookups of a table are in the same cache line more often than when the tiles are ranked by value.
+  static constexpr int kNumProblems = 32;
+  static constexpr int kNumMoves = 60;
+  static constexpr PatternPartition::Index_t kEntriesPerCacheLine = 64;
+  static constexpr std::array<Mask_t, 5> kMasks = {
+      0x00000000FFFFFFFF, 0xFFFFFFFF0000000F, 0xFFFFF0000000000F, 0x00000FFFFF00000F, 0x0000000000FFFFFF};
+
+  // The ranking with the tiles in decreasing order of value (the most significant digit is the highest tile).
+  const auto aRankTilesByValue = [](const Mask_t iMask, const std::uint64_t iHash) {
+    PatternPartition::Index_t aRank = 0;
+    int aTaken = 0;
+    int aBase = State::kNumTiles;
+    for (int aTile = State::kNumTilesMinusOne; aTile > 0; --aTile) {
+      if (((iMask >> (aTile << 2)) & 0xF) == 0) continue;
+      const int aPosition = static_cast<int>((iHash >> (aTile << 2)) & 0xF);
+      int aDigit = aPosition;
+      for (int aBefore = 0; aBefore < aPosition; ++aBefore) aDigit -= (aTaken >> aBefore) & 1;
+      aRank = aRank * static_cast<PatternPartition::Index_t>(aBase--) + static_cast<PatternPartition::Index_t>(aDigit);
+      aTaken |= 1 << aPosition;
+    }
+    return aRank;
+  };
+
+  std::array<PatternPartition::Index_t, kMasks.size()> aLastRank = {};
+  std::array<PatternPartition::Index_t, kMasks.size()> aLastRankByValue = {};
+  long long aNumLookups = 0;
+  long long aNumSameLine = 0;
+  long long aNumSameLineByValue = 0;
+  const auto aHeuristic = [&](const State& iState) {
+    for (std::size_t i = 0; i < kMasks.size(); ++i) {
+      const std::uint64_t aHash = iState.getHashWithMask(kMasks[i]);
+      const PatternPartition::Index_t aRank = PatternPartition{kMasks[i]}.rank(aHash);
+      const PatternPartition::Index_t aRankByValue = aRankTilesByValue(kMasks[i], aHash);
+
+      ++aNumLookups;
+      aNumSameLine += aRank / kEntriesPerCacheLine == aLastRank[i] / kEntriesPerCacheLine;
+      aNumSameLineByValue += aRankByValue / kEntriesPerCacheLine == aLastRankByValue[i] / kEntriesPerCacheLine;
+      aLastRank[i] = aRank;
+      aLastRankByValue[i] = aRankByValue;
+    }
+    return DistanceManhattan::computeDistance(iState, State::generateSortedState());
+  };
+
+  std::mt19937 aRandomGenerator(kNumProblems);
+  for (int i = 0; i < kNumProblems; ++i) {
+    State aState = State::generateSortedState();
+    for (int j = 0; j < kNumMoves; ++j) {
+      switch (aRandomGenerator() % 4) {
+        case 0:
+          aState.moveLeft(&aState);
+          break;
+        case 1:
+          aState.moveRight(&aState);
+          break;
+        case 2:
+          aState.moveUp(&aState);
+          break;
+        default:
+          aState.moveDown(&aState);
+          break;
+      }
+    }
+
+    AlgorithmIDA aAlgorithmIDA;
+    ASSERT_TRUE(aAlgorithmIDA.findSolution(aState, aHeuristic)._solutionFound);
+  }
+
+  ASSERT_GT(aNumSameLine, aNumSameLineByValue) << aNumLookups << " lookups";
 }
 
 TEST(PatternDB, generateDB) {
@@ -211,6 +312,31 @@ TEST(PatternDB, generateDB) {
   }
 }
 
+TEST(PatternDB, generateExact) {
+  static constexpr Mask_t kMask = 0x000000000000FF0F;
+  PatternDBTest<kMask> aPatternDB;
+  aPatternDB.generate();
+
+  // Each entry is the cost of a search from its positions.
+  const PatternPartition aPartition{kMask};
+  const auto& aCostTable = aPatternDB.getCostTable(0);
+  aPartition.forEachHash([&](const auto iIndex, const std::uint64_t iHash) {
+    ASSERT_EQ(aCostTable[iIndex], PatternDBTest<kMask>::searchCost(aPartition, iHash));
+  });
+}
+
+TEST(PatternDB, generateConcurrently) {
+  using PatternDB = PatternDB<0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate(1);
+
+  PatternDB aPatternDBConcurrent;
+  aPatternDBConcurrent.generate(8);
+  for (int i = 0; i < PatternDB::kNumPartitions; ++i) {
+    ASSERT_EQ(aPatternDBConcurrent.getCostTable(i), aPatternDB.getCostTable(i));
+  }
+}
+
 TEST(PatternDB, getCost) {
   static constexpr Mask_t kMask = 0xF00000000000000F;
   PatternDBTest<kMask> aPatternDB;
@@ -238,6 +364,397 @@ TEST(PatternDB, getCost) {
   }
 }
 
+TEST(PatternDB, getCostReflected) {
+  static constexpr Mask_t kMask = 0xF00000000000000F;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  ASSERT_FALSE(aPatternDB.isReflectedLookup());
+
+  PatternDB<kMask> aPatternDBReflected = aPatternDB;
+  aPatternDBReflected.setReflectedLookup(true);
+  ASSERT_TRUE(aPatternDBReflected.isReflectedLookup());
+
+  ASSERT_EQ(aPatternDBReflected.getCost(State::generateSortedState()), 0);
+
+  bool aStronger = false;
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    const Cost_t aCost = aPatternDB.getCost(aState);
+    const Cost_t aCostReflected = aPatternDBReflected.getCost(aState);
+
+    ASSERT_EQ(aCostReflected, std::max(aCost, aPatternDB.getCost(aState.getTransposedState())));
+    aStronger |= aCostReflected > aCost;
+  }
+  ASSERT_TRUE(aStronger);
+}
+
+TEST(PatternDB, getCostDual) {
+  static constexpr Mask_t kMask = 0xF00000000000000F;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  ASSERT_FALSE(aPatternDB.isDualLookup());
+
+  PatternDB<kMask> aPatternDBDual = aPatternDB;
+  aPatternDBDual.setDualLookup(true);
+  ASSERT_TRUE(aPatternDBDual.isDualLookup());
+
+  ASSERT_EQ(aPatternDBDual.getCost(State::generateSortedState()), 0);
+  ASSERT_EQ(aPatternDBDual.getCostDual(State::generateSortedState()), 0);
+
+  for (int i = 0; i < 256; ++i) {
+    State aState = State::generateValidRandState(i);
+    if (aState.getIndexSpace() != State::kNumTilesMinusOne) {
+      ASSERT_EQ(aPatternDBDual.getCost(aState), aPatternDB.getCost(aState));
+      ASSERT_EQ(aPatternDB.getCostDual(aState), aPatternDB.getCost(aState));
+    }
+
+    // Space tile in its goal position.
+    while (aState.moveRight(&aState) != -1) {
+    }
+    while (aState.moveDown(&aState) != -1) {
+    }
+
+    const Cost_t aCostDual = aPatternDB.getCost(aState.getDualState());
+    ASSERT_EQ(aPatternDB.getCostDual(aState), aCostDual);
+    ASSERT_EQ(aPatternDBDual.getCost(aState), std::max(aPatternDB.getCost(aState), aCostDual));
+  }
+}
+
+TEST(PatternDB, dualLookupModes) {
+  // The lookups of the modes of Solver::DualLookup: NONE and MAX with `getCost`, REPLACE with `getCostDual`.
+  static constexpr Mask_t kMask = 0x000000000000FFFF;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  PatternDB<kMask> aPatternDBMax = aPatternDB;
+  aPatternDBMax.setDualLookup(true);
+
+  int aNumDualLower = 0;
+  int aNumDualGreater = 0;
+  for (int i = 0; i < 256; ++i) {
+    State aState = State::generateValidRandState(i);
+    while (aState.moveRight(&aState) != -1) {
+    }
+    while (aState.moveDown(&aState) != -1) {
+    }
+
+    // Space tile in its goal position: each mode takes a different lookup.
+    const Cost_t aCostRegular = aPatternDB.getCost(aState);
+    const Cost_t aCostDual = aPatternDB.getCost(aState.getDualState());
+    ASSERT_EQ(aPatternDBMax.getCost(aState), std::max(aCostRegular, aCostDual));
+    ASSERT_EQ(aPatternDB.getCostDual(aState), aCostDual);
+    aNumDualLower += aCostDual < aCostRegular;
+    aNumDualGreater += aCostDual > aCostRegular;
+
+    // Space tile elsewhere: all modes take the regular lookup.
+    aState.moveUp(&aState);
+    ASSERT_EQ(aPatternDBMax.getCost(aState), aPatternDB.getCost(aState));
+    ASSERT_EQ(aPatternDB.getCostDual(aState), aPatternDB.getCost(aState));
+  }
+  ASSERT_GT(aNumDualLower, 0);
+  ASSERT_GT(aNumDualGreater, 0);
+}
+
+TEST(PatternDB, getCostPrefetched) {
+  static constexpr Mask_t kMask = 0x00000000000FFF0F;
+  static constexpr Mask_t kMaskTransposed = 0x00F000F000F0000F;
+  PatternDB<kMask, kMaskTransposed> aPatternDB;
+  aPatternDB.generate();
+
+  std::vector<State> aStates;
+  for (int i = 0; i < 21; ++i) {
+    aStates.push_back(State::generateValidRandState(i));
+  }
+  aStates.push_back(State::generateSortedState());
+
+  const auto aCheckCosts = [&aStates](const auto& iPatternDB) {
+    using Index_t = typename std::decay_t<decltype(iPatternDB)>::Index_t;
+    std::vector<Index_t> aIndices(aStates.size() * iPatternDB.getNumPrefetchIndices());
+    for (std::size_t k = 0; k < aStates.size(); ++k) {
+      iPatternDB.prefetch(aStates[k], aIndices.data() + k * iPatternDB.getNumPrefetchIndices());
+    }
+    for (std::size_t k = 0; k < aStates.size(); ++k) {
+      ASSERT_EQ(iPatternDB.getCostPrefetched(aStates[k], aIndices.data() + k * iPatternDB.getNumPrefetchIndices()),
+                iPatternDB.getCost(aStates[k]));
+    }
+  };
+
+  aCheckCosts(aPatternDB);
+  aPatternDB.setReflectedLookup(true);
+  ASSERT_EQ(aPatternDB.getNumPrefetchIndices(), 4);
+  aCheckCosts(aPatternDB);
+  aPatternDB.setDualLookup(true);
+  aCheckCosts(aPatternDB);
+  aPatternDB.setPackedStorage(true);
+  aCheckCosts(aPatternDB);
+  aPatternDB.setCompressionFactor(2);
+  aCheckCosts(aPatternDB);
+
+  PatternDB<kMask, kMaskTransposed> aPatternDBLazy;
+  aPatternDBLazy.setLazyGeneration(true);
+  aPatternDBLazy.setReflectedLookup(true);
+  aCheckCosts(aPatternDBLazy);
+}
+
+TEST(PatternDB, getCostPacked) {
+  // Not valid partitions: the distance of the pattern is computed apart.
+  static constexpr Mask_t kMask = 0x000000000000FFFF;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  ASSERT_FALSE(aPatternDB.isPackedStorage());
+
+  PatternDB<kMask> aPatternDBPacked;
+  aPatternDBPacked.setPackedStorage(true);
+  aPatternDBPacked.generate();
+  ASSERT_TRUE(aPatternDBPacked.isPackedStorage());
+  ASSERT_TRUE(aPatternDBPacked.getCostTable(0).empty());
+  ASSERT_EQ(aPatternDBPacked.getPackedCostTable(0).size(), aPatternDB.getCostTable(0).size() / 2);
+
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aPatternDBPacked.getCost(aState), aPatternDB.getCost(aState));
+  }
+}
+
+TEST(PatternDB, getCostPackedValidPartitions) {
+  // Valid partitions: the distance of the patterns is the Manhattan distance.
+  using PatternDB =
+      PatternDB<0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F, 0x000FFF000000000F, 0xFFF000000000000F>;
+  static_assert(PatternDB::isValidPartitions());
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+
+  PatternDB aPatternDBPacked = aPatternDB;
+  aPatternDBPacked.setPackedStorage(true);
+  aPatternDBPacked.setReflectedLookup(true);
+  aPatternDB.setReflectedLookup(true);
+
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aPatternDBPacked.getCost(aState), aPatternDB.getCost(aState));
+  }
+
+  // Back to the not packed storage.
+  aPatternDBPacked.setPackedStorage(false);
+  ASSERT_TRUE(aPatternDBPacked.getPackedCostTable(0).empty());
+  for (int i = 0; i < PatternDB::kNumPartitions; ++i) {
+    ASSERT_EQ(aPatternDBPacked.getCostTable(i), aPatternDB.getCostTable(i));
+  }
+}
+
+TEST(PatternDB, serializeAndDeserializePacked) {
+  static constexpr Mask_t kMask = 0x000000000000FFFF;
+
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  PatternDB<kMask> aPatternDBPacked = aPatternDB;
+  aPatternDBPacked.setPackedStorage(true);
+
+  std::stringstream aSs;
+  std::stringstream aSsPacked;
+  aPatternDB.serialize(&aSs);
+  aPatternDBPacked.serialize(&aSsPacked);
+  ASSERT_EQ(aSs.str(), aSsPacked.str());
+
+  PatternDB<kMask> aPatternDBLoad;
+  aPatternDBLoad.setPackedStorage(true);
+  aSs.seekg(std::ios_base::beg);
+  aPatternDBLoad.deserialize(&aSs);
+
+  ASSERT_EQ(aPatternDBLoad.getPackedCostTable(0), aPatternDBPacked.getPackedCostTable(0));
+}
+
+TEST(PatternDB, getCostCompressed) {
+  using PatternDB =
+      PatternDB<0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F, 0x000FFF000000000F, 0xFFF000000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+  ASSERT_EQ(aPatternDB.getCompressionFactor(), 1);
+
+  for (const bool aPackedStorage : {false, true}) {
+    PatternDB aPatternDBUncompressed = aPatternDB;
+    aPatternDBUncompressed.setPackedStorage(aPackedStorage);
+
+    PatternDB aPatternDBCompressed = aPatternDBUncompressed;
+    aPatternDBCompressed.setCompressionFactor(4);
+    ASSERT_EQ(aPatternDBCompressed.getCompressionFactor(), 4);
+    ASSERT_EQ(aPatternDBCompressed.getMemoryUsage(), aPatternDBUncompressed.getMemoryUsage() / 4);
+    ASSERT_LT(aPatternDBCompressed.computeAverageCost(), aPatternDBUncompressed.computeAverageCost());
+
+    // Folding in two steps is the same as folding at once.
+    PatternDB aPatternDBTwoSteps = aPatternDBUncompressed;
+    aPatternDBTwoSteps.setCompressionFactor(2);
+    aPatternDBTwoSteps.setCompressionFactor(4);
+
+    ASSERT_EQ(aPatternDBCompressed.getCost(State::generateSortedState()), 0);
+    for (int i = 0; i < 256; ++i) {
+      const State aState = State::generateValidRandState(i);
+      const Cost_t aCost = aPatternDBCompressed.getCost(aState);
+      ASSERT_LE(aCost, aPatternDBUncompressed.getCost(aState));
+      ASSERT_EQ(aPatternDBTwoSteps.getCost(aState), aCost);
+    }
+  }
+}
+
+TEST(PatternDB, averageCost) {
+  using PatternDB =
+      PatternDB<0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F, 0x000FFF000000000F, 0xFFF000000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+  PatternDB aPatternDBPacked = aPatternDB;
+  aPatternDBPacked.setPackedStorage(true);
+
+  ASSERT_NEAR(aPatternDBPacked.computeAverageCost(), aPatternDB.computeAverageCost(), 1e-9);
+  // Stronger than the average Manhattan distance (37 for 15 tiles).
+  ASSERT_GT(aPatternDB.computeAverageCost(), 37.0);
+}
+
+TEST(PatternDB, compressionInvalid) {
+  static constexpr Mask_t kMask = 0x000000000000FFFF;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+
+  ASSERT_THROW(aPatternDB.setCompressionFactor(0), std::runtime_error);
+  ASSERT_THROW(aPatternDB.setCompressionFactor(3), std::runtime_error);
+
+  aPatternDB.setCompressionFactor(4);
+  ASSERT_THROW(aPatternDB.setCompressionFactor(2), std::runtime_error);
+  ASSERT_THROW(aPatternDB.setPackedStorage(true), std::runtime_error);
+
+  std::stringstream aSs;
+  ASSERT_THROW(aPatternDB.serialize(&aSs), std::runtime_error);
+}
+
+TEST(PatternDB, getCostLazy) {
+  using PatternDB =
+      PatternDB<0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F, 0x000FFF000000000F, 0xFFF000000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+
+  PatternDB aPatternDBLazy = aPatternDB;
+  aPatternDBLazy.setLazyGeneration(true);
+  ASSERT_TRUE(aPatternDBLazy.isLazyGeneration());
+  ASSERT_TRUE(aPatternDBLazy.getCostTable(0).empty());
+  ASSERT_EQ(aPatternDBLazy.getNumLazyEntries(), 0);
+
+  ASSERT_EQ(aPatternDBLazy.getCost(State::generateSortedState()), 0);
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    const Cost_t aCost = aPatternDBLazy.getCost(aState);
+    ASSERT_GE(aCost, DistanceManhattan::computeDistanceWithFinal(aState));
+    // Both the lazy and the generated entries are exact.
+    ASSERT_EQ(aCost, aPatternDB.getCost(aState));
+  }
+  ASSERT_GT(aPatternDBLazy.getNumLazyEntries(), 0);
+  ASSERT_LE(aPatternDBLazy.getNumLazyEntries(), 256 * PatternDB::kNumPartitions);
+
+  // The tables replace the lazy entries.
+  aPatternDBLazy.generate();
+  ASSERT_FALSE(aPatternDBLazy.isLazyGeneration());
+  ASSERT_EQ(aPatternDBLazy.getCostTable(0), aPatternDB.getCostTable(0));
+}
+
+TEST(PatternDB, getCostLazyConcurrently) {
+  static constexpr Mask_t kMask = 0x00000000000FFFFF;
+  static constexpr int kNumThreads = 4;
+  static constexpr int kNumStates = 64;
+
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.setLazyGeneration(true);
+
+  std::vector<Cost_t> aExpectedCosts;
+  {
+    PatternDB<kMask> aPatternDBSequential;
+    aPatternDBSequential.setLazyGeneration(true);
+    for (int i = 0; i < kNumStates; ++i) {
+      aExpectedCosts.push_back(aPatternDBSequential.getCost(State::generateValidRandState(i)));
+    }
+  }
+
+  std::vector<std::vector<Cost_t>> aCosts(kNumThreads);
+  std::vector<std::thread> aThreads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    aThreads.emplace_back([&aPatternDB, &aCosts, t]() {
+      for (int i = 0; i < kNumStates; ++i) {
+        aCosts[t].push_back(aPatternDB.getCost(State::generateValidRandState(i)));
+      }
+    });
+  }
+  for (std::thread& aThread : aThreads) {
+    aThread.join();
+  }
+
+  for (int t = 0; t < kNumThreads; ++t) {
+    ASSERT_EQ(aCosts[t], aExpectedCosts);
+  }
+}
+
+TEST(PatternDB, lazyInvalid) {
+  static constexpr Mask_t kMask = 0x000000000000FFFF;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.setLazyGeneration(true);
+
+  ASSERT_THROW(aPatternDB.setPackedStorage(true), std::runtime_error);
+  ASSERT_THROW(aPatternDB.setCompressionFactor(2), std::runtime_error);
+
+  std::stringstream aSs;
+  ASSERT_THROW(aPatternDB.serialize(&aSs), std::runtime_error);
+
+  PatternDB<kMask> aPatternDBPacked;
+  aPatternDBPacked.setPackedStorage(true);
+  ASSERT_THROW(aPatternDBPacked.setLazyGeneration(true), std::runtime_error);
+}
+
+TEST(PatternDB, symmetricFolding) {
+  // Tiles {2, 3, 4} and their transposition {5, 9, 13}.
+  static constexpr Mask_t kMask = 0x00000000000FFF0F;
+  static constexpr Mask_t kMaskTransposed = 0x00F000F000F0000F;
+  PatternDB<kMask> aPatternDB;
+  aPatternDB.generate();
+  PatternDB<kMask, kMaskTransposed> aPatternDBFolded;
+  aPatternDBFolded.generate();
+
+  ASSERT_EQ(aPatternDBFolded.getSourcePartition(0), 0);
+  ASSERT_EQ(aPatternDBFolded.getSourcePartition(1), 0);
+  ASSERT_TRUE(aPatternDBFolded.getCostTable(1).empty());
+  ASSERT_EQ(aPatternDBFolded.getMemoryUsage(), aPatternDB.getMemoryUsage());
+
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aPatternDBFolded.getCost(aState),
+              aPatternDB.getCost(aState) + aPatternDB.getCost(aState.getTransposedState()));
+  }
+
+  // The folded table is written in full: the file format does not change.
+  std::stringstream aSs;
+  aPatternDBFolded.serialize(&aSs);
+  std::stringstream aSsSingle;
+  aPatternDB.serialize(&aSsSingle);
+  ASSERT_EQ(aSsSingle.str().size(), PatternDBFile({kMask}).getFileSize());
+  ASSERT_EQ(aSs.str().size(), PatternDBFile({kMask, kMaskTransposed}).getFileSize());
+
+  PatternDB<kMask, kMaskTransposed> aPatternDBLoad;
+  aSs.seekg(std::ios_base::beg);
+  aPatternDBLoad.deserialize(&aSs);
+  ASSERT_TRUE(aPatternDBLoad.getCostTable(1).empty());
+  for (int i = 0; i < 256; ++i) {
+    const State aState = State::generateValidRandState(i);
+    ASSERT_EQ(aPatternDBLoad.getCost(aState), aPatternDBFolded.getCost(aState));
+  }
+}
+
+TEST(PatternDB, symmetricFoldingPartitions) {
+  // Upper triangle, lower triangle and diagonal.
+  PatternDB<0x000F000FF00FFF0F, 0xFFF00FF000F0000F, 0x0000F0000F0000FF>
+      aPatternDB;
+  ASSERT_EQ(aPatternDB.getSourcePartition(0), 0);
+  ASSERT_EQ(aPatternDB.getSourcePartition(1), 0);
+  ASSERT_EQ(aPatternDB.getSourcePartition(2), 2);
+
+  PatternDB<0xF00000000000000F, 0x0FFFFFFFFFFFFFFF> aPatternDBNotSymmetric;
+  ASSERT_EQ(aPatternDBNotSymmetric.getSourcePartition(0), 0);
+  ASSERT_EQ(aPatternDBNotSymmetric.getSourcePartition(1), 1);
+}
+
 TEST(PatternDB, serializeAndDeserialize) {
   static constexpr Mask_t kMask = 0xF00000000000000F;
 
@@ -255,6 +772,46 @@ TEST(PatternDB, serializeAndDeserialize) {
             aPatternDBLoad.getCostTable(0).size());
 }
 
+TEST(PatternDB, serializeNotSeekable) {
+  using PatternDB = PatternDB<0x000000000000FF0F, 0xF00000000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+
+  // A stream which cannot be sought: the checksums are computed before the tables are written.
+  class StringBuffer : public std::streambuf {
+   public:
+    std::string _content;
+
+   protected:
+    int_type overflow(const int_type iChar) override {
+      if (!traits_type::eq_int_type(iChar, traits_type::eof())) _content.push_back(traits_type::to_char_type(iChar));
+      return iChar;
+    }
+    std::streamsize xsputn(const char* iData, const std::streamsize iSize) override {
+      _content.append(iData, static_cast<std::size_t>(iSize));
+      return iSize;
+    }
+  };
+  StringBuffer aBuffer;
+  std::ostream aStream(&aBuffer);
+  ASSERT_EQ(aStream.tellp(), std::ostream::pos_type(-1));
+  aPatternDB.serialize(&aStream);
+
+  // On a seekable stream the header is written again after the tables, where the database starts.
+  std::stringstream aSs;
+  aSs << "prefix";
+  aPatternDB.serialize(&aSs);
+  aSs << "suffix";
+  ASSERT_EQ(aSs.str(), "prefix" + aBuffer._content + "suffix");
+
+  std::istringstream aSsLoad(aBuffer._content);
+  PatternDB aPatternDBLoad;
+  aPatternDBLoad.deserialize(&aSsLoad);
+  for (int i = 0; i < PatternDB::kNumPartitions; ++i) {
+    ASSERT_EQ(aPatternDBLoad.getCostTable(i), aPatternDB.getCostTable(i));
+  }
+}
+
 TEST(PatternDB, serializeAndDeserializeIncompatible) {
   using PatternDBOriginal = PatternDB<0xF00000000000000F>;
   using PatternDBTwoPartitions =
@@ -302,4 +859,151 @@ TEST(PatternDB, incompleteStream) {
   aSs.clear();
 }
 
+TEST(PatternDB, mapFile) {
+  static constexpr const char* kFileName = "testPatternDBMapped.data";
+  // The second partition is folded by symmetry.
+  using PatternDB = PatternDB<0x00000000000FFF0F, 0x00F000F000F0000F, 0x000000FFF000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+  {
+    std::ofstream aFile(kFileName, std::ios_base::binary);
+    aPatternDB.serialize(&aFile);
+  }
+
+  PatternDB aPatternDBMapped;
+  ASSERT_FALSE(aPatternDBMapped.isMapped());
+  aPatternDBMapped.mapFile(kFileName);
+  ASSERT_TRUE(aPatternDBMapped.isMapped());
+  ASSERT_TRUE(aPatternDBMapped.getCostTable(0).empty());
+  ASSERT_EQ(aPatternDBMapped.getMemoryUsage(), aPatternDB.getMemoryUsage());
+  ASSERT_EQ(aPatternDBMapped.computeAverageCost(), aPatternDB.computeAverageCost());
+
+  std::vector<State> aStates;
+  for (int i = 0; i < 256; ++i) {
+    aStates.push_back(State::generateValidRandState(i));
+  }
+  for (std::size_t i = 0; i < aStates.size(); ++i) {
+    ASSERT_EQ(aPatternDBMapped.getCost(aStates[i]), aPatternDB.getCost(aStates[i]));
+  }
+
+  // The mapped tables are serialized as they are.
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+  std::stringstream aSsMapped;
+  aPatternDBMapped.serialize(&aSsMapped);
+  ASSERT_EQ(aSsMapped.str(), aSs.str());
+
+  // The tables are copied when the storage is changed.
+  aPatternDBMapped.setPackedStorage(true);
+  ASSERT_FALSE(aPatternDBMapped.isMapped());
+  for (const State& aState : aStates) {
+    ASSERT_LE(aPatternDBMapped.getCost(aState), aPatternDB.getCost(aState));
+  }
+  ASSERT_THROW(aPatternDBMapped.mapFile(kFileName), std::runtime_error);
+
+  std::remove(kFileName);
+}
+
+TEST(PatternDB, mapFileInvalid) {
+  static constexpr const char* kFileName = "testPatternDBMappedInvalid.data";
+  std::remove(kFileName);
+  ASSERT_THROW(PatternDB<0xF00000000000000F>{}.mapFile(kFileName), std::runtime_error);
+
+  PatternDB<0xF00000000000000F> aPatternDB;
+  aPatternDB.generate();
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+  const std::string aContent = aSs.str();
+
+  // A truncated file.
+  {
+    std::ofstream aFile(kFileName, std::ios_base::binary);
+    aFile.write(aContent.data(), static_cast<std::streamsize>(aContent.size() - 1));
+  }
+  ASSERT_THROW(PatternDB<0xF00000000000000F>{}.mapFile(kFileName), std::runtime_error);
+  ASSERT_THROW((PatternDB<0xFF0000000000000F>{}.mapFile(kFileName)), std::runtime_error);
+
+  std::remove(kFileName);
+}
+
+TEST(PatternDB, deserializeLegacyFile) {
+  static constexpr const char* kFileName = "testPatternDBLegacy.data";
+  using PatternDB = PatternDB<0x000000000000FF0F, 0xF00000000000000F, 0x0FFF00000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+
+  // The files of the original format, sparse or dense, are neither read nor mapped (even with exact tables).
+  for (const bool aDenseTables : {false, true}) {
+    const std::string aContent = serializeLegacyPatternDB(aPatternDB, aDenseTables);
+    std::istringstream aSs(aContent);
+    ASSERT_THROW(PatternDB{}.deserialize(&aSs), std::runtime_error);
+
+    {
+      std::ofstream aFile(kFileName, std::ios_base::binary);
+      aFile << aContent;
+    }
+    ASSERT_THROW(PatternDB{}.mapFile(kFileName), std::runtime_error);
+
+    // Only the partitions are read.
+    aSs.seekg(0);
+    ASSERT_EQ(PatternDB::deserializeMaskPartitions(&aSs),
+              std::vector<PatternPartition::Mask_t>(PatternDB::getMaskPartitions().begin(), PatternDB::getMaskPartitions().end()));
+  }
+
+  std::remove(kFileName);
+}
+
+TEST(PatternDB, deserializeRankedByValueFile) {
+  using PatternDB = PatternDB<0x000000000000FF0F, 0xF00000000000000F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+
+  // The same file with the version 2 (its header checksum computed again): the entries are in another order.
+  std::string aContent = aSs.str();
+  const std::vector<PatternPartition::Mask_t> aMaskPartitions(PatternDB::getMaskPartitions().begin(),
+                                                              PatternDB::getMaskPartitions().end());
+  const std::size_t aChecksumOffset = PatternDBFile(aMaskPartitions).getHeaderSize() - 8;
+  aContent[8] = static_cast<char>(PatternDBFile::kRankedByValueVersion);
+  const std::uint32_t aChecksum = Crc32c::compute(aContent.data(), aChecksumOffset);
+  aContent.replace(aChecksumOffset, sizeof(aChecksum), reinterpret_cast<const char*>(&aChecksum), sizeof(aChecksum));
+
+  std::istringstream aSsPrevious(aContent);
+  ASSERT_EQ(PatternDBFile::readHeader(&aSsPrevious).getVersion(), PatternDBFile::kRankedByValueVersion);
+  aSsPrevious.seekg(0);
+  ASSERT_THROW(PatternDB{}.deserialize(&aSsPrevious), std::runtime_error);
+
+  // Only the partitions are read.
+  aSsPrevious.seekg(0);
+  ASSERT_EQ(PatternDB::deserializeMaskPartitions(&aSsPrevious), aMaskPartitions);
+}
+
+TEST(PatternDB, corruptedFile) {
+  static constexpr const char* kFileName = "testPatternDBCorrupted.data";
+  using PatternDB = PatternDB<0x000000000000FF0F>;
+  PatternDB aPatternDB;
+  aPatternDB.generate();
+  std::stringstream aSs;
+  aPatternDB.serialize(&aSs);
+
+  // An entry of the table is changed.
+  std::string aContent = aSs.str();
+  const PatternDBFile::Section_t aSection = PatternDBFile({PatternDB::getPartition(0).getMask()}).getSections()[0];
+  aContent[aSection._offset + aSection._size / 2] ^= 0x1;
+  {
+    std::ofstream aFile(kFileName, std::ios_base::binary);
+    aFile << aContent;
+  }
+
+  std::istringstream aSsCorrupted(aContent);
+  ASSERT_THROW(PatternDB{}.deserialize(&aSsCorrupted), std::runtime_error);
+
+  // The checksums of a mapped file are verified only on demand.
+  ASSERT_NO_THROW(PatternDB{}.mapFile(kFileName));
+  ASSERT_THROW(PatternDB{}.mapFile(kFileName, true), std::runtime_error);
+
+  std::remove(kFileName);
+}
+
 }  // namespace kpuzzle4::testing
@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <PatternDBFile.hpp>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kpuzzle4::testing {
+
+using Mask_t = PatternDBFile::Mask_t;
+
+TEST(PatternDBFile, layout) {
+  static constexpr Mask_t kMaskA = 0xF00000000000000F;
+  static constexpr Mask_t kMaskB = 0x000000000000FF0F;
+  const PatternDBFile aFile({kMaskA, kMaskB});
+
+  ASSERT_EQ(aFile.getVersion(), PatternDBFile::kVersion);
+  ASSERT_EQ(aFile.getMaskPartitions(), std::vector<Mask_t>({kMaskA, kMaskB}));
+  ASSERT_EQ(aFile.getSections().size(), 2);
+
+  // Each table is in its own section, aligned to a page.
+  const auto& aSections = aFile.getSections();
+  ASSERT_EQ(aSections[0]._size, 16);
+  ASSERT_EQ(aSections[1]._size, 16 * 15);
+  ASSERT_GE(aSections[0]._offset, aFile.getHeaderSize());
+  ASSERT_EQ(aSections[0]._offset % PatternDBFile::kAlignment, 0);
+  ASSERT_GE(aSections[1]._offset, aSections[0]._offset + aSections[0]._size);
+  ASSERT_EQ(aSections[1]._offset % PatternDBFile::kAlignment, 0);
+  ASSERT_EQ(aFile.getFileSize(), aSections[1]._offset + aSections[1]._size);
+  ASSERT_LE(aFile.getHeaderSize(), PatternDBFile::getMaxHeaderSize());
+}
+
+TEST(PatternDBFile, writeAndReadHeader) {
+  PatternDBFile aFile({0xF00000000000000F, 0x000000000000FF0F});
+  aFile.setChecksum(0, 0x12345678);
+  aFile.setChecksum(1, 0x9ABCDEF0);
+
+  const std::string aHeader = aFile.serializeHeader();
+  ASSERT_EQ(aHeader.size(), aFile.getSections()[0]._offset);
+
+  std::istringstream aSs(aHeader);
+  const PatternDBFile aFileRead = PatternDBFile::readHeader(&aSs);
+  ASSERT_EQ(aSs.tellg(), static_cast<std::streamoff>(aFile.getHeaderSize()));
+  ASSERT_EQ(aFileRead.getVersion(), PatternDBFile::kVersion);
+  ASSERT_EQ(aFileRead.getMaskPartitions(), aFile.getMaskPartitions());
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(aFileRead.getSections()[i]._offset, aFile.getSections()[i]._offset);
+    ASSERT_EQ(aFileRead.getSections()[i]._size, aFile.getSections()[i]._size);
+    ASSERT_EQ(aFileRead.getSections()[i]._checksum, aFile.getSections()[i]._checksum);
+  }
+}
+
+TEST(PatternDBFile, readInvalidHeader) {
+  const std::string aHeader = PatternDBFile({0xF00000000000000F}).serializeHeader();
+  const auto aRead = [](const std::string& iBytes) {
+    std::istringstream aSs(iBytes);
+    return PatternDBFile::readHeader(&aSs);
+  };
+  ASSERT_NO_THROW(aRead(aHeader));
+
+  // Truncated.
+  ASSERT_THROW(aRead(aHeader.substr(0, 20)), std::runtime_error);
+
+  // Any changed byte of the header is detected by its checksum.
+  std::string aCorrupted = aHeader;
+  aCorrupted[40] ^= 0x1;
+  ASSERT_THROW(aRead(aCorrupted), std::runtime_error);
+
+  // Another version.
+  std::string aOtherVersion = aHeader;
+  aOtherVersion[8] = PatternDBFile::kVersion + 1;
+  ASSERT_THROW(aRead(aOtherVersion), std::runtime_error);
+
+  // Another byte order.
+  std::string aOtherByteOrder = aHeader;
+  std::swap(aOtherByteOrder[12], aOtherByteOrder[15]);
+  std::swap(aOtherByteOrder[13], aOtherByteOrder[14]);
+  ASSERT_THROW(aRead(aOtherByteOrder), std::runtime_error);
+}
+
+TEST(PatternDBFile, readLegacyHeader) {
+  static constexpr std::int32_t kNumPartitions = 2;
+  static constexpr std::uint64_t kMasks[kNumPartitions] = {0xF00000000000000F, 0x000000000000FF0F};
+  std::string aHeader(reinterpret_cast<const char*>(&kNumPartitions), sizeof(kNumPartitions));
+  aHeader.append(reinterpret_cast<const char*>(kMasks), sizeof(kMasks));
+
+  std::istringstream aSs(aHeader);
+  const PatternDBFile aFile = PatternDBFile::readHeader(&aSs);
+  ASSERT_EQ(aFile.getVersion(), PatternDBFile::kLegacyVersion);
+  ASSERT_EQ(aFile.getHeaderSize(), aHeader.size());
+  ASSERT_EQ(aFile.getMaskPartitions(), std::vector<Mask_t>({kMasks[0], kMasks[1]}));
+}
+
+}  // namespace kpuzzle4::testing
@@ -0,0 +1,274 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <SolutionCache.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace kpuzzle4::testing {
+
+namespace {
+
+//! \brief The offsets of the fields in the cache file (of the first entry).
+struct CacheLayout : SolutionCache {
+  static constexpr std::size_t kOffsetClock = offsetof(Header_t, _clock);
+  static constexpr std::size_t kOffsetLength = sizeof(Header_t) + offsetof(Entry_t, _length);
+  static constexpr std::size_t kOffsetPath = sizeof(Header_t) + offsetof(Entry_t, _path);
+};
+
+}  // anonymous namespace
+
+class SolutionCacheTest : public ::testing::Test {
+ protected:
+  static constexpr const char* kFileName = "testSolutionCache.data";
+
+  void SetUp() override { std::remove(kFileName); }
+  void TearDown() override { std::remove(kFileName); }
+
+  //! \brief It builds a state (and its solution) moving the space tile.
+  static State buildState(const char* iMoves, SearchNode::Path_t* oPath, int* oLength) {
+    State aState = State::generateSortedState();
+    *oLength = 0;
+    for (const char* aMove = iMoves; *aMove != '\0'; ++aMove) {
+      switch (*aMove) {
+        case 'L':
+          aState.moveLeft(&aState);
+          break;
+        case 'R':
+          aState.moveRight(&aState);
+          break;
+        case 'U':
+          aState.moveUp(&aState);
+          break;
+        case 'D':
+          aState.moveDown(&aState);
+          break;
+      }
+      ++(*oLength);
+    }
+
+    // The solution is the reversed sequence of the opposite moves.
+    for (int i = 0; i < *oLength; ++i) {
+      const char aMove = iMoves[*oLength - i - 1];
+      (*oPath)[i] = aMove == 'L' ? 'R' : aMove == 'R' ? 'L' : aMove == 'U' ? 'D' : 'U';
+    }
+
+    return aState;
+  }
+
+  //! \brief It checks whether the path brings the state to the sorted one.
+  static bool isSolution(State iState, const SearchNode::Path_t& iPath, const int iLength) {
+    for (int i = 0; i < iLength; ++i) {
+      switch (iPath[i]) {
+        case 'L':
+          iState.moveLeft(&iState);
+          break;
+        case 'R':
+          iState.moveRight(&iState);
+          break;
+        case 'U':
+          iState.moveUp(&iState);
+          break;
+        case 'D':
+          iState.moveDown(&iState);
+          break;
+      }
+    }
+    return iState == State::generateSortedState();
+  }
+};
+
+TEST_F(SolutionCacheTest, transposeMove) {
+  ASSERT_EQ(SolutionCache::transposeMove('L'), 'U');
+  ASSERT_EQ(SolutionCache::transposeMove('U'), 'L');
+  ASSERT_EQ(SolutionCache::transposeMove('R'), 'D');
+  ASSERT_EQ(SolutionCache::transposeMove('D'), 'R');
+}
+
+TEST_F(SolutionCacheTest, miss) {
+  SolutionCache aCache{kFileName, 4};
+
+  SearchNode::Path_t aPath;
+  int aLength;
+  ASSERT_FALSE(aCache.find(State::generateSortedState(), &aPath, &aLength));
+  ASSERT_EQ(aCache.getSize(), 0);
+  ASSERT_EQ(aCache.getCapacity(), 4);
+}
+
+TEST_F(SolutionCacheTest, insertAndFind) {
+  SolutionCache aCache{kFileName, 4};
+
+  SearchNode::Path_t aPath;
+  int aLength;
+  const State aState = buildState("LLUR", &aPath, &aLength);
+  aCache.insert(aState, aPath, aLength);
+
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_TRUE(aCache.find(aState, &aPathFound, &aLengthFound));
+  ASSERT_EQ(aLengthFound, aLength);
+  ASSERT_TRUE(isSolution(aState, aPathFound, aLengthFound));
+}
+
+TEST_F(SolutionCacheTest, findTransposed) {
+  SolutionCache aCache{kFileName, 4};
+
+  SearchNode::Path_t aPath;
+  int aLength;
+  const State aState = buildState("LLUUR", &aPath, &aLength);
+  aCache.insert(aState, aPath, aLength);
+
+  const State aTransposedState = aState.getTransposedState();
+  ASSERT_NE(aTransposedState, aState);
+
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_TRUE(aCache.find(aTransposedState, &aPathFound, &aLengthFound));
+  ASSERT_EQ(aLengthFound, aLength);
+  ASSERT_TRUE(isSolution(aTransposedState, aPathFound, aLengthFound));
+  ASSERT_EQ(aCache.getSize(), 1);
+}
+
+TEST_F(SolutionCacheTest, persistence) {
+  SearchNode::Path_t aPath;
+  int aLength;
+  const State aState = buildState("UULDR", &aPath, &aLength);
+
+  {
+    SolutionCache aCache{kFileName, 4};
+    aCache.insert(aState, aPath, aLength);
+  }
+
+  SolutionCache aCache{kFileName};
+  ASSERT_EQ(aCache.getCapacity(), 4);
+  ASSERT_EQ(aCache.getSize(), 1);
+
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_TRUE(aCache.find(aState, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(isSolution(aState, aPathFound, aLengthFound));
+}
+
+TEST_F(SolutionCacheTest, evictLeastRecentlyUsed) {
+  SolutionCache aCache{kFileName, 2};
+
+  SearchNode::Path_t aPathA, aPathB, aPathC;
+  int aLengthA, aLengthB, aLengthC;
+  const State aStateA = buildState("L", &aPathA, &aLengthA);
+  const State aStateB = buildState("LL", &aPathB, &aLengthB);
+  const State aStateC = buildState("LLL", &aPathC, &aLengthC);
+
+  aCache.insert(aStateA, aPathA, aLengthA);
+  aCache.insert(aStateB, aPathB, aLengthB);
+
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_TRUE(aCache.find(aStateA, &aPathFound, &aLengthFound));
+
+  aCache.insert(aStateC, aPathC, aLengthC);
+  ASSERT_EQ(aCache.getSize(), 2);
+  ASSERT_TRUE(aCache.find(aStateA, &aPathFound, &aLengthFound));
+  ASSERT_FALSE(aCache.find(aStateB, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(aCache.find(aStateC, &aPathFound, &aLengthFound));
+}
+
+TEST_F(SolutionCacheTest, invalidFile) {
+  {
+    std::ofstream aFile(kFileName, std::ios_base::binary);
+    aFile << "This is not a cache file";
+  }
+
+  ASSERT_THROW(SolutionCache{kFileName}, std::exception);
+}
+
+TEST_F(SolutionCacheTest, fileNotExtended) {
+  // A file shorter than the header is not taken as a new cache.
+  std::ofstream(kFileName, std::ios_base::binary) << "short";
+  ASSERT_THROW(SolutionCache{kFileName}, std::runtime_error);
+  std::ifstream aFile(kFileName, std::ios_base::binary | std::ios_base::ate);
+  ASSERT_EQ(aFile.tellg(), 5);
+}
+
+TEST_F(SolutionCacheTest, sharedFile) {
+  SearchNode::Path_t aPathA, aPathB, aPathC;
+  int aLengthA, aLengthB, aLengthC;
+  const State aStateA = buildState("L", &aPathA, &aLengthA);
+  const State aStateB = buildState("LL", &aPathB, &aLengthB);
+  const State aStateC = buildState("LLL", &aPathC, &aLengthC);
+
+  // Two caches (e.g., two processes) on the same file see the entries of each other.
+  SolutionCache aCacheFirst{kFileName, 2};
+  SolutionCache aCacheSecond{kFileName};
+  aCacheFirst.insert(aStateA, aPathA, aLengthA);
+  aCacheSecond.insert(aStateB, aPathB, aLengthB);
+
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_TRUE(aCacheSecond.find(aStateA, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(isSolution(aStateA, aPathFound, aLengthFound));
+  ASSERT_TRUE(aCacheFirst.find(aStateB, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(isSolution(aStateB, aPathFound, aLengthFound));
+
+  // The least recently used entry (A, found by the second cache before B) is evicted.
+  aCacheFirst.insert(aStateC, aPathC, aLengthC);
+  ASSERT_FALSE(aCacheSecond.find(aStateA, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(aCacheSecond.find(aStateB, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(aCacheSecond.find(aStateC, &aPathFound, &aLengthFound));
+  ASSERT_TRUE(isSolution(aStateC, aPathFound, aLengthFound));
+  ASSERT_EQ(aCacheSecond.getSize(), 2);
+}
+
+TEST_F(SolutionCacheTest, corruptedEntry) {
+  SearchNode::Path_t aPath;
+  int aLength;
+  const State aState = buildState("LLUR", &aPath, &aLength);
+  const auto aCorrupt = [&](const std::size_t iOffset, const char iByte) {
+    std::remove(kFileName);
+    SolutionCache{kFileName, 4}.insert(aState, aPath, aLength);
+    std::fstream aFile(kFileName, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+    aFile.seekp(static_cast<std::streamoff>(iOffset));
+    aFile.put(iByte);
+  };
+
+  // A path longer than the max one.
+  aCorrupt(CacheLayout::kOffsetLength, static_cast<char>(SearchNode::kMaxPath + 1));
+  ASSERT_THROW(SolutionCache{kFileName}, std::runtime_error);
+
+  // A path with a move which is not valid.
+  aCorrupt(CacheLayout::kOffsetPath + 2, 'X');
+  ASSERT_THROW(SolutionCache{kFileName}, std::runtime_error);
+
+  // An entry corrupted by another process (which advances the clock) after the cache is open.
+  std::remove(kFileName);
+  SolutionCache aCache{kFileName, 4};
+  aCache.insert(aState, aPath, aLength);
+  {
+    std::fstream aFile(kFileName, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+    aFile.seekp(static_cast<std::streamoff>(CacheLayout::kOffsetLength));
+    aFile.put(static_cast<char>(0xFF));
+    aFile.seekp(static_cast<std::streamoff>(CacheLayout::kOffsetClock));
+    aFile.put(static_cast<char>(0x7F));
+  }
+  SearchNode::Path_t aPathFound;
+  int aLengthFound;
+  ASSERT_THROW(aCache.find(aState, &aPathFound, &aLengthFound), std::runtime_error);
+}
+
+}  // namespace kpuzzle4::testing
@@ -0,0 +1,406 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <DynamicPatternDB.hpp>
+#include <Solver.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "testHelpers.hpp"
+
+namespace kpuzzle4::testing {
+
+namespace {
+
+//! \brief It applies the moves of a solution to a state.
+State applySolution(State iState, const Solver::Solution_t& iSolution) {
+  for (int i = 0; i < iSolution._length; ++i) {
+    switch (iSolution._path[i]) {
+      case 'L':
+        iState.moveLeft(&iState);
+        break;
+      case 'R':
+        iState.moveRight(&iState);
+        break;
+      case 'U':
+        iState.moveUp(&iState);
+        break;
+      case 'D':
+        iState.moveDown(&iState);
+        break;
+    }
+  }
+  return iState;
+}
+
+Solver::Options_t manhattanOptions() {
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::MANHATTAN;
+  return aOptions;
+}
+
+//! \return the options of a pattern database of small partitions (quick to generate) saved on the file.
+Solver::Options_t customPatternsOptions(const char* iFileName) {
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::PATTERNS;
+  aOptions._patternPartitions = Solver::PatternPartitions::CUSTOM;
+  aOptions._customMaskPartitions = {
+      0x000000000000FFFF, 0x000000000FFF000F, 0x000000FFF000000F, 0x000FFF000000000F, 0xFFF000000000000F};
+  aOptions._fileNamePatternDB = iFileName;
+  aOptions._backgroundGeneration = false;
+  return aOptions;
+}
+
+//! \return the content of the file.
+std::string readFile(const char* iFileName) {
+  std::ifstream aFile(iFileName, std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(aFile), std::istreambuf_iterator<char>());
+}
+
+//! \brief How the explored nodes of a solver compare with the ones of the reference solver.
+enum class ExploredNodes { SAME, FEWER_OR_SAME, ANY };
+
+/*! \brief It solves the same states with both solvers: the solutions of the
+ *  solver must be valid and as long as the ones of the reference solver.
+ */
+void compareSolvers(const Solver& iSolverReference, const Solver& iSolver, const ExploredNodes iExploredNodes) {
+  for (int i = 0; i < 8; ++i) {
+    const State aState = generateNearState(i, 60);
+    const auto aSolutionReference = iSolverReference.solve(aState);
+    const auto aSolution = iSolver.solve(aState);
+
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_EQ(applySolution(aState, aSolution), State::generateSortedState());
+    ASSERT_EQ(aSolution._length, aSolutionReference._length);
+    if (iExploredNodes == ExploredNodes::SAME) {
+      ASSERT_EQ(aSolution._exploredNodes, aSolutionReference._exploredNodes);
+    } else if (iExploredNodes == ExploredNodes::FEWER_OR_SAME) {
+      ASSERT_LE(aSolution._exploredNodes, aSolutionReference._exploredNodes);
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(Solver, solveSorted) {
+  const Solver aSolver{manhattanOptions()};
+  ASSERT_EQ(aSolver.getHeuristicType(), Solver::HeuristicType::MANHATTAN);
+
+  const auto aSolution = aSolver.solve(State::generateSortedState());
+  ASSERT_TRUE(aSolution._solutionFound);
+  ASSERT_EQ(aSolution._length, 0);
+  ASSERT_EQ(aSolution._exploredNodes, 1);
+}
+
+TEST(Solver, solveMany) {
+  static constexpr int kNumTests = 32;
+  const Solver aSolver{manhattanOptions()};
+
+  for (int i = 0; i < kNumTests; ++i) {
+    const State aState = generateNearState(i);
+    const auto aSolution = aSolver.solve(aState);
+
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_LE(aSolution._length, 20);
+    ASSERT_EQ(applySolution(aState, aSolution), State::generateSortedState());
+  }
+}
+
+TEST(Solver, solveConcurrently) {
+  static constexpr int kNumThreads = 4;
+  static constexpr int kNumTestsPerThread = 8;
+  const Solver aSolver{manhattanOptions()};
+
+  std::vector<Solver::Solution_t> aExpected;
+  for (int i = 0; i < kNumThreads * kNumTestsPerThread; ++i) {
+    aExpected.push_back(aSolver.solve(generateNearState(i)));
+  }
+
+  std::vector<Solver::Solution_t> aSolutions(aExpected.size());
+  std::vector<std::thread> aThreads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    aThreads.emplace_back([&aSolver, &aSolutions, t]() {
+      for (int i = t; i < kNumThreads * kNumTestsPerThread; i += kNumThreads) {
+        aSolutions[i] = aSolver.solve(generateNearState(i));
+      }
+    });
+  }
+  for (auto& aThread : aThreads) aThread.join();
+
+  for (std::size_t i = 0; i < aExpected.size(); ++i) {
+    ASSERT_TRUE(aSolutions[i]._solutionFound);
+    ASSERT_EQ(aSolutions[i]._length, aExpected[i]._length);
+    ASSERT_EQ(aSolutions[i]._exploredNodes, aExpected[i]._exploredNodes);
+  }
+}
+
+TEST(Solver, invalidPatternDBFile) {
+  static constexpr const char* kFileName = "testSolverPatternDB.data";
+  std::remove(kFileName);
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  const Solver aSolver{aOptions};
+  const std::string aContent = readFile(kFileName);
+
+  // A file which cannot be loaded is generated again.
+  {
+    std::ofstream aFile(kFileName, std::ios_base::binary);
+    aFile << "Not a pattern database";
+  }
+  const Solver aSolverInvalid{aOptions};
+  ASSERT_TRUE(aSolverInvalid.isPatternDBReady());
+  ASSERT_EQ(readFile(kFileName), aContent);
+
+  // The files of the original format (sparse or dense tables) could overestimate the costs: they are generated again,
+  // read or mapped, even the ones with the partitions only in the file.
+  DynamicPatternDB aPatternDB{aOptions._customMaskPartitions};
+  aPatternDB.generate();
+  for (const bool aDenseTables : {false, true}) {
+    for (const bool aMappedPatternDB : {false, true}) {
+      for (const bool aMasksFromFile : {false, true}) {
+        {
+          std::ofstream aFile(kFileName, std::ios_base::binary);
+          aFile << serializeLegacyPatternDB(aPatternDB, aDenseTables);
+        }
+        Solver::Options_t aOptionsLegacy = aOptions;
+        aOptionsLegacy._mappedPatternDB = aMappedPatternDB;
+        if (aMasksFromFile) aOptionsLegacy._customMaskPartitions.clear();
+        const Solver aSolverLegacy{aOptionsLegacy};
+        ASSERT_TRUE(aSolverLegacy.isPatternDBReady());
+        ASSERT_EQ(readFile(kFileName), aContent);
+        ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverLegacy, ExploredNodes::SAME));
+      }
+    }
+  }
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, customPartitions) {
+  static constexpr const char* kFileName = "testSolverCustomPatternDB.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  const auto aMaskPartitions = aOptions._customMaskPartitions;
+
+  // Without masks and without file the partitions are unknown.
+  aOptions._customMaskPartitions.clear();
+  ASSERT_THROW(Solver{aOptions}, std::runtime_error);
+
+  aOptions._customMaskPartitions = aMaskPartitions;
+  const Solver aSolver{aOptions};
+  ASSERT_TRUE(aSolver.isPatternDBReady());
+
+  // The masks are read from the file generated.
+  aOptions._customMaskPartitions.clear();
+  const Solver aSolverFromFile{aOptions};
+  ASSERT_TRUE(aSolverFromFile.isPatternDBReady());
+
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverFromFile, ExploredNodes::SAME));
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, prefetch) {
+  static constexpr const char* kFileName = "testSolverPrefetch.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  const Solver aSolver{aOptions};
+
+  aOptions._prefetch = true;
+  aOptions._reflectedLookup = true;
+  const Solver aSolverPrefetch{aOptions};
+
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverPrefetch, ExploredNodes::FEWER_OR_SAME));
+  ASSERT_EQ(aSolverPrefetch.solve(generateNearState(0))._cacheMisses, -1);
+
+  // The cache misses are counted only on demand (-1 when the counters are not available).
+  aOptions._countCacheMisses = true;
+  const Solver aSolverCacheMisses{aOptions};
+  ASSERT_GE(aSolverCacheMisses.solve(generateNearState(0))._cacheMisses, -1);
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, reflectedAndDualLookup) {
+  static constexpr const char* kFileName = "testSolverReflectedAndDualLookup.data";
+  std::remove(kFileName);
+
+  // The optimal lengths are given by an independent heuristic.
+  Solver::Options_t aOptionsLinearConflict;
+  aOptionsLinearConflict._heuristicType = Solver::HeuristicType::MANHATTAN_LC;
+  const Solver aSolverLinearConflict{aOptionsLinearConflict};
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  for (const bool aReflectedLookup : {false, true}) {
+    for (const auto aDualLookup : {Solver::DualLookup::NONE, Solver::DualLookup::MAX, Solver::DualLookup::REPLACE}) {
+      SCOPED_TRACE(::testing::Message() << "reflected " << aReflectedLookup << ", dual "
+                                        << static_cast<int>(aDualLookup));
+      aOptions._reflectedLookup = aReflectedLookup;
+      aOptions._dualLookup = aDualLookup;
+      const Solver aSolver{aOptions};
+
+      ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolverLinearConflict, aSolver, ExploredNodes::ANY));
+
+      // The states on which a database overestimating the costs gave longer solutions.
+      for (const std::uint64_t aSeed : {20, 45, 61}) {
+        const State aState = generateNearState(aSeed, 140);
+        const auto aSolution = aSolver.solve(aState);
+
+        ASSERT_EQ(applySolution(aState, aSolution), State::generateSortedState());
+        ASSERT_EQ(aSolution._length, aSolverLinearConflict.solve(aState)._length);
+      }
+    }
+  }
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, backgroundGeneration) {
+  static constexpr const char* kFileName = "testSolverBackgroundPatternDB.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  aOptions._backgroundGeneration = true;
+  const Solver aSolverBackground{aOptions};
+
+  // While the database is generated the solutions are still optimal (with the Manhattan distance).
+  const Solver aSolverManhattan{manhattanOptions()};
+  for (int i = 0; i < 4; ++i) {
+    const State aState = generateNearState(i, 60);
+    const auto aSolution = aSolverBackground.solve(aState);
+
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_EQ(applySolution(aState, aSolution), State::generateSortedState());
+    ASSERT_EQ(aSolution._length, aSolverManhattan.solve(aState)._length);
+  }
+
+  static constexpr auto kTimeout = std::chrono::seconds(120);
+  const auto aDeadline = std::chrono::steady_clock::now() + kTimeout;
+  while (!aSolverBackground.isPatternDBReady() && std::chrono::steady_clock::now() < aDeadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(aSolverBackground.isPatternDBReady());
+
+  // Once ready the database is used: the same nodes are explored as with the database loaded from the file.
+  aOptions._backgroundGeneration = false;
+  const Solver aSolver{aOptions};
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverBackground, ExploredNodes::SAME));
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, generationMemoryLimit) {
+  static constexpr const char* kFileName = "testSolverExternalPatternDB.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  aOptions._generationMemoryLimit = 1 << 20;
+  const Solver aSolverExternal{aOptions};
+  ASSERT_TRUE(aSolverExternal.isPatternDBReady());
+  std::remove(kFileName);
+
+  aOptions._generationMemoryLimit = 0;
+  const Solver aSolver{aOptions};
+
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverExternal, ExploredNodes::SAME));
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, mappedPatternDB) {
+  static constexpr const char* kFileName = "testSolverMappedPatternDB.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  const Solver aSolver{aOptions};
+
+  // The file generated is mapped.
+  aOptions._mappedPatternDB = true;
+  const Solver aSolverMapped{aOptions};
+  ASSERT_TRUE(aSolverMapped.isPatternDBReady());
+
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverMapped, ExploredNodes::SAME));
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, maxLinearConflict) {
+  static constexpr const char* kFileName = "testSolverMaxLinearConflict.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions = customPatternsOptions(kFileName);
+  const Solver aSolver{aOptions};
+
+  aOptions._maxLinearConflict = true;
+  const Solver aSolverMax{aOptions};
+
+  ASSERT_NO_FATAL_FAILURE(compareSolvers(aSolver, aSolverMax, ExploredNodes::FEWER_OR_SAME));
+
+  // Until the database generated in background is ready (here never: it cannot be saved), the linear conflicts are
+  // combined with the Manhattan distance.
+  aOptions._fileNamePatternDB = "testSolverMaxLinearConflict/missing.data";
+  aOptions._backgroundGeneration = true;
+  const Solver aSolverMaxBackground{aOptions};
+
+  Solver::Options_t aOptionsLinearConflict;
+  aOptionsLinearConflict._heuristicType = Solver::HeuristicType::MANHATTAN_LC;
+  const Solver aSolverLinearConflict{aOptionsLinearConflict};
+
+  for (int i = 0; i < 8; ++i) {
+    const State aState = generateNearState(i, 60);
+    const auto aSolutionMax = aSolverMaxBackground.solve(aState);
+
+    ASSERT_FALSE(aSolverMaxBackground.isPatternDBReady());
+    ASSERT_TRUE(aSolutionMax._solutionFound);
+    ASSERT_EQ(aSolutionMax._exploredNodes, aSolverLinearConflict.solve(aState)._exploredNodes);
+  }
+
+  std::remove(kFileName);
+}
+
+TEST(Solver, lazyGeneration) {
+  static constexpr const char* kFileName = "testSolverLazyPatternDB.data";
+  std::remove(kFileName);
+
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::PATTERNS;
+  aOptions._fileNamePatternDB = kFileName;
+  aOptions._lazyGeneration = true;
+  const Solver aSolver{aOptions};
+  ASSERT_TRUE(aSolver.isPatternDBReady());
+
+  const Solver aSolverManhattan{manhattanOptions()};
+  for (int i = 0; i < 8; ++i) {
+    const State aState = generateNearState(i);
+    const auto aSolution = aSolver.solve(aState);
+
+    ASSERT_TRUE(aSolution._solutionFound);
+    ASSERT_EQ(applySolution(aState, aSolution), State::generateSortedState());
+    ASSERT_EQ(aSolution._length, aSolverManhattan.solve(aState)._length);
+  }
+
+  // Nothing is saved.
+  ASSERT_TRUE(std::ifstream(kFileName).fail());
+}
+
+}  // namespace kpuzzle4::testing
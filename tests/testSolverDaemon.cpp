@@ -0,0 +1,275 @@
+/*
+  Copyright (C) 2018  Biagio Festa
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <gtest/gtest.h>
+#include <SolverDaemon.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace kpuzzle4::testing {
+
+namespace {
+
+Solver::Options_t manhattanOptions() {
+  Solver::Options_t aOptions;
+  aOptions._heuristicType = Solver::HeuristicType::MANHATTAN;
+  return aOptions;
+}
+
+#ifndef _WIN32
+
+//! \return a client connected to the socket (the daemon may be starting), -1 in case of failure.
+int connectClient(const char* iSocketPath) {
+  sockaddr_un aAddress = {};
+  aAddress.sun_family = AF_UNIX;
+  std::strcpy(aAddress.sun_path, iSocketPath);
+
+  for (int i = 0; i < 100; ++i) {
+    const int aClient = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (aClient == -1) return -1;
+    if (::connect(aClient, reinterpret_cast<const sockaddr*>(&aAddress), sizeof(aAddress)) == 0) {
+      // A test waiting for a response fails rather than hanging.
+      const timeval aTimeout = {10, 0};
+      ::setsockopt(aClient, SOL_SOCKET, SO_RCVTIMEO, &aTimeout, sizeof(aTimeout));
+      return aClient;
+    }
+    ::close(aClient);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return -1;
+}
+
+//! \return the responses to the requests (one per line), empty in case of failure.
+std::string sendRequests(const int iClient, const std::string& iRequests) {
+  if (::send(iClient, iRequests.data(), iRequests.size(), 0) != static_cast<ssize_t>(iRequests.size())) return {};
+
+  std::string aResponses;
+  char aBuffer[256];
+  while (std::count(aResponses.begin(), aResponses.end(), '\n') <
+         std::count(iRequests.begin(), iRequests.end(), '\n')) {
+    const auto aReceived = ::recv(iClient, aBuffer, sizeof(aBuffer), 0);
+    if (aReceived <= 0) return {};
+    aResponses.append(aBuffer, static_cast<std::size_t>(aReceived));
+  }
+  return aResponses;
+}
+
+#endif
+
+}  // anonymous namespace
+
+TEST(SolverDaemon, processRequestSorted) {
+  const Solver aSolver{manhattanOptions()};
+  const SolverDaemon aSolverDaemon{aSolver, "", 1};
+
+  const std::string aResponse = aSolverDaemon.processRequest("1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,0");
+  ASSERT_EQ(aResponse.rfind("OK 0 - 1 ", 0), 0) << aResponse;
+}
+
+TEST(SolverDaemon, processRequestTwoSteps) {
+  const Solver aSolver{manhattanOptions()};
+  const SolverDaemon aSolverDaemon{aSolver, "", 1};
+
+  const std::string aResponse = aSolverDaemon.processRequest("1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15");
+  ASSERT_EQ(aResponse.rfind("OK 1 R ", 0), 0) << aResponse;
+}
+
+TEST(SolverDaemon, processRequestInvalid) {
+  const Solver aSolver{manhattanOptions()};
+  const SolverDaemon aSolverDaemon{aSolver, "", 1};
+
+  const char* aInvalidRequests[] = {
+      "",
+      "1,2,3",
+      "hello",
+      "1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,0,1",
+      "1,2,3,4,5,6,7,8,9,10,11,12,13,14,16,0",
+      "1,1,3,4,5,6,7,8,9,10,11,12,13,14,15,0",
+      "2,1,3,4,5,6,7,8,9,10,11,12,13,14,15,0"};
+
+  for (const char* aRequest : aInvalidRequests) {
+    const std::string aResponse = aSolverDaemon.processRequest(aRequest);
+    ASSERT_EQ(aResponse.rfind("ERROR ", 0), 0) << aRequest;
+  }
+}
+
+TEST(SolverDaemon, processRequestCached) {
+  static constexpr const char* kFileName = "testSolverDaemonCache.data";
+  static constexpr const char* kRequest = "5,1,2,3,9,6,7,4,13,10,11,8,0,14,15,12";
+  std::remove(kFileName);
+
+  const Solver aSolver{manhattanOptions()};
+  std::string aSolutionMoves;
+  {
+    SolutionCache aSolutionCache{kFileName};
+    const SolverDaemon aSolverDaemon{aSolver, "", 1, &aSolutionCache};
+
+    // OK <length> <moves> <explored nodes> <time ms>
+    std::istringstream aResponse(aSolverDaemon.processRequest(kRequest));
+    std::string aStatus, aLength, aMoves;
+    long long aExploredNodes;
+    aResponse >> aStatus >> aLength >> aMoves >> aExploredNodes;
+    ASSERT_EQ(aStatus, "OK");
+    ASSERT_GT(aExploredNodes, 0);
+    ASSERT_EQ(aSolutionCache.getSize(), 1);
+    aSolutionMoves = aLength + ' ' + aMoves;
+  }
+
+  // The solution is found in the cache (even the one of another daemon): no node is explored.
+  SolutionCache aSolutionCache{kFileName};
+  const SolverDaemon aSolverDaemon{aSolver, "", 1, &aSolutionCache};
+  ASSERT_EQ(aSolverDaemon.processRequest(kRequest), "OK " + aSolutionMoves + " 0 0");
+  std::remove(kFileName);
+}
+
+#ifndef _WIN32
+
+TEST(SolverDaemon, serveOnSocket) {
+  static constexpr const char* kSocketPath = "testSolverDaemon.sock";
+
+  const Solver aSolver{manhattanOptions()};
+  SolverDaemon aSolverDaemon{aSolver, kSocketPath, 2};
+  std::thread aDaemonThread(&SolverDaemon::run, &aSolverDaemon);
+
+  const int aClient = connectClient(kSocketPath);
+  ASSERT_NE(aClient, -1);
+
+  const std::string aResponses = sendRequests(aClient,
+                                              "1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15\n"
+                                              "1,2,3\n");
+  ::close(aClient);
+
+  aSolverDaemon.stop();
+  aDaemonThread.join();
+
+  const auto aEndFirstLine = aResponses.find('\n');
+  ASSERT_EQ(aResponses.rfind("OK 1 R ", 0), 0) << aResponses;
+  ASSERT_EQ(aResponses.find("ERROR ", aEndFirstLine), aEndFirstLine + 1) << aResponses;
+}
+
+TEST(SolverDaemon, idleClients) {
+  static constexpr const char* kSocketPath = "testSolverDaemonIdle.sock";
+  static constexpr const char* kRequest = "1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15\n";
+
+  const Solver aSolver{manhattanOptions()};
+  SolverDaemon aSolverDaemon{aSolver, kSocketPath, 1};
+  std::thread aDaemonThread(&SolverDaemon::run, &aSolverDaemon);
+
+  // The only worker is not held by the clients connected and idle, even with a partial request.
+  const int aClientIdle = connectClient(kSocketPath);
+  const int aClientPartial = connectClient(kSocketPath);
+  const int aClient = connectClient(kSocketPath);
+  ASSERT_NE(aClientIdle, -1);
+  ASSERT_NE(aClientPartial, -1);
+  ASSERT_NE(aClient, -1);
+  ASSERT_EQ(::send(aClientPartial, kRequest, 10, 0), 10);
+  std::this_thread::sleep_for(SolverDaemon::kPollPeriod * 2);
+
+  const std::string aResponse = sendRequests(aClient, kRequest);
+  const std::string aResponseIdle = sendRequests(aClientIdle, std::string(kRequest) + kRequest);
+  const std::string aResponsePartial = sendRequests(aClientPartial, kRequest + 10);
+
+  ::close(aClientIdle);
+  ::close(aClientPartial);
+  ::close(aClient);
+  aSolverDaemon.stop();
+  aDaemonThread.join();
+
+  ASSERT_EQ(aResponse.rfind("OK 1 R ", 0), 0) << aResponse;
+  ASSERT_EQ(std::count(aResponseIdle.begin(), aResponseIdle.end(), 'R'), 2) << aResponseIdle;
+  ASSERT_EQ(aResponsePartial.rfind("OK 1 R ", 0), 0) << aResponsePartial;
+}
+
+TEST(SolverDaemon, socketInUse) {
+  static constexpr const char* kSocketPath = "testSolverDaemonInUse.sock";
+
+  const Solver aSolver{manhattanOptions()};
+  SolverDaemon aSolverDaemon{aSolver, kSocketPath, 1};
+  std::thread aDaemonThread(&SolverDaemon::run, &aSolverDaemon);
+  const int aClient = connectClient(kSocketPath);
+  ASSERT_NE(aClient, -1);
+
+  // The socket of a running daemon is not taken over.
+  SolverDaemon aSolverDaemonOther{aSolver, kSocketPath, 1};
+  ASSERT_THROW(aSolverDaemonOther.run(), std::runtime_error);
+
+  const int aClientNew = connectClient(kSocketPath);
+  ASSERT_NE(aClientNew, -1);
+  const std::string aResponse = sendRequests(aClientNew, "1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15\n");
+  ::close(aClientNew);
+  ::close(aClient);
+  aSolverDaemon.stop();
+  aDaemonThread.join();
+
+  ASSERT_EQ(aResponse.rfind("OK 1 R ", 0), 0) << aResponse;
+}
+
+TEST(SolverDaemon, socketStale) {
+  static constexpr const char* kSocketPath = "testSolverDaemonStale.sock";
+  ::unlink(kSocketPath);
+
+  // A socket bound and closed, as left by a daemon killed.
+  sockaddr_un aAddress = {};
+  aAddress.sun_family = AF_UNIX;
+  std::strcpy(aAddress.sun_path, kSocketPath);
+  const int aStale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(::bind(aStale, reinterpret_cast<const sockaddr*>(&aAddress), sizeof(aAddress)), 0);
+  ::close(aStale);
+
+  const Solver aSolver{manhattanOptions()};
+  SolverDaemon aSolverDaemon{aSolver, kSocketPath, 1};
+  std::thread aDaemonThread(&SolverDaemon::run, &aSolverDaemon);
+  const int aClient = connectClient(kSocketPath);
+  ASSERT_NE(aClient, -1);
+  const std::string aResponse = sendRequests(aClient, "1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,15\n");
+  ::close(aClient);
+  aSolverDaemon.stop();
+  aDaemonThread.join();
+
+  ASSERT_EQ(aResponse.rfind("OK 1 R ", 0), 0) << aResponse;
+}
+
+TEST(SolverDaemon, socketPathNotSocket) {
+  static constexpr const char* kSocketPath = "testSolverDaemonNotSocket.sock";
+  std::ofstream(kSocketPath) << "not a socket";
+
+  const Solver aSolver{manhattanOptions()};
+  SolverDaemon aSolverDaemon{aSolver, kSocketPath, 1};
+  ASSERT_THROW(aSolverDaemon.run(), std::runtime_error);
+
+  std::string aContent;
+  std::getline(std::ifstream(kSocketPath), aContent);
+  ASSERT_EQ(aContent, "not a socket");
+  ::unlink(kSocketPath);
+}
+
+#endif
+
+}  // namespace kpuzzle4::testing
@@ -189,4 +189,75 @@ TEST(State, hashWithMaskDifferent) {
   ASSERT_NE(aStateA.getHashWithMask(kMask), aStateB.getHashWithMask(kMask));
 }
 
+TEST(State, transposedSorted) {
+  static constexpr State kSortedState = State::generateSortedState();
+  static constexpr State kTransposedState = kSortedState.getTransposedState();
+
+  ASSERT_EQ(kTransposedState, kSortedState);
+}
+
+TEST(State, transposedInvolution) {
+  static constexpr int kNumRandomToTry = 1024;
+
+  for (int i = 0; i < kNumRandomToTry; ++i) {
+    const State kRandomState = State::generateValidRandState(i);
+    const State kTransposedState = kRandomState.getTransposedState();
+
+    ASSERT_TRUE(kTransposedState.isValid());
+    ASSERT_TRUE(kTransposedState.isSolveable());
+    ASSERT_EQ(kTransposedState.getTransposedState(), kRandomState);
+  }
+}
+
+TEST(State, transposedMoves) {
+  const State aState = State{0xfedcba9876543210};
+  const State aTransposedState = aState.getTransposedState();
+
+  State aNewState;
+  State aNewTransposedState;
+  ASSERT_NE(aState.moveRight(&aNewState), -1);
+  ASSERT_NE(aTransposedState.moveDown(&aNewTransposedState), -1);
+  ASSERT_EQ(aNewState.getTransposedState(), aNewTransposedState);
+
+  ASSERT_NE(aState.moveDown(&aNewState), -1);
+  ASSERT_NE(aTransposedState.moveRight(&aNewTransposedState), -1);
+  ASSERT_EQ(aNewState.getTransposedState(), aNewTransposedState);
+}
+
+TEST(State, dualSorted) {
+  static constexpr State kSortedState = State::generateSortedState();
+  static constexpr State kDualState = kSortedState.getDualState();
+
+  ASSERT_EQ(kDualState, kSortedState);
+}
+
+TEST(State, dualInvolution) {
+  static constexpr int kNumRandomToTry = 1024;
+
+  for (int i = 0; i < kNumRandomToTry; ++i) {
+    State aRandomState = State::generateValidRandState(i);
+    const State kDualState = aRandomState.getDualState();
+
+    ASSERT_TRUE(kDualState.isValid());
+    ASSERT_EQ(kDualState.getDualState(), aRandomState);
+
+    // Space tile in its goal position.
+    while (aRandomState.moveRight(&aRandomState) != -1) {
+    }
+    while (aRandomState.moveDown(&aRandomState) != -1) {
+    }
+    ASSERT_EQ(aRandomState.getIndexSpace(), State::kNumTilesMinusOne);
+    ASSERT_TRUE(aRandomState.getDualState().isSolveable());
+    ASSERT_EQ(aRandomState.getDualState().getIndexSpace(), State::kNumTilesMinusOne);
+  }
+}
+
+TEST(State, dualOneMove) {
+  State aState;
+  ASSERT_NE(State::generateSortedState().moveLeft(&aState), -1);
+
+  // Swapping the blank and the tile 15 is its own inverse.
+  ASSERT_EQ(aState.getDualState(), aState);
+}
+
 }  // namespace kpuzzle4::testing